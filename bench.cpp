@@ -0,0 +1,575 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "bench.h"
+#include "console.h"
+#include "dpi.h"
+#include "edges.h"
+#include "elements.h"
+#include "filters.h"
+#include "flicker.h"
+#include "regsettings.h"
+#include "scaler.h"
+#include "search.h"
+#include "threadpool.h"
+
+typedef std::chrono::steady_clock clock_type;
+
+static double SecondsSince(const clock_type::time_point& start)
+{
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+//------------------------------------------------------------------------------
+// Scaler:  frame time of ScaleTiled for an 8K client area, from 1 to N threads.
+// tests/scaler_test.cpp checks that it matches ScaleReference.
+
+static void BenchScaler()
+{
+    constexpr int32_t c_cx = 7680;
+    constexpr int32_t c_cy = 4320;
+    constexpr double c_min_seconds = 0.5;
+    static const struct { int32_t factor; SubpixelOrder subpixels; } c_factors[] =
+    {
+        { 1, SO_NONE }, { 2, SO_NONE }, { 4, SO_NONE }, { 8, SO_NONE },
+        { 6, SO_NONE }, { 6, SO_RGB }, { 12, SO_NONE }, { 12, SO_RGB },
+    };
+
+    std::vector<uint32_t> source(c_cx * c_cy);
+    std::vector<uint32_t> target(c_cx * c_cy);
+    uint32_t seed = 0x2468ace1;
+    for (auto& pixel : source)
+    {
+        seed = seed * 1664525 + 1013904223;
+        pixel = seed >> 8;
+    }
+
+    ThreadPool* const pool = ThreadPool::GetShared();
+    const unsigned max_threads = pool->GetThreadCount();
+
+    ConsolePrintf(L"Scaler:  %dx%d target, %u threads available.\n\n", c_cx, c_cy, max_threads);
+    ConsolePrintf(L"factor  threads  ms/frame      fps  speedup  (s = subpixel stripes)\n");
+
+    for (const auto& entry : c_factors)
+    {
+        const int32_t factor = entry.factor;
+        PixelSource src;
+        src.bits = source.data();
+        src.stride = c_cx;
+        src.cx = (c_cx + factor - 1) / factor;
+        src.cy = (c_cy + factor - 1) / factor;
+
+        PixelTarget dst;
+        dst.bits = target.data();
+        dst.stride = c_cx;
+        dst.cx = c_cx;
+        dst.cy = c_cy;
+
+        ScaleParams params;
+        params.factor = factor;
+        params.gridline_color = 0x000000;
+        params.subpixels = entry.subpixels;
+        if (factor > 1)
+            params.gridlines[0].interval = factor;
+        if (factor > 2)
+        {
+            params.gridlines[1].interval = factor * 8;
+            params.gridlines[1].thick = 2;
+        }
+
+        double base = 0;
+        for (unsigned threads = 1; threads <= max_threads; ++threads)
+        {
+            ScaleTiled(pool, src, dst, params, threads);  // Warm up.
+
+            unsigned frames = 0;
+            const clock_type::time_point start = clock_type::now();
+            double elapsed;
+            do
+            {
+                ScaleTiled(pool, src, dst, params, threads);
+                ++frames;
+                elapsed = SecondsSince(start);
+            }
+            while (elapsed < c_min_seconds);
+
+            const double ms = elapsed * 1000 / frames;
+            if (threads == 1)
+                base = ms;
+            ConsolePrintf(L"%5d%c  %7u  %8.2f  %7.1f  %6.2fx\n", factor, entry.subpixels ? L's' : L' ', threads, ms, 1000 / ms, base / ms);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Flicker:  frame time of updating the flicker counters and compositing the
+// overlay, for zoom areas from a small window up to a 4K window at 1x.
+
+static void BenchFlicker()
+{
+    constexpr double c_min_seconds = 0.5;
+    static const SIZE c_sizes[] = { { 240, 160 }, { 960, 540 }, { 1920, 1080 }, { 3840, 2160 } };
+
+    ConsolePrintf(L"Flicker:  every 7th pixel changes each frame.\n\n");
+    ConsolePrintf(L"     zoom area  ms/frame      fps\n");
+
+    for (const SIZE& size : c_sizes)
+    {
+        std::vector<uint32_t> frames[2];
+        frames[0].resize(size.cx * size.cy);
+        frames[1].resize(size.cx * size.cy);
+        for (size_t ii = 0; ii < frames[0].size(); ++ii)
+        {
+            frames[0][ii] = uint32_t(ii * 2654435761u) >> 8;
+            frames[1][ii] = (ii % 7) ? frames[0][ii] : ~frames[0][ii];
+        }
+
+        PixelSource src;
+        src.stride = size.cx;
+        src.cx = size.cx;
+        src.cy = size.cy;
+
+        FlickerTracker tracker;
+        PixelSource overlay;
+        src.bits = frames[1].data();
+        tracker.Update(src, 0, 0);      // Warm up.
+
+        unsigned frames_done = 0;
+        const clock_type::time_point start = clock_type::now();
+        double elapsed;
+        do
+        {
+            src.bits = frames[frames_done & 1].data();
+            tracker.Update(src, 0, 0);
+            tracker.GetOverlay(src, 0, 0, overlay);
+            ++frames_done;
+            elapsed = SecondsSince(start);
+        }
+        while (elapsed < c_min_seconds);
+
+        const double ms = elapsed * 1000 / frames_done;
+        ConsolePrintf(L"%6dx%-6d  %9.3f  %7.1f\n", size.cx, size.cy, ms, 1000 / ms);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Search:  time to search a 4K monitor for a 16x16 template, exact and
+// approximate.  tests/search_test.cpp checks that FindTemplate matches
+// FindTemplateReference.
+
+static void BenchSearch()
+{
+    constexpr double c_min_seconds = 0.5;
+
+    const int32_t cx = 3840;
+    const int32_t cy = 2160;
+    std::vector<uint32_t> haystack(cx * cy);
+    for (size_t ii = 0; ii < haystack.size(); ++ii)
+        haystack[ii] = uint32_t(ii * 2654435761u) >> 8;
+    std::vector<uint32_t> needle(16 * 16);
+    for (int32_t yy = 0; yy < 16; ++yy)
+        memcpy(&needle[yy * 16], &haystack[(1000 + yy) * cx + 2000], 16 * sizeof(uint32_t));
+
+    PixelSource src;
+    src.bits = haystack.data();
+    src.stride = src.cx = cx;
+    src.cy = cy;
+    PixelSource tmpl;
+    tmpl.bits = needle.data();
+    tmpl.stride = tmpl.cx = 16;
+    tmpl.cy = 16;
+
+    ConsolePrintf(L"Search:  16x16 template in a %dx%d image.\n\n", cx, cy);
+    ConsolePrintf(L"tolerance  matches  ms/search\n");
+    for (const uint8_t tolerance : { uint8_t(0), uint8_t(16) })
+    {
+        std::vector<SearchMatch> matches;
+        unsigned searches = 0;
+        const clock_type::time_point start = clock_type::now();
+        double elapsed;
+        do
+        {
+            FindTemplate(ThreadPool::GetShared(), src, tmpl, tolerance, 1000, matches);
+            ++searches;
+            elapsed = SecondsSince(start);
+        }
+        while (elapsed < c_min_seconds);
+
+        ConsolePrintf(L"%9u  %7u  %9.3f\n", unsigned(tolerance), unsigned(matches.size()), elapsed * 1000 / searches);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Edges:  time to build the edge map for zoom areas from a small window up to a
+// 4K window at 1x.  tests/edges_test.cpp checks that snapped rulers measure
+// boxes exactly.
+
+static void BenchEdges()
+{
+    constexpr double c_min_seconds = 0.5;
+    static const SIZE c_sizes[] = { { 240, 160 }, { 960, 540 }, { 1920, 1080 }, { 3840, 2160 } };
+
+    ConsolePrintf(L"Edges:  building the edge map of a noisy frame.\n\n");
+
+    ConsolePrintf(L"     zoom area  ms/frame\n");
+    for (const SIZE& size : c_sizes)
+    {
+        std::vector<uint32_t> pixels(size.cx * size.cy);
+        for (size_t ii = 0; ii < pixels.size(); ++ii)
+            pixels[ii] = uint32_t(ii * 2654435761u) >> 8;
+
+        PixelSource src;
+        src.bits = pixels.data();
+        src.stride = src.cx = size.cx;
+        src.cy = size.cy;
+
+        EdgeMap edges;
+        unsigned frames_done = 0;
+        const clock_type::time_point start = clock_type::now();
+        double elapsed;
+        do
+        {
+            edges.Build(src, 0, 0);
+            ++frames_done;
+            elapsed = SecondsSince(start);
+        }
+        while (elapsed < c_min_seconds);
+
+        ConsolePrintf(L"%6dx%-6d  %9.3f\n", size.cx, size.cy, elapsed * 1000 / frames_done);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Elements:  time to find the elements in zoom areas from a small window up to
+// a 4K window at 1x.  tests/elements_test.cpp checks that boxes are found
+// exactly.
+
+static void BenchElements()
+{
+    constexpr double c_min_seconds = 0.5;
+    static const SIZE c_sizes[] = { { 240, 160 }, { 960, 540 }, { 1920, 1080 }, { 3840, 2160 } };
+
+    ConsolePrintf(L"Elements:  a checkerboard of 37x23 cells, with scattered dots.\n\n");
+    ConsolePrintf(L"     zoom area  ms/frame\n");
+    for (const SIZE& size : c_sizes)
+    {
+        std::vector<uint32_t> pixels(size.cx * size.cy);
+        for (int32_t yy = 0; yy < size.cy; ++yy)
+        {
+            for (int32_t xx = 0; xx < size.cx; ++xx)
+            {
+                const bool dot = ((xx * 7 + yy * 3) % 11 == 0);
+                pixels[yy * size.cx + xx] = ((xx / 37 + yy / 23) & 1) ? 0xffffff : dot ? 0x101010 : 0xe0e0e0;
+            }
+        }
+
+        PixelSource src;
+        src.bits = pixels.data();
+        src.stride = src.cx = size.cx;
+        src.cy = size.cy;
+
+        ElementFinder finder;
+        unsigned frames_done = 0;
+        const clock_type::time_point start = clock_type::now();
+        double elapsed;
+        do
+        {
+            finder.Find(src, 0, 0);
+            ++frames_done;
+            elapsed = SecondsSince(start);
+        }
+        while (elapsed < c_min_seconds);
+
+        ConsolePrintf(L"%6dx%-6d  %9.3f\n", size.cx, size.cy, elapsed * 1000 / frames_done);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Filters:  time to filter zoom areas from a small window up to a 4K window at
+// 1x through one filter and through five, after checking that random chains of
+// filters match applying each filter in turn, one pixel at a time.
+
+static void BenchFilters()
+{
+    constexpr double c_min_seconds = 0.5;
+    static const SIZE c_sizes[] = { { 240, 160 }, { 960, 540 }, { 1920, 1080 }, { 3840, 2160 } };
+    static const FilterStep c_chain[c_max_filters] =
+    {
+        { FK_GAMMA, 180 },
+        { FK_DEUTERANOPIA, 0 },
+        { FK_INVERT, 0 },
+        { FK_GRAYSCALE, 0 },
+        { FK_THRESHOLD, 100 },
+    };
+
+    unsigned mismatches = 0;
+    uint32_t seed = 1;
+    auto random = [&]() { seed = seed * 1664525 + 1013904223; return seed >> 8; };
+    for (unsigned trial = 0; trial < 300; ++trial)
+    {
+        const size_t count = 1 + random() % c_max_filters;
+        FilterStep steps[c_max_filters];
+        for (size_t ii = 0; ii < count; ++ii)
+        {
+            steps[ii].kind = FilterKind(random() % FK_COUNT);
+            steps[ii].param = ClampFilterParam(steps[ii].kind, random() % 1000);
+        }
+
+        // Odd lengths exercise the tails, and long ones span several chunks.
+        const int32_t cx = 1 + random() % 1000;
+        std::vector<uint32_t> pixels(cx);
+        for (uint32_t& p : pixels)
+            p = (random() << 8) ^ random();
+
+        FilterPipeline pipeline;
+        pipeline.Compile(steps, count);
+        std::vector<uint32_t> fused(cx);
+        pipeline.ApplyRow(pixels.data(), cx, fused.data());
+
+        std::vector<uint32_t> expected(pixels);
+        std::vector<uint32_t> temp(cx);
+        for (size_t ii = 0; ii < count; ++ii)
+        {
+            ApplyFilterReference(steps[ii], expected.data(), cx, temp.data());
+            expected.swap(temp);
+        }
+        if (fused != expected)
+            ++mismatches;
+    }
+    ConsolePrintf(L"Filters:  %u mismatches in 300 random chains.\n\n", mismatches);
+
+    ConsolePrintf(L"     zoom area  1 filter  5 filters  (ms/frame)\n");
+    for (const SIZE& size : c_sizes)
+    {
+        std::vector<uint32_t> pixels(size.cx * size.cy);
+        for (uint32_t& p : pixels)
+            p = (random() << 8) ^ random();
+
+        PixelSource src;
+        src.bits = pixels.data();
+        src.stride = src.cx = size.cx;
+        src.cy = size.cy;
+
+        double ms[2];
+        for (size_t ii = 0; ii < _countof(ms); ++ii)
+        {
+            FilterPipeline pipeline;
+            pipeline.Compile(c_chain, ii ? c_max_filters : 1);
+            std::vector<uint32_t> filtered;
+            PixelSource out;
+            unsigned frames_done = 0;
+            const clock_type::time_point start = clock_type::now();
+            double elapsed;
+            do
+            {
+                pipeline.Apply(src, filtered, out);
+                ++frames_done;
+                elapsed = SecondsSince(start);
+            }
+            while (elapsed < c_min_seconds);
+            ms[ii] = elapsed * 1000 / frames_done;
+        }
+
+        ConsolePrintf(L"%6dx%-6d  %8.3f  %9.3f\n", size.cx, size.cy, ms[0], ms[1]);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Dpi:  DpiScaler versus HIDPIMulDiv, after checking that they agree for every
+// value in +/-c_range at each pair of DPIs from 96 to 480 in steps of 24.
+
+static void BenchDpi()
+{
+    constexpr int c_range = 65536;
+    constexpr int c_iterations = 200;
+    static const WORD c_dpis[] = { 96, 120, 144, 168, 192, 288, 432 };
+
+    unsigned mismatches = 0;
+    for (int from = 96; from <= 480; from += 24)
+    {
+        const DpiScaler dpiFrom(static_cast<WORD>(from));
+        for (int to = 96; to <= 480; to += 24)
+        {
+            const DpiScaler dpiTo(static_cast<WORD>(to));
+            for (int n = -c_range; n <= c_range; ++n)
+            {
+                if (dpiFrom.Scale(n) != HIDPIMulDiv(n, from, 96) ||
+                    dpiFrom.ScaleTo(n, dpiTo) != HIDPIMulDiv(n, to, from) ||
+                    dpiFrom.ScaleFrom(n, dpiTo) != HIDPIMulDiv(n, from, to))
+                    ++mismatches;
+            }
+        }
+    }
+
+    ConsolePrintf(L"Dpi:  %u mismatches against HIDPIMulDiv.\n\n", mismatches);
+    ConsolePrintf(L"  dpi  HIDPIMulDiv ns/op  DpiScaler ns/op  speedup\n");
+
+    for (const WORD dpi : c_dpis)
+    {
+        const DpiScaler scaler(dpi);
+        volatile int sink = 0;
+
+        clock_type::time_point start = clock_type::now();
+        for (int ii = 0; ii < c_iterations; ++ii)
+        {
+            int sum = 0;
+            for (int n = -c_range; n < c_range; ++n)
+                sum += HIDPIMulDiv(n, 96, dpi) + HIDPIMulDiv(n, dpi, 96);
+            sink = sink + sum;
+        }
+        const double slow = SecondsSince(start);
+
+        start = clock_type::now();
+        for (int ii = 0; ii < c_iterations; ++ii)
+        {
+            int sum = 0;
+            for (int n = -c_range; n < c_range; ++n)
+                sum += scaler.ScaleTo(n, 96) + scaler.Scale(n);
+            sink = sink + sum;
+        }
+        const double fast = SecondsSince(start);
+
+        const double ops = 2.0 * 2 * c_range * c_iterations;
+        ConsolePrintf(L"%5u  %18.2f  %15.2f  %6.2fx\n", dpi, slow * 1e9 / ops, fast * 1e9 / ops, slow / fast);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Settings:  loading and saving c_count values one registry call at a time,
+// versus in one batch via Settings, using a scratch registry key and file.
+
+static void BenchSettings()
+{
+    constexpr unsigned c_count = 24;
+    constexpr unsigned c_iterations = 200;
+    static const WCHAR c_subkey[] = L"Software\\chrisant996\\Zoomin\\Benchmark";
+
+    WCHAR names[c_count][16];
+    for (unsigned ii = 0; ii < c_count; ++ii)
+        _snwprintf(names[ii], _countof(names[ii]), L"Value%u", ii);
+
+    double perValue = 0;
+    {
+        const clock_type::time_point start = clock_type::now();
+        for (unsigned iter = 0; iter < c_iterations; ++iter)
+        {
+            for (unsigned ii = 0; ii < c_count; ++ii)
+            {
+                HKEY hkey;
+                if (ERROR_SUCCESS == RegCreateKey(HKEY_CURRENT_USER, c_subkey, &hkey))
+                {
+                    const LONG value = LONG(iter + ii);
+                    RegSetValueEx(hkey, names[ii], 0, REG_DWORD, reinterpret_cast<const BYTE*>(&value), sizeof(value));
+                    RegCloseKey(hkey);
+                }
+            }
+            for (unsigned ii = 0; ii < c_count; ++ii)
+            {
+                HKEY hkey;
+                if (ERROR_SUCCESS == RegOpenKey(HKEY_CURRENT_USER, c_subkey, &hkey))
+                {
+                    DWORD type;
+                    LONG value;
+                    DWORD cb = sizeof(value);
+                    RegQueryValueEx(hkey, names[ii], 0, &type, reinterpret_cast<BYTE*>(&value), &cb);
+                    RegCloseKey(hkey);
+                }
+            }
+        }
+        perValue = SecondsSince(start);
+    }
+
+    auto batched = [&](std::unique_ptr<SettingsBackend>&& backend)
+    {
+        Settings settings(std::move(backend));
+        const clock_type::time_point start = clock_type::now();
+        for (unsigned iter = 0; iter < c_iterations; ++iter)
+        {
+            settings.Load();
+            for (unsigned ii = 0; ii < c_count; ++ii)
+                settings.SetLong(names[ii], settings.GetLong(names[ii], 0) + 1);
+            settings.Save();
+        }
+        return SecondsSince(start);
+    };
+
+    const double registry = batched(std::unique_ptr<SettingsBackend>(new RegistrySettingsBackend(HKEY_CURRENT_USER, c_subkey)));
+    RegDeleteTree(HKEY_CURRENT_USER, c_subkey);
+
+    WCHAR path[MAX_PATH];
+    double file = 0;
+    const DWORD len = GetTempPath(_countof(path), path);
+    if (len && len + 32 < _countof(path))
+    {
+        wcscat(path, L"Zoomin.bench.settings");
+        file = batched(std::unique_ptr<SettingsBackend>(new FileSettingsBackend(path)));
+        DeleteFile(path);
+    }
+
+    ConsolePrintf(L"Settings:  load and save %u values, %u iterations.\n\n", c_count, c_iterations);
+    ConsolePrintf(L"backend                 ms/iteration\n");
+    ConsolePrintf(L"registry, per value     %12.3f\n", perValue * 1000 / c_iterations);
+    ConsolePrintf(L"registry, batched       %12.3f\n", registry * 1000 / c_iterations);
+    if (file)
+        ConsolePrintf(L"file, batched           %12.3f\n", file * 1000 / c_iterations);
+}
+
+//------------------------------------------------------------------------------
+// RunBenchmark.
+
+int RunBenchmark(const WCHAR* name)
+{
+    if (!AttachConsoleOutput())
+        return 1;
+
+    if (!_wcsicmp(name, L"scaler"))
+    {
+        BenchScaler();
+        return 0;
+    }
+    if (!_wcsicmp(name, L"flicker"))
+    {
+        BenchFlicker();
+        return 0;
+    }
+    if (!_wcsicmp(name, L"search"))
+    {
+        BenchSearch();
+        return 0;
+    }
+    if (!_wcsicmp(name, L"edges"))
+    {
+        BenchEdges();
+        return 0;
+    }
+    if (!_wcsicmp(name, L"elements"))
+    {
+        BenchElements();
+        return 0;
+    }
+    if (!_wcsicmp(name, L"filters"))
+    {
+        BenchFilters();
+        return 0;
+    }
+    if (!_wcsicmp(name, L"dpi"))
+    {
+        BenchDpi();
+        return 0;
+    }
+    if (!_wcsicmp(name, L"settings"))
+    {
+        BenchSettings();
+        return 0;
+    }
+
+    ConsolePrintf(L"Unknown benchmark '%s'.  Available benchmarks:  scaler, flicker, search, edges, elements, filters, dpi, settings\n", name);
+    return 1;
+}
@@ -0,0 +1,10 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+// Benchmarks, run via `zoomin --bench <name>`.  Results are printed to the
+// console.
+
+int RunBenchmark(const WCHAR* name);
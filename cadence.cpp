@@ -0,0 +1,90 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <math.h>
+#include <algorithm>
+
+#include "cadence.h"
+
+void CadenceAnalyzer::Reset(double refresh_seconds)
+{
+    *this = CadenceAnalyzer();
+    if (refresh_seconds > 0)
+        m_refresh_seconds = refresh_seconds;
+}
+
+bool CadenceAnalyzer::AddCapture(double seconds, uint64_t hash)
+{
+    ++m_captures;
+
+    // The first capture has no previous frame to compare with.
+    if (!m_has_hash)
+    {
+        m_has_hash = true;
+        m_hash = hash;
+        return false;
+    }
+    if (hash == m_hash)
+        return false;
+    m_hash = hash;
+
+    // The frame on screen at the first capture appeared at an unknown time,
+    // so frame times are measured from the first change.
+    if (!m_has_change)
+    {
+        m_has_change = true;
+        m_first = seconds;
+        m_last = seconds;
+        return true;
+    }
+
+    const double elapsed = seconds - m_last;
+    m_last = seconds;
+
+    const bool first_frame = !m_refreshes;
+    const uint64_t refreshes = std::max<uint64_t>(1, uint64_t(llround(elapsed / m_refresh_seconds)));
+    const int32_t bin = int32_t(std::min<uint64_t>(refreshes, c_cadence_bins) - 1);
+    if (bin == c_cadence_bins - 1)
+        m_long_refreshes += refreshes;
+    m_refreshes += refreshes;
+    ++m_histogram[bin];
+
+    m_min = first_frame ? elapsed : std::min<double>(m_min, elapsed);
+    m_max = first_frame ? elapsed : std::max<double>(m_max, elapsed);
+    return true;
+}
+
+void CadenceAnalyzer::GetReport(CadenceReport& report) const
+{
+    report = CadenceReport();
+    report.captures = m_captures;
+    report.seconds = m_last - m_first;
+    report.refresh_seconds = m_refresh_seconds;
+    report.min_seconds = m_min;
+    report.max_seconds = m_max;
+
+    uint32_t peak = 0;
+    for (int32_t bin = 0; bin < c_cadence_bins; ++bin)
+    {
+        report.histogram[bin] = m_histogram[bin];
+        report.frames += m_histogram[bin];
+        if (m_histogram[bin] > peak)
+        {
+            peak = m_histogram[bin];
+            report.cadence = uint32_t(bin + 1);
+        }
+    }
+    if (!report.frames)
+        return;
+
+    report.duplicated = uint32_t(m_refreshes - report.frames);
+
+    // Refreshes past the cadence, in every bin longer than the cadence.
+    const uint64_t cadence = report.cadence;
+    uint64_t skipped = 0;
+    for (int32_t bin = int32_t(cadence); bin < c_cadence_bins - 1; ++bin)
+        skipped += m_histogram[bin] * (uint64_t(bin + 1) - cadence);
+    if (cadence < c_cadence_bins)
+        skipped += m_long_refreshes - m_histogram[c_cadence_bins - 1] * cadence;
+    report.skipped = uint32_t(skipped);
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// Frame cadence analyzer.
+//
+// Captures of the zoom area are reduced to content hashes, and each change of
+// hash starts a new distinct frame.  Frame times are measured in display
+// refreshes (rounded, so capture jitter of up to half a refresh doesn't
+// matter), which gives:
+//
+//  - Duplicated refreshes:  refreshes that showed the previous frame again,
+//    i.e. a frame time of N refreshes duplicates N - 1.
+//  - Skipped refreshes:  refreshes beyond the most common frame time, i.e.
+//    where the app missed its own cadence.  An app animating at half the
+//    refresh rate duplicates every other refresh, but only skips when it
+//    stutters.
+
+// Frame times of 1 .. c_cadence_bins - 1 refreshes, and the last bin counts
+// everything longer.
+constexpr int32_t c_cadence_bins = 8;
+
+struct CadenceReport
+{
+    uint32_t        captures = 0;
+    uint32_t        frames = 0;             // Distinct frames after the first change.
+    double          seconds = 0;            // From the first change to the last.
+    double          refresh_seconds = 0;
+    uint32_t        histogram[c_cadence_bins] = {};
+    uint32_t        cadence = 0;            // Most common frame time, in refreshes.
+    uint32_t        duplicated = 0;
+    uint32_t        skipped = 0;
+    double          min_seconds = 0;        // Shortest frame time.
+    double          max_seconds = 0;        // Longest frame time.
+
+    // Distinct frames per second.
+    double          GetRate() const { return (frames && seconds > 0) ? frames / seconds : 0; }
+};
+
+class CadenceAnalyzer
+{
+public:
+    void            Reset(double refresh_seconds);
+
+    // Returns true if the hash differs from the previous capture.
+    bool            AddCapture(double seconds, uint64_t hash);
+    void            GetReport(CadenceReport& report) const;
+
+private:
+    double          m_refresh_seconds = 1.0 / 60;
+    bool            m_has_hash = false;
+    uint64_t        m_hash = 0;
+    bool            m_has_change = false;
+    double          m_first = 0;
+    double          m_last = 0;
+    uint32_t        m_captures = 0;
+    uint32_t        m_histogram[c_cadence_bins] = {};
+    uint64_t        m_refreshes = 0;        // Sum of all frame times, in refreshes.
+    uint64_t        m_long_refreshes = 0;   // Sum of the frame times in the last bin.
+    double          m_min = 0;
+    double          m_max = 0;
+};
@@ -0,0 +1,131 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <algorithm>
+
+#include "cadencecapture.h"
+#include "dib.h"
+#include "perf.h"
+#include "pixels.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION   0x00000002
+#endif
+
+// Captures per refresh.  A change is seen up to 1/4 refresh late, so frame
+// times are within 1/4 refresh either way and round to the right number of
+// refreshes.
+constexpr int32_t c_captures_per_refresh = 4;
+
+double GetRefreshSeconds(const RECT& rc)
+{
+    MONITORINFOEX info = {};
+    info.cbSize = sizeof(info);
+    DEVMODE mode = {};
+    mode.dmSize = sizeof(mode);
+
+    const HMONITOR hmon = MonitorFromRect(&rc, MONITOR_DEFAULTTONEAREST);
+    if (GetMonitorInfo(hmon, &info) &&
+        EnumDisplaySettings(info.szDevice, ENUM_CURRENT_SETTINGS, &mode) &&
+        mode.dmDisplayFrequency > 1)
+    {
+        // 59 Hz usually means 59.94 Hz; rounding frame times absorbs that.
+        return 1.0 / mode.dmDisplayFrequency;
+    }
+
+    return 1.0 / 60;
+}
+
+bool CadenceCapture::Start(const RECT& rc)
+{
+    Stop();
+
+    if (!m_exit)
+        m_exit = CreateEvent(nullptr, true, false, nullptr);
+    if (!m_exit || rc.right <= rc.left || rc.bottom <= rc.top)
+        return false;
+
+    const double refresh_seconds = GetRefreshSeconds(rc);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_analyzer.Reset(refresh_seconds);
+    }
+
+    ResetEvent(m_exit);
+    m_thread = std::thread(&CadenceCapture::CaptureProc, this, rc, refresh_seconds);
+    return true;
+}
+
+void CadenceCapture::Stop()
+{
+    if (m_thread.joinable())
+    {
+        SetEvent(m_exit);
+        m_thread.join();
+    }
+    if (m_exit)
+    {
+        CloseHandle(m_exit);
+        m_exit = NULL;
+    }
+}
+
+void CadenceCapture::GetReport(CadenceReport& report) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_analyzer.GetReport(report);
+}
+
+void CadenceCapture::CaptureProc(RECT rc, double refresh_seconds)
+{
+    // Timestamps are taken right after each capture, so the capture thread
+    // shouldn't wait behind the UI for a time slice.
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+
+    // Without a high resolution timer (before Windows 10 1803) the wait rounds
+    // up to the system timer resolution, and frame times are less precise.
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer)
+        timer = CreateWaitableTimer(nullptr, false, nullptr);
+
+    const LONG cx = rc.right - rc.left;
+    const LONG cy = rc.bottom - rc.top;
+    const HDC hdcScreen = GetDC(NULL);
+    DibSection dib;
+    if (timer && hdcScreen && dib.EnsureSize(cx, cy))
+    {
+        const HANDLE handles[] = { m_exit, timer };
+        LARGE_INTEGER due;
+        due.QuadPart = -std::max<LONGLONG>(1, LONGLONG(refresh_seconds * 1e7 / c_captures_per_refresh));
+
+        PixelSource src;
+        src.bits = reinterpret_cast<const uint32_t*>(dib.GetBits());
+        src.stride = dib.GetStride();
+        src.cx = cx;
+        src.cy = cy;
+
+        do
+        {
+            // Arm first, so the interval includes the time spent capturing.
+            SetWaitableTimer(timer, &due, 0, nullptr, nullptr, false);
+
+            if (!BitBlt(dib.GetDC(), 0, 0, cx, cy, hdcScreen, rc.left, rc.top, SRCCOPY))
+                continue;
+            GdiFlush();
+
+            const double seconds = GetPerfSeconds();
+            const uint64_t hash = HashPixels(src);
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_analyzer.AddCapture(seconds, hash);
+        }
+        while (WaitForMultipleObjects(_countof(handles), handles, false, INFINITE) == WAIT_OBJECT_0 + 1);
+    }
+
+    if (hdcScreen)
+        ReleaseDC(NULL, hdcScreen);
+    if (timer)
+        CloseHandle(timer);
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <mutex>
+#include <thread>
+
+#include "cadence.h"
+
+//------------------------------------------------------------------------------
+// CadenceCapture captures a screen rect on a dedicated thread several times
+// per display refresh, and feeds content hashes to a CadenceAnalyzer.
+//
+// Only the rect itself is captured (no margins), and nothing is copied or
+// drawn per capture, so the measurement costs one small blit and one hash per
+// capture.
+
+class CadenceCapture
+{
+public:
+                    CadenceCapture() = default;
+                    ~CadenceCapture() { Stop(); }
+
+    bool            Start(const RECT& rc);
+    void            Stop();
+    bool            IsRunning() const { return m_thread.joinable(); }
+
+    void            GetReport(CadenceReport& report) const;
+
+private:
+    void            CaptureProc(RECT rc, double refresh_seconds);
+
+    std::thread     m_thread;
+    HANDLE          m_exit = NULL;
+    mutable std::mutex m_mutex;
+    CadenceAnalyzer m_analyzer;
+};
+
+// Refresh period of the monitor containing rc, in seconds.
+double GetRefreshSeconds(const RECT& rc);
@@ -0,0 +1,67 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <assert.h>
+
+#include "capture.h"
+#include "reticle.h"
+
+bool ClampZoomArea(const POINT& pt, const SIZE& area, const RECT& rcMonitor, RECT& rc)
+{
+    const LONG xx = clamp(pt.x, rcMonitor.left + area.cx / 2, rcMonitor.right - (area.cx - area.cx / 2));
+    const LONG yy = clamp(pt.y, rcMonitor.top + area.cy / 2, rcMonitor.bottom - (area.cy - area.cy / 2));
+
+    rc.left = xx - area.cx / 2;
+    rc.top = yy - area.cy / 2;
+    rc.right = rc.left + area.cx;
+    rc.bottom = rc.top + area.cy;
+
+    return (rc.right > rc.left && rc.bottom > rc.top);
+}
+
+bool ScreenCapture::Capture(const RECT& rc, const RECT& rcBounds, LONG cxMargin, LONG cyMargin)
+{
+    m_valid = false;
+
+    // Over-capture by the margins, so that small changes to the zoom factor or
+    // window size can be satisfied from the retained pixels.
+    RECT rcCapture = rc;
+    InflateRect(&rcCapture, cxMargin, cyMargin);
+    if (!IntersectRect(&rcCapture, &rcCapture, &rcBounds))
+        return false;
+
+    assert(rcCapture.left <= rc.left && rcCapture.right >= rc.right);
+    assert(rcCapture.top <= rc.top && rcCapture.bottom >= rc.bottom);
+
+    const LONG cx = rcCapture.right - rcCapture.left;
+    const LONG cy = rcCapture.bottom - rcCapture.top;
+    if (!m_dib.EnsureSize(cx, cy))
+        return false;
+
+    const HDC hdcScreen = ::GetDC(NULL);
+    if (!hdcScreen)
+        return false;
+
+    const bool ok = !!BitBlt(m_dib.GetDC(), 0, 0, cx, cy, hdcScreen, rcCapture.left, rcCapture.top, SRCCOPY);
+    ReleaseDC(NULL, hdcScreen);
+
+    if (ok)
+    {
+        GdiFlush();
+        m_rc = rcCapture;
+        m_valid = true;
+    }
+
+    return ok;
+}
+
+bool ScreenCapture::Contains(const RECT& rc) const
+{
+    return (m_valid &&
+            rc.left >= m_rc.left &&
+            rc.top >= m_rc.top &&
+            rc.right <= m_rc.right &&
+            rc.bottom <= m_rc.bottom);
+}
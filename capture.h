@@ -0,0 +1,35 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "dib.h"
+
+//------------------------------------------------------------------------------
+// ScreenCapture retains a copy of a region of the screen in a 32bpp top-down
+// DIB section, so the zoom window can be re-rendered (e.g. at a different zoom
+// factor or window size) without recapturing from the screen.
+
+// Returns the rect of the given size centered on pt, moved as needed to be
+// fully within rcMonitor.
+bool ClampZoomArea(const POINT& pt, const SIZE& area, const RECT& rcMonitor, RECT& rc);
+
+class ScreenCapture
+{
+public:
+    bool            Capture(const RECT& rc, const RECT& rcBounds, LONG cxMargin, LONG cyMargin);
+    bool            Contains(const RECT& rc) const;
+    void            Invalidate() { m_valid = false; }
+    void            Free() { m_dib.Free(); m_valid = false; }
+
+    bool            IsValid() const { return m_valid; }
+    HDC             GetDC() const { return m_dib.GetDC(); }
+    const RECT&     GetRect() const { return m_rc; }
+    const DWORD*    GetBits() const { return m_dib.GetBits(); }
+    LONG            GetStride() const { return m_dib.GetStride(); }
+
+private:
+    DibSection      m_dib;
+    RECT            m_rc = {};
+    bool            m_valid = false;
+};
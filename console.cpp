@@ -0,0 +1,67 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "console.h"
+
+static HANDLE s_hout = NULL;
+static bool s_is_console = false;
+
+bool AttachConsoleOutput()
+{
+    if (s_hout)
+        return true;
+
+    // Prefer stdout when it's been redirected (e.g. to a file or a pipe).
+    HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (h && h != INVALID_HANDLE_VALUE)
+    {
+        DWORD mode;
+        s_hout = h;
+        s_is_console = !!GetConsoleMode(h, &mode);
+        return true;
+    }
+
+    if (!AttachConsole(ATTACH_PARENT_PROCESS))
+        return false;
+
+    h = CreateFile(TEXT("CONOUT$"), GENERIC_READ|GENERIC_WRITE, FILE_SHARE_READ|FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    s_hout = h;
+    s_is_console = true;
+    return true;
+}
+
+void ConsolePrintf(const WCHAR* format, ...)
+{
+    if (!s_hout && !AttachConsoleOutput())
+        return;
+
+    WCHAR buffer[1024];
+    va_list args;
+    va_start(args, format);
+    const int len = _vsnwprintf(buffer, _countof(buffer) - 1, format, args);
+    va_end(args);
+    buffer[_countof(buffer) - 1] = '\0';
+    if (len < 0)
+        return;
+
+    DWORD written;
+    if (s_is_console)
+    {
+        WriteConsoleW(s_hout, buffer, DWORD(wcslen(buffer)), &written, nullptr);
+    }
+    else
+    {
+        char utf8[_countof(buffer) * 3];
+        const int cb = WideCharToMultiByte(CP_UTF8, 0, buffer, -1, utf8, sizeof(utf8), nullptr, nullptr);
+        if (cb > 1)
+            WriteFile(s_hout, utf8, DWORD(cb - 1), &written, nullptr);
+    }
+}
@@ -0,0 +1,11 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+// Zoomin is a windowed app, so command line modes that produce output write
+// to the parent process's console, or to stdout when it's redirected.
+
+bool AttachConsoleOutput();
+void ConsolePrintf(const WCHAR* format, ...);
@@ -0,0 +1,20 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "delayload.h"
+
+FARPROC DelayProcBase::Resolve()
+{
+    // Racing threads resolve to the same address, so no lock is needed.
+    HMODULE hmod = GetModuleHandleW(m_module);
+    if (!hmod)
+        hmod = LoadLibraryExW(m_module, nullptr, LOAD_LIBRARY_SEARCH_SYSTEM32);
+
+    const FARPROC proc = hmod ? GetProcAddress(hmod, m_name) : nullptr;
+    m_proc.store(proc, std::memory_order_relaxed);
+    m_resolved.store(true, std::memory_order_release);
+    return proc;
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <atomic>
+
+//------------------------------------------------------------------------------
+// Lazily bound exports.
+//
+// A DelayProc resolves its export the first time it's called, and caches the
+// result (including failure).  Instances are constant-initialized, so unlike
+// calling LoadLibrary/GetProcAddress from static initializers they cost
+// nothing before WinMain, and entries that are never used are never resolved.
+//
+// Modules that are already loaded (e.g. user32.dll) are found via
+// GetModuleHandle; others are loaded from the system directory on first use
+// and stay loaded.
+
+class DelayProcBase
+{
+public:
+    constexpr       DelayProcBase(const WCHAR* module, const char* name) : m_module(module), m_name(name) {}
+
+    FARPROC         GetProc()
+    {
+        if (m_resolved.load(std::memory_order_acquire))
+            return m_proc.load(std::memory_order_relaxed);
+        return Resolve();
+    }
+
+private:
+    FARPROC         Resolve();
+
+    const WCHAR* const m_module;
+    const char* const m_name;
+    std::atomic<FARPROC> m_proc { nullptr };
+    std::atomic<bool> m_resolved { false };
+};
+
+template <class T>
+class DelayProc : public DelayProcBase
+{
+public:
+    constexpr       DelayProc(const WCHAR* module, const char* name) : DelayProcBase(module, name) {}
+
+    T               Get() { return reinterpret_cast<T>(GetProc()); }
+};
@@ -0,0 +1,62 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <windowsx.h>
+#include <algorithm>
+
+#include "dib.h"
+
+bool DibSection::EnsureSize(LONG cx, LONG cy)
+{
+    // Only grow the bitmap; reallocating on every frame would be wasteful.
+    if (m_hbmp && cx <= m_size.cx && cy <= m_size.cy)
+        return true;
+
+    const SIZE size = { std::max<LONG>(cx, m_size.cx), std::max<LONG>(cy, m_size.cy) };
+    Free();
+
+    m_hdc = CreateCompatibleDC(NULL);
+    if (!m_hdc)
+        return false;
+
+    BITMAPINFO bmi = {};
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = size.cx;
+    bmi.bmiHeader.biHeight = -size.cy;  // Top-down.
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    m_hbmp = CreateDIBSection(m_hdc, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (!m_hbmp)
+    {
+        Free();
+        return false;
+    }
+
+    m_hbmpOld = SelectBitmap(m_hdc, m_hbmp);
+    m_bits = static_cast<DWORD*>(bits);
+    m_size = size;
+    return true;
+}
+
+void DibSection::Free()
+{
+    if (m_hdc)
+    {
+        if (m_hbmpOld)
+            SelectBitmap(m_hdc, m_hbmpOld);
+        DeleteDC(m_hdc);
+    }
+    if (m_hbmp)
+        DeleteObject(m_hbmp);
+
+    m_hdc = NULL;
+    m_hbmp = NULL;
+    m_hbmpOld = NULL;
+    m_bits = nullptr;
+    m_size = {};
+}
@@ -0,0 +1,30 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+// DibSection is a 32bpp top-down DIB section selected into a memory DC, so its
+// pixels can be accessed directly as well as drawn with GDI.
+
+class DibSection
+{
+public:
+                    DibSection() = default;
+                    ~DibSection() { Free(); }
+
+    bool            EnsureSize(LONG cx, LONG cy);
+    void            Free();
+
+    HDC             GetDC() const { return m_hdc; }
+    DWORD*          GetBits() const { return m_bits; }
+    LONG            GetStride() const { return m_size.cx; }
+    const SIZE&     GetSize() const { return m_size; }
+
+private:
+    HDC             m_hdc = NULL;
+    HBITMAP         m_hbmp = NULL;
+    HBITMAP         m_hbmpOld = NULL;
+    DWORD*          m_bits = nullptr;
+    SIZE            m_size = {};
+};
@@ -0,0 +1,163 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "diff.h"
+
+// Heatmap channels are |difference| * 8, but at least this bright when they
+// differ at all.
+constexpr uint32_t c_heat_shift = 3;
+constexpr uint32_t c_heat_floor = 0x40;
+
+//------------------------------------------------------------------------------
+// DiffResult.
+
+void DiffResult::AddRow(int32_t y, uint32_t count, int32_t first, int32_t last)
+{
+    if (!count)
+        return;
+
+    if (!differing)
+    {
+        left = first;
+        top = y;
+        right = last + 1;
+    }
+    else
+    {
+        left = std::min<int32_t>(left, first);
+        top = std::min<int32_t>(top, y);
+        right = std::max<int32_t>(right, last + 1);
+    }
+    bottom = std::max<int32_t>(bottom, y + 1);
+    differing += count;
+}
+
+void DiffResult::Merge(const DiffResult& other)
+{
+    if (!other.differing)
+        return;
+
+    if (!differing)
+    {
+        *this = other;
+        return;
+    }
+
+    left = std::min<int32_t>(left, other.left);
+    top = std::min<int32_t>(top, other.top);
+    right = std::max<int32_t>(right, other.right);
+    bottom = std::max<int32_t>(bottom, other.bottom);
+    differing += other.differing;
+}
+
+//------------------------------------------------------------------------------
+// DiffPixel and DiffRow.
+
+uint32_t DiffPixel(uint32_t current, uint32_t baseline, const DiffParams& params)
+{
+    uint32_t heat = 0;
+    bool differs = false;
+    for (uint32_t shift = 0; shift < 24; shift += 8)
+    {
+        const int32_t a = (current >> shift) & 0xff;
+        const int32_t b = (baseline >> shift) & 0xff;
+        const uint32_t d = uint32_t(a > b ? a - b : b - a);
+        if (d)
+        {
+            differs = true;
+            heat |= std::max<uint32_t>(c_heat_floor, std::min<uint32_t>(0xff, d << c_heat_shift)) << shift;
+        }
+    }
+
+    if (params.style == DS_HEATMAP)
+        return heat;
+    return differs ? params.highlight_color : (current >> 2) & 0x003f3f3f;
+}
+
+uint32_t DiffRow(const uint32_t* current, const uint32_t* baseline, int32_t cx, const DiffParams& params, uint32_t* out, int32_t& first, int32_t& last)
+{
+    uint32_t count = 0;
+    int32_t xx = 0;
+
+    auto note = [&](int32_t x)
+    {
+        if (!count)
+            first = x;
+        last = x;
+        ++count;
+    };
+
+#ifdef USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgb = _mm_set1_epi32(0x00ffffff);
+    const __m128i floor = _mm_set1_epi32(c_heat_floor * 0x010101);
+    const __m128i dim_mask = _mm_set1_epi32(0x003f3f3f);
+    const __m128i highlight = _mm_set1_epi32(int(params.highlight_color));
+    const bool heatmap = (params.style == DS_HEATMAP);
+    for (; xx + 4 <= cx; xx += 4)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + xx));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(baseline + xx));
+
+        // Saturating subtraction both ways gives the absolute difference.
+        const __m128i d = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a)), rgb);
+        const __m128i same = _mm_cmpeq_epi32(d, zero);
+
+        __m128i v;
+        if (heatmap)
+        {
+            v = _mm_adds_epu8(d, d);
+            v = _mm_adds_epu8(v, v);
+            v = _mm_adds_epu8(v, v);
+            v = _mm_max_epu8(v, _mm_andnot_si128(_mm_cmpeq_epi8(d, zero), floor));
+        }
+        else
+        {
+            const __m128i dim = _mm_and_si128(_mm_srli_epi32(a, 2), dim_mask);
+            v = _mm_or_si128(_mm_and_si128(same, dim), _mm_andnot_si128(same, highlight));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + xx), v);
+
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(same)) ^ 0xf;
+        if (mask)
+        {
+            for (int32_t jj = 0; jj < 4; ++jj)
+            {
+                if (mask & (1 << jj))
+                    note(xx + jj);
+            }
+        }
+    }
+#endif
+    for (; xx < cx; ++xx)
+    {
+        out[xx] = DiffPixel(current[xx], baseline[xx], params);
+        if ((current[xx] ^ baseline[xx]) & 0x00ffffff)
+            note(xx);
+    }
+
+    return count;
+}
+
+void DiffImage(const PixelSource& src, const DiffParams& params, const PixelTarget& dst, DiffResult& result)
+{
+    result = DiffResult();
+
+    const int32_t cx = std::min<int32_t>(src.cx, dst.cx);
+    const int32_t cy = std::min<int32_t>(src.cy, dst.cy);
+    for (int32_t yy = 0; yy < cy; ++yy)
+    {
+        int32_t first = 0;
+        int32_t last = 0;
+        const uint32_t count = DiffRow(src.bits + yy * src.stride, params.baseline.bits + yy * params.baseline.stride, cx,
+                                       params, dst.bits + yy * dst.stride, first, last);
+        result.AddRow(yy, count, first, last);
+    }
+}
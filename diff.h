@@ -0,0 +1,59 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "pixels.h"
+
+//------------------------------------------------------------------------------
+// Baseline differences.
+//
+// Compares the source with a frozen baseline of the same area, and produces a
+// difference image in place of the source:
+//
+//  - Heatmap shows |current - baseline| per channel, amplified so that even a
+//    difference of one level is visible; unchanged pixels are black.
+//  - Highlight shows differing pixels in a solid color over a dimmed copy of
+//    the current pixels.
+//
+// The scaler computes each difference row just before replicating it, so the
+// comparison costs one extra pass over the (small) source per frame.
+//
+// tests/scaler_test.cpp checks the difference image and result from both
+// scalers.
+
+enum DiffStyle
+{
+    DS_HEATMAP,
+    DS_HIGHLIGHT,
+};
+
+struct DiffResult
+{
+    uint32_t        differing = 0;      // Number of differing source pixels.
+    int32_t         left = 0;           // Bounding box of the differing
+    int32_t         top = 0;            // pixels, relative to the source;
+    int32_t         right = 0;          // empty if none differ.
+    int32_t         bottom = 0;
+
+    void            AddRow(int32_t y, uint32_t count, int32_t first, int32_t last);
+    void            Merge(const DiffResult& other);
+};
+
+struct DiffParams
+{
+    PixelSource     baseline;           // Same origin and size as the source.
+    DiffStyle       style = DS_HEATMAP;
+    uint32_t        highlight_color = 0x00ff00ff;
+    DiffResult*     result = nullptr;   // Receives the count and bounding box, if not null.
+    PixelTarget     image;              // Receives the unscaled difference image, if bits isn't null.
+};
+
+uint32_t DiffPixel(uint32_t current, uint32_t baseline, const DiffParams& params);
+
+// Writes one row of the difference image to out, and returns the number of
+// differing pixels.  If any differ, first and last receive their range.
+uint32_t DiffRow(const uint32_t* current, const uint32_t* baseline, int32_t cx, const DiffParams& params, uint32_t* out, int32_t& first, int32_t& last);
+
+// The unscaled difference image, for renderers that scale on the GPU.
+void DiffImage(const PixelSource& src, const DiffParams& params, const PixelTarget& dst, DiffResult& result);
@@ -8,6 +8,7 @@
 #include <assert.h>
 
 #include "dpi.h"
+#include "delayload.h"
 
 #ifndef ILC_COLORMASK
 #define ILC_COLORMASK   0x00FE
@@ -27,11 +28,14 @@ WORD __GetHdcDpi(HDC hdc)
     return dxLogPixels;
 }
 
+static constexpr WCHAR c_user32[] = L"user32.dll";
+static constexpr WCHAR c_shcore[] = L"shcore.dll";
+
+// Each entry point is resolved on first use (see delayload.h), so nothing here
+// runs during static initialization.
 class User32
 {
 public:
-                            User32();
-
     WORD                    GetDpiForSystem();
     WORD                    GetDpiForWindow(HWND hwnd);
     HRESULT                 GetDpiForMonitor(HMONITOR hmon, MONITOR_DPI_TYPE dpiType, UINT* dpiX, UINT* dpiY);
@@ -45,91 +49,24 @@ public:
     bool                    EnablePerMonitorMenuScaling();
 
 private:
-    bool                    Initialize();
-
-private:
-    DWORD                   m_dwErr = 0;
-    HMODULE                 m_hLib = 0;
-    HMODULE                 m_hLibShellScaling = 0;
-    bool                    m_fInitialized = false;
-    union
-    {
-        FARPROC	proc[11];
-        struct
-        {
-            UINT (WINAPI* GetDpiForSystem)();
-            UINT (WINAPI* GetDpiForWindow)(HWND hwnd);
-            HRESULT (WINAPI* GetDpiForMonitor)(HMONITOR hmon, MONITOR_DPI_TYPE dpiType, UINT* dpiX, UINT* dpiY);
-            int (WINAPI* GetSystemMetricsForDpi)(int nIndex, UINT dpi);
-            BOOL (WINAPI* SystemParametersInfoForDpi)(UINT uiAction, UINT uiParam, PVOID pvParam, UINT fWinIni, UINT dpi);
-            BOOL (WINAPI* IsValidDpiAwarenessContext)(DPI_AWARENESS_CONTEXT context);
-            BOOL (WINAPI* AreDpiAwarenessContextsEqual)(DPI_AWARENESS_CONTEXT contextA, DPI_AWARENESS_CONTEXT contextB);
-            DPI_AWARENESS_CONTEXT (WINAPI* SetThreadDpiAwarenessContext)(DPI_AWARENESS_CONTEXT context);
-            DPI_AWARENESS_CONTEXT (WINAPI* GetWindowDpiAwarenessContext)(HWND hwnd);
-            BOOL (WINAPI* EnableNonClientDpiScaling)(HWND hwnd);
-            BOOL (WINAPI* EnablePerMonitorMenuScaling)();
-        };
-    } m_user32;
+    DelayProc<UINT (WINAPI*)()> m_GetDpiForSystem { c_user32, "GetDpiForSystem" };
+    DelayProc<UINT (WINAPI*)(HWND hwnd)> m_GetDpiForWindow { c_user32, "GetDpiForWindow" };
+    DelayProc<HRESULT (WINAPI*)(HMONITOR hmon, MONITOR_DPI_TYPE dpiType, UINT* dpiX, UINT* dpiY)> m_GetDpiForMonitor { c_shcore, "GetDpiForMonitor" };
+    DelayProc<int (WINAPI*)(int nIndex, UINT dpi)> m_GetSystemMetricsForDpi { c_user32, "GetSystemMetricsForDpi" };
+    DelayProc<BOOL (WINAPI*)(DPI_AWARENESS_CONTEXT context)> m_IsValidDpiAwarenessContext { c_user32, "IsValidDpiAwarenessContext" };
+    DelayProc<BOOL (WINAPI*)(DPI_AWARENESS_CONTEXT contextA, DPI_AWARENESS_CONTEXT contextB)> m_AreDpiAwarenessContextsEqual { c_user32, "AreDpiAwarenessContextsEqual" };
+    DelayProc<DPI_AWARENESS_CONTEXT (WINAPI*)(DPI_AWARENESS_CONTEXT context)> m_SetThreadDpiAwarenessContext { c_user32, "SetThreadDpiAwarenessContext" };
+    DelayProc<DPI_AWARENESS_CONTEXT (WINAPI*)(HWND hwnd)> m_GetWindowDpiAwarenessContext { c_user32, "GetWindowDpiAwarenessContext" };
+    DelayProc<BOOL (WINAPI*)(HWND hwnd)> m_EnableNonClientDpiScaling { c_user32, "EnableNonClientDpiScaling" };
+    DelayProc<BOOL (WINAPI*)()> m_EnablePerMonitorMenuScaling { c_user32, "EnablePerMonitorMenuScaling" };
 };
 
-User32 g_user32;
-
-User32::User32()
-{
-    ZeroMemory(&m_user32, sizeof(m_user32));
-
-    Initialize();
-
-    static_assert(_countof(m_user32.proc) == sizeof(m_user32) / sizeof(FARPROC), "mismatched FARPROC struct");
-}
-
-bool User32::Initialize()
-{
-    if (!m_fInitialized)
-    {
-        m_fInitialized = true;
-        m_hLib = LoadLibrary(TEXT("user32.dll"));
-        m_hLibShellScaling = LoadLibrary(TEXT("shellscalingapi.dll"));
-        if (!m_hLib || !m_hLibShellScaling)
-        {
-            m_dwErr = GetLastError();
-        }
-        else
-        {
-            size_t cProcs = 0;
-
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "GetDpiForSystem")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "GetDpiForWindow")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLibShellScaling, "GetDpiForMonitor")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "GetSystemMetricsForDpi")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "SystemParametersInfoForDpi")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "IsValidDpiAwarenessContext")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "AreDpiAwarenessContextsEqual")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "SetThreadDpiAwarenessContext")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "GetWindowDpiAwarenessContext")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            if (!(m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "EnableNonClientDpiScaling")))
-                m_dwErr = m_dwErr ? m_dwErr : GetLastError();
-            m_user32.proc[cProcs++] = GetProcAddress(m_hLib, "EnablePerMonitorMenuScaling"); // Optional: not an error if it's missing.
-            assert(_countof(m_user32.proc) == cProcs);
-        }
-    }
-
-    return !m_dwErr;
-}
+static User32 g_user32;
 
 WORD User32::GetDpiForSystem()
 {
-    if (m_user32.GetDpiForSystem)
-        return m_user32.GetDpiForSystem();
+    if (const auto proc = m_GetDpiForSystem.Get())
+        return proc();
 
     const HDC hdc = GetDC(0);
     const WORD dpi = __GetHdcDpi(hdc);
@@ -139,8 +76,8 @@ WORD User32::GetDpiForSystem()
 
 WORD User32::GetDpiForWindow(HWND hwnd)
 {
-    if (m_user32.GetDpiForWindow)
-        return m_user32.GetDpiForWindow(hwnd);
+    if (const auto proc = m_GetDpiForWindow.Get())
+        return proc(hwnd);
 
     const HDC hdc = GetDC(hwnd);
     const WORD dpi = __GetHdcDpi(hdc);
@@ -150,21 +87,21 @@ WORD User32::GetDpiForWindow(HWND hwnd)
 
 HRESULT User32::GetDpiForMonitor(HMONITOR hmon, MONITOR_DPI_TYPE dpiType, UINT* dpiX, UINT* dpiY)
 {
-    if (m_user32.GetDpiForMonitor)
-        return m_user32.GetDpiForMonitor(hmon, dpiType, dpiX, dpiY);
+    if (const auto proc = m_GetDpiForMonitor.Get())
+        return proc(hmon, dpiType, dpiX, dpiY);
 
     return E_NOTIMPL;
 }
 
 int User32::GetSystemMetricsForDpi(int nIndex, UINT dpi)
 {
-    if (m_user32.GetSystemMetricsForDpi)
+    if (const auto proc = m_GetSystemMetricsForDpi.Get())
     {
         // Scale these ourselves because the OS doesn't seem to return them scaled.  ?!
         if (nIndex == SM_CXFOCUSBORDER || nIndex == SM_CYFOCUSBORDER)
             return HIDPIMulDiv(GetSystemMetrics(nIndex), dpi, 96);
 
-        return m_user32.GetSystemMetricsForDpi(nIndex, dpi);
+        return proc(nIndex, dpi);
     }
 
     return GetSystemMetrics(nIndex);
@@ -214,48 +151,48 @@ bool User32::SystemParametersInfoForDpi(UINT uiAction, UINT uiParam, PVOID pvPar
 
 bool User32::IsValidDpiAwarenessContext(DPI_AWARENESS_CONTEXT context)
 {
-    if (m_user32.IsValidDpiAwarenessContext)
-        return m_user32.IsValidDpiAwarenessContext(context);
+    if (const auto proc = m_IsValidDpiAwarenessContext.Get())
+        return proc(context);
 
     return false;
 }
 
 bool User32::AreDpiAwarenessContextsEqual(DPI_AWARENESS_CONTEXT contextA, DPI_AWARENESS_CONTEXT contextB)
 {
-    if (m_user32.AreDpiAwarenessContextsEqual)
-        return m_user32.AreDpiAwarenessContextsEqual(contextA, contextB);
+    if (const auto proc = m_AreDpiAwarenessContextsEqual.Get())
+        return proc(contextA, contextB);
 
     return (contextA == contextB);
 }
 
 DPI_AWARENESS_CONTEXT User32::SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT context)
 {
-    if (m_user32.SetThreadDpiAwarenessContext)
-        return m_user32.SetThreadDpiAwarenessContext(context);
+    if (const auto proc = m_SetThreadDpiAwarenessContext.Get())
+        return proc(context);
 
     return DPI_AWARENESS_CONTEXT_UNAWARE;
 }
 
 DPI_AWARENESS_CONTEXT User32::GetWindowDpiAwarenessContext(HWND hwnd)
 {
-    if (m_user32.GetWindowDpiAwarenessContext)
-        return m_user32.GetWindowDpiAwarenessContext(hwnd);
+    if (const auto proc = m_GetWindowDpiAwarenessContext.Get())
+        return proc(hwnd);
 
     return DPI_AWARENESS_CONTEXT_UNAWARE;
 }
 
 bool User32::EnableNonClientDpiScaling(HWND hwnd)
 {
-    if (m_user32.EnableNonClientDpiScaling)
-        return m_user32.EnableNonClientDpiScaling(hwnd);
+    if (const auto proc = m_EnableNonClientDpiScaling.Get())
+        return proc(hwnd);
 
     return true;
 }
 
 bool User32::EnablePerMonitorMenuScaling()
 {
-    if (m_user32.EnablePerMonitorMenuScaling)
-        return m_user32.EnablePerMonitorMenuScaling();
+    if (const auto proc = m_EnablePerMonitorMenuScaling.Get())
+        return proc();
 
     return false;
 }
@@ -387,32 +324,43 @@ int HIDPIMulDiv(int x, int y, int z)
     return (((HIDPIABS(x) * y) + (z >> 3)) / z) * HIDPISIGN(x);
 }
 
+DpiDivisor DpiScaler::MakeDivisor(WORD dpi)
+{
+    assert(dpi);
+    return GetDpiDivisor(dpi);
+}
+
 DpiScaler::DpiScaler()
+: m_logPixels(96)
+, m_divisor(c_dpiDivisor96)
 {
-    m_logPixels = 96;
 }
 
 DpiScaler::DpiScaler(WORD dpi)
+: m_logPixels(dpi)
+, m_divisor(MakeDivisor(dpi))
 {
     assert(dpi);
-    m_logPixels = dpi;
 }
 
 DpiScaler::DpiScaler(WPARAM wParam)
+: m_logPixels(LOWORD(wParam))
+, m_divisor(MakeDivisor(LOWORD(wParam)))
 {
     assert(wParam);
     assert(LOWORD(wParam));
-    m_logPixels = LOWORD(wParam);
 }
 
 DpiScaler::DpiScaler(const DpiScaler& dpi)
+: m_logPixels(dpi.m_logPixels)
+, m_divisor(dpi.m_divisor)
 {
-    m_logPixels = dpi.m_logPixels;
 }
 
 DpiScaler::DpiScaler(DpiScaler&& dpi)
+: m_logPixels(dpi.m_logPixels)
+, m_divisor(dpi.m_divisor)
 {
-    m_logPixels = dpi.m_logPixels;
 }
 
 bool DpiScaler::IsDpiEqual(UINT dpi) const
@@ -430,29 +378,28 @@ DpiScaler& DpiScaler::operator=(WORD dpi)
 {
     assert(dpi);
     m_logPixels = dpi;
+    m_divisor = MakeDivisor(dpi);
     return *this;
 }
 
 DpiScaler& DpiScaler::operator=(const DpiScaler& dpi)
 {
     m_logPixels = dpi.m_logPixels;
+    m_divisor = dpi.m_divisor;
     return *this;
 }
 
 DpiScaler& DpiScaler::operator=(DpiScaler&& dpi)
 {
     m_logPixels = dpi.m_logPixels;
+    m_divisor = dpi.m_divisor;
     return *this;
 }
 
 void DpiScaler::OnDpiChanged(const DpiScaler& dpi)
 {
     m_logPixels = dpi.m_logPixels;
-}
-
-int DpiScaler::Scale(int n) const
-{
-    return HIDPIMulDiv(n, m_logPixels, 96);
+    m_divisor = dpi.m_divisor;
 }
 
 float DpiScaler::ScaleF(float n) const
@@ -460,28 +407,6 @@ float DpiScaler::ScaleF(float n) const
     return n * float(m_logPixels) / 96.0f;
 }
 
-int DpiScaler::ScaleTo(int n, DWORD dpi) const
-{
-    assert(dpi);
-    return HIDPIMulDiv(n, dpi, m_logPixels);
-}
-
-int DpiScaler::ScaleTo(int n, const DpiScaler& dpi) const
-{
-    return HIDPIMulDiv(n, dpi.m_logPixels, m_logPixels);
-}
-
-int DpiScaler::ScaleFrom(int n, DWORD dpi) const
-{
-    assert(dpi);
-    return HIDPIMulDiv(n, m_logPixels, dpi);
-}
-
-int DpiScaler::ScaleFrom(int n, const DpiScaler& dpi ) const
-{
-    return HIDPIMulDiv(n, m_logPixels, dpi.m_logPixels);
-}
-
 int DpiScaler::PointSizeToHeight(int nPointSize) const
 {
     assert(nPointSize >= 1);
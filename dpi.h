@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "dpidivisor.h"
+
 #ifndef WM_DPICHANGED
 #define WM_DPICHANGED           0x02E0
 #endif
@@ -84,6 +86,34 @@ public:
     WPARAM      MakeWParam() const;
 
 private:
+    static DpiDivisor MakeDivisor(WORD dpi);
+
     WORD        m_logPixels;
+    DpiDivisor  m_divisor;      // Divides by m_logPixels.
 };
 
+inline int DpiScaler::Scale(int n) const
+{
+    return c_dpiDivisor96.MulDiv(n, m_logPixels);
+}
+
+inline int DpiScaler::ScaleTo(int n, DWORD dpi) const
+{
+    return m_divisor.MulDiv(n, dpi);
+}
+
+inline int DpiScaler::ScaleTo(int n, const DpiScaler& dpi) const
+{
+    return m_divisor.MulDiv(n, dpi.m_logPixels);
+}
+
+inline int DpiScaler::ScaleFrom(int n, DWORD dpi) const
+{
+    return GetDpiDivisor(dpi).MulDiv(n, m_logPixels);
+}
+
+inline int DpiScaler::ScaleFrom(int n, const DpiScaler& dpi) const
+{
+    return dpi.m_divisor.MulDiv(n, m_logPixels);
+}
+
@@ -0,0 +1,72 @@
+// Copyright (c) 2023 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// DpiDivisor is a division-free form of HIDPIMulDiv(x, y, z) for a fixed z:
+// a fixed-point reciprocal of z, precomputed when the DPI changes.  Results
+// are bit-for-bit identical to HIDPIMulDiv (including its z >> 3 rounding
+// bias) whenever |x| * y + (z >> 3) fits in an int, which HIDPIMulDiv needs
+// anyway to avoid overflow.
+//
+// With shift = 31 + ceil(log2(z)) and mul = ceil(2^shift / z), the error
+// (mul * z - 2^shift) is less than 2^(shift - 31), which makes the quotient
+// exact for every numerator below 2^31, and mul fits in 33 bits so the
+// product can't overflow 64 bits.
+//
+// See dpi.h for DpiScaler, which uses it.  tests/dpi_test.cpp checks it
+// against the HIDPIMulDiv formula for every numerator up to INT_MAX.
+
+class DpiDivisor
+{
+public:
+    constexpr explicit  DpiDivisor(uint32_t z) : m_mul(((uint64_t(1) << Shift(z)) + z - 1) / z), m_shift(Shift(z)), m_bias(z >> 3) {}
+
+    int                 MulDiv(int x, uint32_t y) const
+    {
+        const uint32_t ax = (x < 0) ? 0u - uint32_t(x) : uint32_t(x);
+        const int q = int(((uint64_t(ax) * y + m_bias) * m_mul) >> m_shift);
+        return (x < 0) ? -q : q;
+    }
+
+private:
+    static constexpr uint32_t CeilLog2(uint32_t z, uint32_t bits=0) { return ((1u << bits) >= z) ? bits : CeilLog2(z, bits + 1); }
+    static constexpr uint32_t Shift(uint32_t z) { return 31 + CeilLog2(z); }
+
+    uint64_t            m_mul;
+    uint32_t            m_shift;
+    uint32_t            m_bias;
+};
+
+// Compile-time divisors for the common DPIs (100%, 125%, 150%, 175%, 200%,
+// and 300% scaling).
+constexpr DpiDivisor c_dpiDivisor96(96);
+constexpr DpiDivisor c_dpiDivisor120(120);
+constexpr DpiDivisor c_dpiDivisor144(144);
+constexpr DpiDivisor c_dpiDivisor168(168);
+constexpr DpiDivisor c_dpiDivisor192(192);
+constexpr DpiDivisor c_dpiDivisor288(288);
+
+inline const DpiDivisor* GetCommonDpiDivisor(uint32_t dpi)
+{
+    switch (dpi)
+    {
+    case 96:    return &c_dpiDivisor96;
+    case 120:   return &c_dpiDivisor120;
+    case 144:   return &c_dpiDivisor144;
+    case 168:   return &c_dpiDivisor168;
+    case 192:   return &c_dpiDivisor192;
+    case 288:   return &c_dpiDivisor288;
+    default:    return nullptr;
+    }
+}
+
+// Returns the common divisor for dpi, or else computes one.
+inline DpiDivisor GetDpiDivisor(uint32_t dpi)
+{
+    const DpiDivisor* const divisor = GetCommonDpiDivisor(dpi);
+    return divisor ? *divisor : DpiDivisor(dpi);
+}
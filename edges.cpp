@@ -0,0 +1,252 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <stdlib.h>
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "edges.h"
+#include "labels.h"
+
+static bool IsStrong(int32_t a, int32_t b, int32_t c)
+{
+    return abs(a + 2 * b + c) >= c_edge_threshold;
+}
+
+#ifdef USE_SSE2
+// Loads 8 bytes as 16-bit lanes.
+static __m128i Load8(const uint8_t* p)
+{
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_setzero_si128());
+}
+
+// Stores 8 edge flags (0 or 1) for |a + 2b + c| >= c_edge_threshold.
+static void StoreStrong(__m128i a, __m128i b, __m128i c, uint8_t* out)
+{
+    const __m128i sum = _mm_add_epi16(_mm_add_epi16(a, c), _mm_add_epi16(b, b));
+    const __m128i magnitude = _mm_max_epi16(sum, _mm_sub_epi16(_mm_setzero_si128(), sum));
+    const __m128i strong = _mm_cmpgt_epi16(magnitude, _mm_set1_epi16(c_edge_threshold - 1));
+    const __m128i flags = _mm_and_si128(_mm_packs_epi16(strong, strong), _mm_set1_epi8(1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), flags);
+}
+#endif
+
+// Whichever of the last edge at or before pos, and the next edge at or after
+// pos, is nearer (or -1 if neither exists).
+static int16_t NearerEdge(int16_t last, int16_t next, int16_t pos)
+{
+    const bool use_next = (next >= 0 && (last < 0 || next - pos < pos - last));
+    return use_next ? next : last;
+}
+
+// nearest[x] = strong[x] ? pos : prev[x].
+static void ForwardSweep(const uint8_t* strong, const int16_t* prev, int16_t pos, int32_t count, int16_t* nearest)
+{
+    int32_t ii = 0;
+#ifdef USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vpos = _mm_set1_epi16(pos);
+    for (; ii + 8 <= count; ii += 8)
+    {
+        const __m128i mask = _mm_cmpgt_epi16(Load8(strong + ii), zero);
+        const __m128i before = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + ii));
+        const __m128i result = _mm_or_si128(_mm_and_si128(mask, vpos), _mm_andnot_si128(mask, before));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(nearest + ii), result);
+    }
+#endif
+    for (; ii < count; ++ii)
+        nearest[ii] = strong[ii] ? pos : prev[ii];
+}
+
+// Where the forward sweep found an edge at pos, that's the next edge for the
+// rows above; then each entry becomes the nearer of the two.
+static void BackwardSweep(int16_t* nearest, int16_t* next, int16_t pos, int32_t count)
+{
+    int32_t ii = 0;
+#ifdef USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vpos = _mm_set1_epi16(pos);
+    for (; ii + 8 <= count; ii += 8)
+    {
+        const __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(nearest + ii));
+        __m128i after = _mm_loadu_si128(reinterpret_cast<const __m128i*>(next + ii));
+        const __m128i at = _mm_cmpeq_epi16(last, vpos);
+        after = _mm_or_si128(_mm_and_si128(at, vpos), _mm_andnot_si128(at, after));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(next + ii), after);
+
+        // next >= 0 && (last < 0 || next - pos < pos - last).
+        const __m128i nearer = _mm_or_si128(_mm_cmplt_epi16(last, zero),
+                                            _mm_cmplt_epi16(_mm_sub_epi16(after, vpos), _mm_sub_epi16(vpos, last)));
+        const __m128i use_next = _mm_andnot_si128(_mm_cmplt_epi16(after, zero), nearer);
+        const __m128i result = _mm_or_si128(_mm_and_si128(use_next, after), _mm_andnot_si128(use_next, last));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(nearest + ii), result);
+    }
+#endif
+    for (; ii < count; ++ii)
+    {
+        next[ii] = (nearest[ii] == pos) ? pos : next[ii];
+        nearest[ii] = NearerEdge(nearest[ii], next[ii], pos);
+    }
+}
+
+void FindVerticalEdges(const uint8_t* luminance, int32_t cx, int32_t cy, int32_t y, uint8_t* strong)
+{
+    const uint8_t* const above = luminance + std::max<int32_t>(y - 1, 0) * cx;
+    const uint8_t* const row = luminance + y * cx;
+    const uint8_t* const below = luminance + std::min<int32_t>(y + 1, cy - 1) * cx;
+
+    // There are no edges at the borders of the zoom area.
+    strong[0] = 0;
+    strong[cx] = 0;
+
+    int32_t xx = 1;
+#ifdef USE_SSE2
+    for (; xx + 8 <= cx; xx += 8)
+    {
+        const __m128i a = _mm_sub_epi16(Load8(above + xx), Load8(above + xx - 1));
+        const __m128i b = _mm_sub_epi16(Load8(row + xx), Load8(row + xx - 1));
+        const __m128i c = _mm_sub_epi16(Load8(below + xx), Load8(below + xx - 1));
+        StoreStrong(a, b, c, strong + xx);
+    }
+#endif
+    for (; xx < cx; ++xx)
+    {
+        strong[xx] = IsStrong(above[xx] - above[xx - 1], row[xx] - row[xx - 1], below[xx] - below[xx - 1]);
+    }
+}
+
+void FindHorizontalEdges(const uint8_t* luminance, int32_t cx, int32_t y, uint8_t* strong)
+{
+    const uint8_t* const above = luminance + (y - 1) * cx;
+    const uint8_t* const row = luminance + y * cx;
+
+    auto diff = [&](int32_t x)
+    {
+        x = std::min<int32_t>(std::max<int32_t>(x, 0), cx - 1);
+        return int32_t(row[x]) - int32_t(above[x]);
+    };
+
+    strong[0] = IsStrong(diff(-1), diff(0), diff(1));
+    int32_t xx = 1;
+#ifdef USE_SSE2
+    for (; xx + 9 <= cx; xx += 8)
+    {
+        const __m128i a = _mm_sub_epi16(Load8(row + xx - 1), Load8(above + xx - 1));
+        const __m128i b = _mm_sub_epi16(Load8(row + xx), Load8(above + xx));
+        const __m128i c = _mm_sub_epi16(Load8(row + xx + 1), Load8(above + xx + 1));
+        StoreStrong(a, b, c, strong + xx);
+    }
+#endif
+    for (; xx < cx; ++xx)
+        strong[xx] = IsStrong(diff(xx - 1), diff(xx), diff(xx + 1));
+}
+
+void EdgeMap::Reset()
+{
+    m_x = m_y = m_cx = m_cy = 0;
+    m_nearest_x.clear();
+    m_nearest_y.clear();
+}
+
+void EdgeMap::Build(const PixelSource& src, int32_t x, int32_t y)
+{
+    m_x = x;
+    m_y = y;
+    m_cx = std::max<int32_t>(src.cx, 0);
+    m_cy = std::max<int32_t>(src.cy, 0);
+
+    const int32_t cx = m_cx;
+    const int32_t cy = m_cy;
+    m_luminance.resize(size_t(cx) * cy);
+    for (int32_t yy = 0; yy < cy; ++yy)
+        ComputeLuminance(src.bits + yy * src.stride, cx, &m_luminance[size_t(yy) * cx]);
+
+    // Nearest vertical edge to each corner, per pixel row:  the last edge at
+    // or before the corner, then the first edge at or after it if nearer.
+    m_strong.resize(size_t(cx) + 1);
+    m_nearest_x.resize((size_t(cx) + 1) * cy);
+    for (int32_t yy = 0; yy < cy; ++yy)
+    {
+        FindVerticalEdges(m_luminance.data(), cx, cy, yy, m_strong.data());
+
+        int16_t* const nearest = &m_nearest_x[size_t(yy) * (cx + 1)];
+        int16_t last = -1;
+        for (int32_t xx = 0; xx <= cx; ++xx)
+        {
+            last = m_strong[xx] ? int16_t(xx) : last;
+            nearest[xx] = last;
+        }
+        int16_t next = -1;
+        for (int32_t xx = cx; xx >= 0; --xx)
+        {
+            next = m_strong[xx] ? int16_t(xx) : next;
+            nearest[xx] = NearerEdge(nearest[xx], next, int16_t(xx));
+        }
+    }
+
+    // Nearest horizontal edge to each corner, per pixel column.  Going down
+    // row by row keeps the passes cache friendly.
+    m_nearest_y.resize((size_t(cy) + 1) * cx);
+    if (!cx)
+        return;
+    m_strong.resize(size_t(cx));
+    std::fill(m_nearest_y.begin(), m_nearest_y.begin() + cx, int16_t(-1));
+    for (int32_t yy = 1; yy <= cy; ++yy)
+    {
+        int16_t* const nearest = &m_nearest_y[size_t(yy) * cx];
+        if (yy < cy)
+        {
+            FindHorizontalEdges(m_luminance.data(), cx, yy, m_strong.data());
+            ForwardSweep(m_strong.data(), nearest - cx, int16_t(yy), cx, nearest);
+        }
+        else
+        {
+            std::copy(nearest - cx, nearest, nearest);
+        }
+    }
+
+    std::vector<int16_t> next(cx, -1);
+    for (int32_t yy = cy; yy >= 0; --yy)
+        BackwardSweep(&m_nearest_y[size_t(yy) * cx], next.data(), int16_t(yy), cx);
+}
+
+bool EdgeMap::IsFor(int32_t x, int32_t y, int32_t cx, int32_t cy) const
+{
+    return (x == m_x && y == m_y && cx == m_cx && cy == m_cy && !m_nearest_x.empty());
+}
+
+void EdgeMap::Snap(int32_t& x, int32_t& y, int32_t row, int32_t column, int32_t radius) const
+{
+    if (m_cx <= 0 || m_cy <= 0)
+        return;
+
+    x = std::min<int32_t>(std::max<int32_t>(x, 0), m_cx);
+    y = std::min<int32_t>(std::max<int32_t>(y, 0), m_cy);
+    row = std::min<int32_t>(std::max<int32_t>(row, 0), m_cy - 1);
+    column = std::min<int32_t>(std::max<int32_t>(column, 0), m_cx - 1);
+
+    const int32_t nx = m_nearest_x[size_t(row) * (m_cx + 1) + x];
+    const int32_t ny = m_nearest_y[size_t(y) * m_cx + column];
+    if (nx >= 0 && abs(nx - x) <= radius)
+        x = nx;
+    if (ny >= 0 && abs(ny - y) <= radius)
+        y = ny;
+}
+
+bool EdgeMap::IsVerticalEdge(int32_t x, int32_t row) const
+{
+    if (x < 0 || x > m_cx || row < 0 || row >= m_cy)
+        return false;
+    return m_nearest_x[size_t(row) * (m_cx + 1) + x] == x;
+}
+
+bool EdgeMap::IsHorizontalEdge(int32_t column, int32_t y) const
+{
+    if (column < 0 || column >= m_cx || y < 0 || y > m_cy)
+        return false;
+    return m_nearest_y[size_t(y) * m_cx + column] == y;
+}
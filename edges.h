@@ -0,0 +1,62 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+#include "pixels.h"
+
+//------------------------------------------------------------------------------
+// Edge map for snapping the measuring ruler.
+//
+// Edges lie on the boundaries between pixels, so that a snapped ruler measures
+// whole pixels:  a 10 pixel wide box measures 10 from its left edge to its
+// right edge.  The strength of the boundary between two neighboring pixels is
+// the Sobel derivative of luminance across it (the difference across the
+// boundary, smoothed 1-2-1 along it).
+//
+// After the edges are found, each pixel row gets a table of the nearest edge
+// to each corner in that row, and likewise each pixel column, so snapping is
+// a constant time lookup no matter how far away the nearest edge is.
+//
+// tests/edges_test.cpp checks that snapped rulers measure boxes exactly.
+
+// Sobel derivatives at least this strong are edges (the largest is 4 * 255).
+constexpr int32_t c_edge_threshold = 64;
+
+class EdgeMap
+{
+public:
+    void            Reset();
+
+    // Finds the edges in a newly captured frame of the zoom area at (x, y).
+    void            Build(const PixelSource& src, int32_t x, int32_t y);
+    bool            IsFor(int32_t x, int32_t y, int32_t cx, int32_t cy) const;
+
+    // Snaps a corner (x, y), relative to the zoom area, to the nearest
+    // vertical edge in pixel row `row` and the nearest horizontal edge in
+    // pixel column `column`, when they're no more than radius away.
+    void            Snap(int32_t& x, int32_t& y, int32_t row, int32_t column, int32_t radius) const;
+
+    // Whether the boundary left of pixel (x, row), or above pixel (column, y),
+    // is an edge.
+    bool            IsVerticalEdge(int32_t x, int32_t row) const;
+    bool            IsHorizontalEdge(int32_t column, int32_t y) const;
+
+private:
+    int32_t         m_x = 0;
+    int32_t         m_y = 0;
+    int32_t         m_cx = 0;
+    int32_t         m_cy = 0;
+    std::vector<uint8_t> m_luminance;
+    std::vector<uint8_t> m_strong;      // Scratch:  edge flags for one row of boundaries.
+    std::vector<int16_t> m_nearest_x;   // Per pixel row, per corner x:  nearest edge x, or -1.
+    std::vector<int16_t> m_nearest_y;   // Per corner y, per pixel column:  nearest edge y, or -1.
+};
+
+// Sobel derivatives across the boundaries left of each pixel in row y (for x
+// in 1 .. cx-1), and above each pixel in row y (for y >= 1), as edge flags.
+// Rows and columns past the border repeat the border.
+void FindVerticalEdges(const uint8_t* luminance, int32_t cx, int32_t cy, int32_t y, uint8_t* strong);
+void FindHorizontalEdges(const uint8_t* luminance, int32_t cx, int32_t y, uint8_t* strong);
@@ -0,0 +1,184 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "elements.h"
+
+constexpr uint32_t c_rgb_mask = 0x00ffffff;
+
+// Returns where the span of pixels[x]'s color that starts at x ends.
+static int32_t FindSpanEnd(const uint32_t* pixels, int32_t x, int32_t count)
+{
+    const uint32_t color = pixels[x] & c_rgb_mask;
+    ++x;
+#ifdef USE_SSE2
+    const __m128i mask = _mm_set1_epi32(c_rgb_mask);
+    const __m128i match = _mm_set1_epi32(color);
+    for (; x + 4 <= count; x += 4)
+    {
+        const __m128i v = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x)), mask);
+        int32_t same = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, match)));
+        if (same != 0xf)
+        {
+            while (same & 1)
+            {
+                ++x;
+                same >>= 1;
+            }
+            return x;
+        }
+    }
+#endif
+    while (x < count && (pixels[x] & c_rgb_mask) == color)
+        ++x;
+    return x;
+}
+
+void ElementFinder::Reset()
+{
+    m_x = m_y = m_cx = m_cy = 0;
+    m_found = false;
+    m_spans.clear();
+    m_rows.clear();
+    m_elements.clear();
+}
+
+void ElementFinder::Find(const PixelSource& src, int32_t x, int32_t y)
+{
+    m_x = x;
+    m_y = y;
+    m_cx = std::max<int32_t>(src.cx, 0);
+    m_cy = std::max<int32_t>(src.cy, 0);
+    m_found = true;
+    m_spans.clear();
+    m_rows.clear();
+    m_elements.clear();
+
+    // Run-length encode each row.
+    for (int32_t yy = 0; yy < m_cy; ++yy)
+    {
+        m_rows.push_back(int32_t(m_spans.size()));
+        const uint32_t* const row = src.bits + yy * src.stride;
+        for (int32_t xx = 0; xx < m_cx;)
+        {
+            const int32_t end = FindSpanEnd(row, xx, m_cx);
+            m_spans.push_back({ xx, end, row[xx] & c_rgb_mask });
+            xx = end;
+        }
+        if (m_spans.size() > c_max_element_spans)
+        {
+            m_spans.clear();
+            m_rows.clear();
+            return;
+        }
+    }
+    m_rows.push_back(int32_t(m_spans.size()));
+
+    // Join spans of the same color that overlap in adjacent rows.  Neighboring
+    // spans in a row always differ in color, so that's all it takes.  The root
+    // of each region is its first span, so its top row is the root's row.
+    const int32_t count = int32_t(m_spans.size());
+    m_parent.resize(count);
+    for (int32_t ii = 0; ii < count; ++ii)
+        m_parent[ii] = ii;
+    for (int32_t yy = 1; yy < m_cy; ++yy)
+    {
+        int32_t above = m_rows[yy - 1];
+        int32_t below = m_rows[yy];
+        const int32_t above_end = m_rows[yy];
+        const int32_t below_end = m_rows[yy + 1];
+        while (above < above_end && below < below_end)
+        {
+            const Span& a = m_spans[above];
+            const Span& b = m_spans[below];
+            if (a.color == b.color)
+            {
+                const int32_t ra = FindRoot(above);
+                const int32_t rb = FindRoot(below);
+                if (ra < rb)
+                    m_parent[rb] = ra;
+                else if (rb < ra)
+                    m_parent[ra] = rb;
+            }
+            if (a.right <= b.right)
+                ++above;
+            if (b.right <= a.right)
+                ++below;
+        }
+    }
+
+    // Bounding boxes.  A root always comes before the rest of its spans.
+    m_regions.resize(count);
+    for (int32_t yy = 0; yy < m_cy; ++yy)
+    {
+        for (int32_t ii = m_rows[yy]; ii < m_rows[yy + 1]; ++ii)
+        {
+            const Span& span = m_spans[ii];
+            const int32_t root = FindRoot(ii);
+            m_parent[ii] = root;
+            Region& region = m_regions[root];
+            if (root == ii)
+            {
+                region = { span.left, yy, span.right, yy + 1, 0, 0 };
+                continue;
+            }
+            region.left = std::min(region.left, span.left);
+            region.right = std::max(region.right, span.right);
+            region.bottom = yy + 1;
+        }
+    }
+
+    // How much of each bounding box's outline is covered.  Only one span per
+    // row can touch each side.
+    for (int32_t yy = 0; yy < m_cy; ++yy)
+    {
+        for (int32_t ii = m_rows[yy]; ii < m_rows[yy + 1]; ++ii)
+        {
+            const Span& span = m_spans[ii];
+            Region& region = m_regions[m_parent[ii]];
+            if (yy == region.top || yy + 1 == region.bottom)
+                region.rows_covered += span.right - span.left;
+            region.columns_covered += (span.left == region.left) + (span.right == region.right);
+        }
+    }
+
+    // Elements are the regions with complete outlines, that are big enough and
+    // don't extend past the zoom area.
+    for (int32_t ii = 0; ii < count && m_elements.size() < c_max_elements; ++ii)
+    {
+        if (m_parent[ii] != ii)
+            continue;
+        const Region& region = m_regions[ii];
+        const int32_t cx = region.right - region.left;
+        const int32_t cy = region.bottom - region.top;
+        if (cx < c_min_element_size || cy < c_min_element_size)
+            continue;
+        if (region.left <= 0 || region.top <= 0 || region.right >= m_cx || region.bottom >= m_cy)
+            continue;
+        if (region.rows_covered != 2 * cx || region.columns_covered != 2 * cy)
+            continue;
+        m_elements.push_back({ region.left, region.top, region.right, region.bottom });
+    }
+}
+
+bool ElementFinder::IsFor(int32_t x, int32_t y, int32_t cx, int32_t cy) const
+{
+    return (m_found && x == m_x && y == m_y && cx == m_cx && cy == m_cy);
+}
+
+int32_t ElementFinder::FindRoot(int32_t span)
+{
+    // Path halving.
+    while (m_parent[span] != span)
+    {
+        m_parent[span] = m_parent[m_parent[span]];
+        span = m_parent[span];
+    }
+    return span;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#include "pixels.h"
+
+//------------------------------------------------------------------------------
+// Detecting rectangular UI elements (buttons, borders, text boxes, etc).
+//
+// Each row is run-length encoded into spans of one color, and spans of the
+// same color that touch in adjacent rows are joined with union-find into
+// connected regions.  A region is an element when its whole bounding box
+// outline is its color:  that's true of a filled button face (even with text
+// on it) and of a one pixel border, but not of text or photos.
+//
+// The work is proportional to the number of spans rather than pixels, so it
+// keeps up with dragging the zoom area around typical UI.
+//
+// tests/elements_test.cpp checks that filled and outlined boxes are found
+// exactly.
+
+// Smaller regions are usually parts of glyphs or icons.
+constexpr int32_t c_min_element_size = 4;
+// More elements than this are just clutter.
+constexpr size_t c_max_elements = 256;
+// Frames with more spans than this (e.g. photos) aren't UI; give up on them.
+constexpr size_t c_max_element_spans = 1 << 20;
+
+struct ElementRect
+{
+    int32_t         left;               // Relative to the zoom area.
+    int32_t         top;
+    int32_t         right;              // Exclusive.
+    int32_t         bottom;
+};
+
+class ElementFinder
+{
+public:
+    void            Reset();
+
+    // Finds the elements entirely inside a newly captured frame of the zoom
+    // area at (x, y), in order of their top edges.
+    void            Find(const PixelSource& src, int32_t x, int32_t y);
+    bool            IsFor(int32_t x, int32_t y, int32_t cx, int32_t cy) const;
+
+    const std::vector<ElementRect>& GetElements() const { return m_elements; }
+
+private:
+    struct Span
+    {
+        int32_t     left;
+        int32_t     right;              // Exclusive.
+        uint32_t    color;
+    };
+
+    struct Region
+    {
+        int32_t     left;
+        int32_t     top;
+        int32_t     right;              // Exclusive.
+        int32_t     bottom;             // Exclusive.
+        int32_t     rows_covered;       // Top and bottom rows.
+        int32_t     columns_covered;    // Left and right columns.
+    };
+
+    int32_t         FindRoot(int32_t span);
+
+    int32_t         m_x = 0;
+    int32_t         m_y = 0;
+    int32_t         m_cx = 0;
+    int32_t         m_cy = 0;
+    bool            m_found = false;
+    std::vector<Span> m_spans;
+    std::vector<int32_t> m_rows;        // Index of the first span in each row, plus the end.
+    std::vector<int32_t> m_parent;      // Union-find forest over spans.
+    std::vector<Region> m_regions;      // Indexed by root span.
+    std::vector<ElementRect> m_elements;
+};
@@ -0,0 +1,619 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+// Define NO_SSE2 to build (and test) only the scalar code.
+#if (defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)) && !defined(NO_SSE2)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "filters.h"
+
+// Matrix coefficients have 12 fraction bits.
+constexpr int32_t c_matrix_shift = 12;
+constexpr int32_t c_matrix_one = 1 << c_matrix_shift;
+
+// Pixels per chunk; a multiple of 8.
+constexpr int32_t c_chunk = 256;
+
+enum { PLANE_R, PLANE_G, PLANE_B, PLANE_A, PLANE_COUNT };
+
+// Luminance weights (Rec. 709), the same as for pixel labels.
+static const int16_t c_luminance[4] = { 54 * 16, 183 * 16, 19 * 16, 0 };
+
+// Color blindness simulation (Machado, Oliveira, and Fernandes 2009, severity
+// 1.0), applied to the gamma encoded values for speed.
+static const int16_t c_color_blindness[3][3][3] =
+{
+    {   // Protanopia.
+        { 624, 4311, -839 },
+        { 469, 3221, 406 },
+        { -16, -197, 4309 },
+    },
+    {   // Deuteranopia.
+        { 1505, 3525, -934 },
+        { 1147, 2755, 194 },
+        { -48, 176, 3968 },
+    },
+    {   // Tritanopia.
+        { 5143, -314, -732 },
+        { -321, 3813, 605 },
+        { 19, 2832, 1245 },
+    },
+};
+
+bool FilterHasParam(FilterKind kind)
+{
+    return kind == FK_THRESHOLD || kind == FK_GAMMA;
+}
+
+int32_t GetDefaultFilterParam(FilterKind kind)
+{
+    switch (kind)
+    {
+    case FK_THRESHOLD:  return 128;
+    case FK_GAMMA:      return 220;
+    default:            return 0;
+    }
+}
+
+int32_t ClampFilterParam(FilterKind kind, int32_t param)
+{
+    switch (kind)
+    {
+    case FK_THRESHOLD:  return std::min<int32_t>(std::max<int32_t>(param, 0), 255);
+    case FK_GAMMA:      return std::min<int32_t>(std::max<int32_t>(param, 10), 1000);
+    default:            return 0;
+    }
+}
+
+static uint8_t ApplyThreshold(int32_t value, int32_t level)
+{
+    return (value >= level) ? 255 : 0;
+}
+
+static uint8_t ApplyGamma(int32_t value, int32_t hundredths)
+{
+    return uint8_t(pow(value / 255.0, 100.0 / hundredths) * 255 + 0.5);
+}
+
+static int32_t ApplyMatrixRow(const int16_t* row, int32_t r, int32_t g, int32_t b, int32_t a)
+{
+    const int32_t sum = row[0] * r + row[1] * g + row[2] * b + row[3] * a;
+    return std::min<int32_t>(std::max<int32_t>((sum + c_matrix_one / 2) >> c_matrix_shift, 0), 255);
+}
+
+//------------------------------------------------------------------------------
+// Reference.
+
+void ApplyFilterReference(const FilterStep& step, const uint32_t* in, int32_t count, uint32_t* out)
+{
+    for (int32_t ii = 0; ii < count; ++ii)
+    {
+        const uint32_t p = in[ii];
+        int32_t a = p >> 24;
+        int32_t r = (p >> 16) & 0xff;
+        int32_t g = (p >> 8) & 0xff;
+        int32_t b = p & 0xff;
+
+        switch (step.kind)
+        {
+        case FK_RED:
+            g = b = r;
+            break;
+        case FK_GREEN:
+            r = b = g;
+            break;
+        case FK_BLUE:
+            r = g = b;
+            break;
+        case FK_ALPHA:
+            r = g = b = a;
+            break;
+        case FK_GRAYSCALE:
+        case FK_THRESHOLD:
+            r = g = b = ApplyMatrixRow(c_luminance, r, g, b, a);
+            if (step.kind == FK_THRESHOLD)
+                r = g = b = ApplyThreshold(r, ClampFilterParam(step.kind, step.param));
+            break;
+        case FK_INVERT:
+            r = 255 - r;
+            g = 255 - g;
+            b = 255 - b;
+            break;
+        case FK_GAMMA:
+            {
+                const int32_t gamma = ClampFilterParam(step.kind, step.param);
+                r = ApplyGamma(r, gamma);
+                g = ApplyGamma(g, gamma);
+                b = ApplyGamma(b, gamma);
+            }
+            break;
+        case FK_PROTANOPIA:
+        case FK_DEUTERANOPIA:
+        case FK_TRITANOPIA:
+            {
+                const int16_t (&m)[3][3] = c_color_blindness[step.kind - FK_PROTANOPIA];
+                const int16_t rows[3][4] =
+                {
+                    { m[0][0], m[0][1], m[0][2], 0 },
+                    { m[1][0], m[1][1], m[1][2], 0 },
+                    { m[2][0], m[2][1], m[2][2], 0 },
+                };
+                const int32_t r2 = ApplyMatrixRow(rows[0], r, g, b, a);
+                const int32_t g2 = ApplyMatrixRow(rows[1], r, g, b, a);
+                const int32_t b2 = ApplyMatrixRow(rows[2], r, g, b, a);
+                r = r2;
+                g = g2;
+                b = b2;
+            }
+            break;
+        default:
+            break;
+        }
+
+        out[ii] = (p & 0xff000000) | (uint32_t(r) << 16) | (uint32_t(g) << 8) | uint32_t(b);
+    }
+}
+
+//------------------------------------------------------------------------------
+// FilterPipeline.
+
+// Whether each output channel is exactly one input channel, and which (3 is
+// alpha).
+static bool IsSelector(const int16_t (&matrix)[3][4], int32_t (&columns)[3])
+{
+    for (int32_t out = 0; out < 3; ++out)
+    {
+        columns[out] = -1;
+        for (int32_t in = 0; in < 4; ++in)
+        {
+            if (!matrix[out][in])
+                continue;
+            if (matrix[out][in] != c_matrix_one || columns[out] >= 0)
+                return false;
+            columns[out] = in;
+        }
+        if (columns[out] < 0)
+            return false;
+    }
+    return true;
+}
+
+static bool HasEqualRows(const int16_t (&matrix)[3][4])
+{
+    return !memcmp(matrix[0], matrix[1], sizeof(matrix[0])) && !memcmp(matrix[0], matrix[2], sizeof(matrix[0]));
+}
+
+static bool HasEqualTables(const uint8_t (&table)[3][256])
+{
+    return !memcmp(table[0], table[1], sizeof(table[0])) && !memcmp(table[0], table[2], sizeof(table[0]));
+}
+
+static bool IsIdentity(const uint8_t (&table)[3][256])
+{
+    for (const auto& channel : table)
+    {
+        for (int32_t value = 0; value < 256; ++value)
+        {
+            if (channel[value] != value)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Returns where table steps from table[0] to table[255], or -1 if it isn't a
+// single step.
+static int16_t FindStep(const uint8_t (&table)[256])
+{
+    int32_t step = 0;
+    while (step < 256 && table[step] == table[0])
+        ++step;
+    for (int32_t value = step; value < 256; ++value)
+    {
+        if (table[value] != table[255])
+            return -1;
+    }
+    return int16_t(step);
+}
+
+// Folds second into first when that's exact:  when second selects channels
+// from first's output it takes first's rows, and when first only selected
+// channels second adds up its coefficients for each of them.
+static bool FoldMatrices(int16_t (&first)[3][4], const int16_t (&second)[3][4])
+{
+    int32_t columns[3];
+    int16_t rows[3][4] = {};
+    if (IsSelector(second, columns))
+    {
+        for (int32_t out = 0; out < 3; ++out)
+        {
+            if (columns[out] < 3)
+                memcpy(rows[out], first[columns[out]], sizeof(rows[out]));
+            else
+                rows[out][3] = c_matrix_one;
+        }
+    }
+    else if (IsSelector(first, columns))
+    {
+        for (int32_t out = 0; out < 3; ++out)
+        {
+            for (int32_t in = 0; in < 3; ++in)
+                rows[out][columns[in]] += second[out][in];
+            rows[out][3] += second[out][3];
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    memcpy(first, rows, sizeof(rows));
+    return true;
+}
+
+void FilterPipeline::Compile(const FilterStep* steps, size_t count)
+{
+    m_stages.clear();
+
+    for (size_t ii = 0; ii < count; ++ii)
+    {
+        const FilterKind kind = steps[ii].kind;
+        const int32_t param = ClampFilterParam(kind, steps[ii].param);
+
+        Stage stage = {};
+        switch (kind)
+        {
+        case FK_RED:
+        case FK_GREEN:
+        case FK_BLUE:
+        case FK_ALPHA:
+            for (auto& row : stage.matrix)
+                row[kind - FK_RED] = c_matrix_one;
+            AddStage(stage);
+            break;
+        case FK_GRAYSCALE:
+        case FK_THRESHOLD:
+            for (auto& row : stage.matrix)
+                memcpy(row, c_luminance, sizeof(row));
+            AddStage(stage);
+            if (kind == FK_THRESHOLD)
+            {
+                stage.lookup = true;
+                for (int32_t value = 0; value < 256; ++value)
+                    stage.table[0][value] = ApplyThreshold(value, param);
+                memcpy(stage.table[1], stage.table[0], sizeof(stage.table[0]));
+                memcpy(stage.table[2], stage.table[0], sizeof(stage.table[0]));
+                AddStage(stage);
+            }
+            break;
+        case FK_INVERT:
+        case FK_GAMMA:
+            stage.lookup = true;
+            for (int32_t value = 0; value < 256; ++value)
+                stage.table[0][value] = (kind == FK_INVERT) ? uint8_t(255 - value) : ApplyGamma(value, param);
+            memcpy(stage.table[1], stage.table[0], sizeof(stage.table[0]));
+            memcpy(stage.table[2], stage.table[0], sizeof(stage.table[0]));
+            AddStage(stage);
+            break;
+        case FK_PROTANOPIA:
+        case FK_DEUTERANOPIA:
+        case FK_TRITANOPIA:
+            for (int32_t out = 0; out < 3; ++out)
+            {
+                for (int32_t in = 0; in < 3; ++in)
+                    stage.matrix[out][in] = c_color_blindness[kind - FK_PROTANOPIA][out][in];
+            }
+            AddStage(stage);
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool gray = false;
+    for (Stage& stage : m_stages)
+    {
+        if (stage.lookup)
+        {
+            const bool equal = HasEqualTables(stage.table);
+            stage.single = gray && equal;
+            stage.step = equal ? FindStep(stage.table[0]) : -1;
+        }
+        gray = stage.gray;
+    }
+}
+
+// Stages are only folded when the result is exact, since each matrix clamps
+// and rounds:  lookup tables compose, some matrices fold (see FoldMatrices),
+// and a matrix that doesn't read alpha is a lookup table on gray pixels.
+// Identity tables are dropped.
+void FilterPipeline::AddStage(const Stage& next)
+{
+    Stage stage = next;
+    Stage* const last = m_stages.empty() ? nullptr : &m_stages.back();
+
+    if (!stage.lookup && last && !last->lookup && FoldMatrices(last->matrix, stage.matrix))
+    {
+        last->gray = HasEqualRows(last->matrix);
+        return;
+    }
+
+    if (!stage.lookup && last && last->gray && !stage.matrix[0][3] && !stage.matrix[1][3] && !stage.matrix[2][3])
+    {
+        stage.lookup = true;
+        for (int32_t out = 0; out < 3; ++out)
+        {
+            for (int32_t value = 0; value < 256; ++value)
+                stage.table[out][value] = uint8_t(ApplyMatrixRow(stage.matrix[out], value, value, value, 0));
+        }
+    }
+
+    if (stage.lookup)
+    {
+        if (last && last->lookup)
+        {
+            for (int32_t channel = 0; channel < 3; ++channel)
+            {
+                for (auto& value : last->table[channel])
+                    value = stage.table[channel][value];
+            }
+            last->gray = last->gray && HasEqualTables(stage.table);
+            if (IsIdentity(last->table))
+                m_stages.pop_back();
+            return;
+        }
+        if (IsIdentity(stage.table))
+            return;
+        stage.gray = last && last->gray && HasEqualTables(stage.table);
+    }
+    else
+    {
+        stage.gray = HasEqualRows(stage.matrix);
+    }
+
+    m_stages.push_back(stage);
+}
+
+static void LoadPlanes(const uint32_t* in, int32_t count, int16_t (&planes)[PLANE_COUNT][c_chunk])
+{
+    int32_t ii = 0;
+#ifdef USE_SSE2
+    const __m128i mask = _mm_set1_epi32(0xff);
+    auto store = [&](int32_t plane, __m128i lo, __m128i hi)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&planes[plane][ii]), _mm_packs_epi32(lo, hi));
+    };
+    for (; ii + 8 <= count; ii += 8)
+    {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + ii));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + ii + 4));
+        store(PLANE_R, _mm_and_si128(_mm_srli_epi32(lo, 16), mask), _mm_and_si128(_mm_srli_epi32(hi, 16), mask));
+        store(PLANE_G, _mm_and_si128(_mm_srli_epi32(lo, 8), mask), _mm_and_si128(_mm_srli_epi32(hi, 8), mask));
+        store(PLANE_B, _mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+        store(PLANE_A, _mm_srli_epi32(lo, 24), _mm_srli_epi32(hi, 24));
+    }
+#endif
+    for (; ii < count; ++ii)
+    {
+        const uint32_t p = in[ii];
+        planes[PLANE_R][ii] = int16_t((p >> 16) & 0xff);
+        planes[PLANE_G][ii] = int16_t((p >> 8) & 0xff);
+        planes[PLANE_B][ii] = int16_t(p & 0xff);
+        planes[PLANE_A][ii] = int16_t(p >> 24);
+    }
+}
+
+// The top byte of each pixel comes from in.
+static void StorePlanes(const int16_t (&planes)[PLANE_COUNT][c_chunk], const uint32_t* in, int32_t count, uint32_t* out)
+{
+    int32_t ii = 0;
+#ifdef USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i top = _mm_set1_epi32(0xff000000);
+    auto load = [&](int32_t plane)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(&planes[plane][ii]));
+    };
+    for (; ii + 8 <= count; ii += 8)
+    {
+        const __m128i r = load(PLANE_R);
+        const __m128i g = load(PLANE_G);
+        const __m128i b = load(PLANE_B);
+        // Interleave into B G R 0 words, then pack to bytes.
+        const __m128i bg_lo = _mm_unpacklo_epi16(b, g);
+        const __m128i bg_hi = _mm_unpackhi_epi16(b, g);
+        const __m128i r0_lo = _mm_unpacklo_epi16(r, zero);
+        const __m128i r0_hi = _mm_unpackhi_epi16(r, zero);
+        const __m128i p0 = _mm_packus_epi16(_mm_unpacklo_epi32(bg_lo, r0_lo), _mm_unpackhi_epi32(bg_lo, r0_lo));
+        const __m128i p1 = _mm_packus_epi16(_mm_unpacklo_epi32(bg_hi, r0_hi), _mm_unpackhi_epi32(bg_hi, r0_hi));
+        const __m128i a0 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + ii)), top);
+        const __m128i a1 = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + ii + 4)), top);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + ii), _mm_or_si128(p0, a0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + ii + 4), _mm_or_si128(p1, a1));
+    }
+#endif
+    for (; ii < count; ++ii)
+    {
+        out[ii] = ((in[ii] & 0xff000000) |
+                   (uint32_t(planes[PLANE_R][ii]) << 16) |
+                   (uint32_t(planes[PLANE_G][ii]) << 8) |
+                   uint32_t(planes[PLANE_B][ii]));
+    }
+}
+
+static void ApplyMatrix(const int16_t (&matrix)[3][4], int32_t count, int16_t (&planes)[PLANE_COUNT][c_chunk])
+{
+    int32_t ii = 0;
+#ifdef USE_SSE2
+    // Pairs of planes are interleaved so each multiply-add does two terms.
+    // The high coefficient is shifted as unsigned; shifting a negative int is
+    // undefined.
+    __m128i coeff_rg[3];
+    __m128i coeff_ba[3];
+    for (int32_t out = 0; out < 3; ++out)
+    {
+        coeff_rg[out] = _mm_set1_epi32(int32_t(uint32_t(uint16_t(matrix[out][0])) | (uint32_t(uint16_t(matrix[out][1])) << 16)));
+        coeff_ba[out] = _mm_set1_epi32(int32_t(uint32_t(uint16_t(matrix[out][2])) | (uint32_t(uint16_t(matrix[out][3])) << 16)));
+    }
+    const __m128i round = _mm_set1_epi32(c_matrix_one / 2);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    for (; ii + 8 <= count; ii += 8)
+    {
+        auto load = [&](int32_t plane)
+        {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(&planes[plane][ii]));
+        };
+        const __m128i r = load(PLANE_R);
+        const __m128i g = load(PLANE_G);
+        const __m128i b = load(PLANE_B);
+        const __m128i a = load(PLANE_A);
+        const __m128i rg_lo = _mm_unpacklo_epi16(r, g);
+        const __m128i rg_hi = _mm_unpackhi_epi16(r, g);
+        const __m128i ba_lo = _mm_unpacklo_epi16(b, a);
+        const __m128i ba_hi = _mm_unpackhi_epi16(b, a);
+
+        __m128i results[3];
+        for (int32_t out = 0; out < 3; ++out)
+        {
+            __m128i lo = _mm_add_epi32(_mm_madd_epi16(rg_lo, coeff_rg[out]), _mm_madd_epi16(ba_lo, coeff_ba[out]));
+            __m128i hi = _mm_add_epi32(_mm_madd_epi16(rg_hi, coeff_rg[out]), _mm_madd_epi16(ba_hi, coeff_ba[out]));
+            lo = _mm_srai_epi32(_mm_add_epi32(lo, round), c_matrix_shift);
+            hi = _mm_srai_epi32(_mm_add_epi32(hi, round), c_matrix_shift);
+            results[out] = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(lo, hi), zero), max);
+        }
+        for (int32_t out = 0; out < 3; ++out)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&planes[out][ii]), results[out]);
+    }
+#endif
+    for (; ii < count; ++ii)
+    {
+        const int32_t r = planes[PLANE_R][ii];
+        const int32_t g = planes[PLANE_G][ii];
+        const int32_t b = planes[PLANE_B][ii];
+        const int32_t a = planes[PLANE_A][ii];
+        for (int32_t out = 0; out < 3; ++out)
+            planes[out][ii] = int16_t(ApplyMatrixRow(matrix[out], r, g, b, a));
+    }
+}
+
+// When single, only the red plane is looked up, and copied to the others.
+static void ApplyLookup(const uint8_t (&table)[3][256], bool single, int32_t step, int32_t count, int16_t (&planes)[PLANE_COUNT][c_chunk])
+{
+    if (step >= 0)
+    {
+        // A step (e.g. threshold) is a compare and select.
+        const int16_t below = table[0][0];
+        const int16_t above = table[0][255];
+        for (int32_t channel = 0; channel < (single ? 1 : 3); ++channel)
+        {
+            int16_t* const plane = planes[channel];
+            int32_t ii = 0;
+#ifdef USE_SSE2
+            const __m128i level = _mm_set1_epi16(int16_t(step - 1));
+            const __m128i below_value = _mm_set1_epi16(below);
+            const __m128i above_value = _mm_set1_epi16(above);
+            for (; ii + 8 <= count; ii += 8)
+            {
+                __m128i* const p = reinterpret_cast<__m128i*>(plane + ii);
+                const __m128i mask = _mm_cmpgt_epi16(_mm_loadu_si128(p), level);
+                _mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(mask, above_value), _mm_andnot_si128(mask, below_value)));
+            }
+#endif
+            for (; ii < count; ++ii)
+                plane[ii] = (plane[ii] >= step) ? above : below;
+        }
+    }
+    else
+    {
+        // The tables are bytes, which may alias the planes; reading each
+        // group of indices before storing any results lets the loads overlap.
+        int16_t* const r = planes[PLANE_R];
+        int16_t* const g = planes[PLANE_G];
+        int16_t* const b = planes[PLANE_B];
+        int32_t ii = 0;
+        if (single)
+        {
+            for (; ii + 4 <= count; ii += 4)
+            {
+                const int16_t r0 = r[ii], r1 = r[ii + 1], r2 = r[ii + 2], r3 = r[ii + 3];
+                r[ii] = table[0][r0];
+                r[ii + 1] = table[0][r1];
+                r[ii + 2] = table[0][r2];
+                r[ii + 3] = table[0][r3];
+            }
+        }
+        else
+        {
+            for (; ii + 2 <= count; ii += 2)
+            {
+                const int16_t r0 = r[ii], r1 = r[ii + 1];
+                const int16_t g0 = g[ii], g1 = g[ii + 1];
+                const int16_t b0 = b[ii], b1 = b[ii + 1];
+                r[ii] = table[0][r0];
+                r[ii + 1] = table[0][r1];
+                g[ii] = table[1][g0];
+                g[ii + 1] = table[1][g1];
+                b[ii] = table[2][b0];
+                b[ii + 1] = table[2][b1];
+            }
+        }
+        for (; ii < count; ++ii)
+        {
+            r[ii] = table[0][r[ii]];
+            if (!single)
+            {
+                g[ii] = table[1][g[ii]];
+                b[ii] = table[2][b[ii]];
+            }
+        }
+    }
+
+    if (single)
+    {
+        memcpy(planes[PLANE_G], planes[PLANE_R], count * sizeof(planes[0][0]));
+        memcpy(planes[PLANE_B], planes[PLANE_R], count * sizeof(planes[0][0]));
+    }
+}
+
+void FilterPipeline::ApplyRow(const uint32_t* in, int32_t count, uint32_t* out) const
+{
+    if (m_stages.empty())
+    {
+        memmove(out, in, count * sizeof(*out));
+        return;
+    }
+
+    int16_t planes[PLANE_COUNT][c_chunk];
+    for (int32_t start = 0; start < count; start += c_chunk)
+    {
+        const int32_t n = std::min<int32_t>(c_chunk, count - start);
+        LoadPlanes(in + start, n, planes);
+        for (const Stage& stage : m_stages)
+        {
+            if (stage.lookup)
+                ApplyLookup(stage.table, stage.single, stage.step, n, planes);
+            else
+                ApplyMatrix(stage.matrix, n, planes);
+        }
+        StorePlanes(planes, in + start, n, out + start);
+    }
+}
+
+void FilterPipeline::Apply(const PixelSource& src, std::vector<uint32_t>& pixels, PixelSource& out) const
+{
+    pixels.resize(size_t(src.cx) * src.cy);
+    for (int32_t yy = 0; yy < src.cy; ++yy)
+        ApplyRow(src.bits + yy * src.stride, src.cx, &pixels[size_t(yy) * src.cx]);
+
+    out.bits = pixels.data();
+    out.stride = src.cx;
+    out.cx = src.cx;
+    out.cy = src.cy;
+}
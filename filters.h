@@ -0,0 +1,92 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#include "pixels.h"
+
+//------------------------------------------------------------------------------
+// Pixel filters.
+//
+// A chain of filters is applied to the zoom area before scaling.  Each filter
+// compiles to a color matrix stage (channel isolation, grayscale, color
+// blindness simulation), a per-channel lookup table stage (inversion, gamma),
+// or both (threshold).
+//
+// Stages are folded only where the result stays bit-identical to applying the
+// filters one at a time:  adjacent lookup tables compose into one table; a
+// matrix that only selects channels folds into its neighboring matrix; and a
+// matrix applied to gray pixels becomes a lookup table (so e.g. grayscale
+// then threshold leaves no second matrix at all).  Tables that are steps,
+// like threshold, are applied with compares rather than lookups, and tables
+// applied to gray pixels look up one channel instead of three.
+//
+// The whole chain runs on a chunk of pixels at a time, kept in L1 cache as
+// 16-bit planes, so the zoom area is read and written only once.  Each stage
+// that remains still costs a pass over the chunk, so a long chain costs more
+// than a single filter; see the FilterChains benchmark.
+//
+// tests/filters_test.cpp checks FilterPipeline against ApplyFilterReference,
+// with and without SSE2.
+
+enum FilterKind
+{
+    FK_NONE,
+    FK_RED,                             // Show one channel as gray.
+    FK_GREEN,
+    FK_BLUE,
+    FK_ALPHA,
+    FK_GRAYSCALE,
+    FK_INVERT,
+    FK_THRESHOLD,                       // param:  luminance 0-255 that becomes white.
+    FK_GAMMA,                           // param:  gamma in hundredths.
+    FK_PROTANOPIA,                      // Color blindness simulation.
+    FK_DEUTERANOPIA,
+    FK_TRITANOPIA,
+    FK_COUNT
+};
+
+constexpr size_t c_max_filters = 5;
+
+struct FilterStep
+{
+    FilterKind      kind = FK_NONE;
+    int32_t         param = 0;
+};
+
+bool FilterHasParam(FilterKind kind);
+int32_t GetDefaultFilterParam(FilterKind kind);
+int32_t ClampFilterParam(FilterKind kind, int32_t param);
+
+class FilterPipeline
+{
+public:
+    void            Compile(const FilterStep* steps, size_t count);
+    bool            IsEmpty() const { return m_stages.empty(); }
+    size_t          GetStageCount() const { return m_stages.size(); }
+
+    void            ApplyRow(const uint32_t* in, int32_t count, uint32_t* out) const;
+    // Filters src into pixels.  Returns the filtered pixels as out.
+    void            Apply(const PixelSource& src, std::vector<uint32_t>& pixels, PixelSource& out) const;
+
+private:
+    struct Stage
+    {
+        bool        lookup;             // Else a matrix.
+        bool        gray;               // Output R, G, B are equal.
+        bool        single;             // Lookups:  input R, G, B are equal and so are the tables.
+        int16_t     step;               // Lookups:  if not -1, each table is table[0] below step and table[255] from it on.
+        int16_t     matrix[3][4];       // Output R, G, B from input R, G, B, A; 12 fraction bits.
+        uint8_t     table[3][256];      // Output R, G, B.
+    };
+
+    void            AddStage(const Stage& stage);
+
+    std::vector<Stage> m_stages;
+};
+
+// Applies one filter, one pixel at a time; for checking FilterPipeline.
+void ApplyFilterReference(const FilterStep& step, const uint32_t* in, int32_t count, uint32_t* out);
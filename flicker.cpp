@@ -0,0 +1,152 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "flicker.h"
+
+static uint8_t DecayCounter(uint8_t counter)
+{
+    const int32_t decay = std::max<int32_t>(1, counter >> 4);
+    return uint8_t(std::max<int32_t>(0, counter - decay));
+}
+
+void UpdateFlickerCounters(const uint32_t* current, uint32_t* previous, uint8_t* counters, int32_t count)
+{
+    int32_t ii = 0;
+#ifdef USE_SSE2
+    const __m128i rgb = _mm_set1_epi32(0x00ffffff);
+    const __m128i low_nibbles = _mm_set1_epi8(0x0f);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i hit = _mm_set1_epi8(char(c_flicker_hit));
+    auto changed4 = [&](int32_t offset)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + offset));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(previous + offset), a);
+        // All ones in each lane whose pixel is unchanged.
+        return _mm_cmpeq_epi32(_mm_and_si128(_mm_xor_si128(a, b), rgb), _mm_setzero_si128());
+    };
+    for (; ii + 16 <= count; ii += 16)
+    {
+        // Narrow the per-pixel lane masks to one byte per pixel.
+        const __m128i same01 = _mm_packs_epi32(changed4(ii), changed4(ii + 4));
+        const __m128i same23 = _mm_packs_epi32(changed4(ii + 8), changed4(ii + 12));
+        const __m128i same = _mm_packs_epi16(same01, same23);
+
+        // SSE2 has no byte shifts, so shift words and mask off the bits that
+        // crossed over from the neighboring byte.
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(counters + ii));
+        c = _mm_subs_epu8(c, _mm_max_epu8(_mm_and_si128(_mm_srli_epi16(c, 4), low_nibbles), one));
+        c = _mm_adds_epu8(c, _mm_andnot_si128(same, hit));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(counters + ii), c);
+    }
+#endif
+    for (; ii < count; ++ii)
+    {
+        uint8_t counter = DecayCounter(counters[ii]);
+        if ((current[ii] ^ previous[ii]) & 0x00ffffff)
+            counter = uint8_t(std::min<int32_t>(0xff, counter + c_flicker_hit));
+        counters[ii] = counter;
+        previous[ii] = current[ii];
+    }
+}
+
+void CompositeFlicker(const uint32_t* current, const uint8_t* counters, int32_t count, uint32_t* out)
+{
+    int32_t ii = 0;
+#ifdef USE_SSE2
+    const __m128i red = _mm_set1_epi32(0x00ff0000);
+    const __m128i green_blue = _mm_set1_epi32(0x0000ffff);
+    auto tint4 = [&](int32_t offset, __m128i k)
+    {
+        // k has each pixel's counter in all four of its bytes.
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + offset));
+        const __m128i raised = _mm_max_epu8(v, _mm_and_si128(k, red));
+        const __m128i limit = _mm_or_si128(_mm_andnot_si128(k, green_blue), _mm_andnot_si128(green_blue, _mm_set1_epi32(-1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + offset), _mm_min_epu8(raised, limit));
+    };
+    for (; ii + 16 <= count; ii += 16)
+    {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(counters + ii));
+        const __m128i c_lo = _mm_unpacklo_epi8(c, c);
+        const __m128i c_hi = _mm_unpackhi_epi8(c, c);
+        tint4(ii, _mm_unpacklo_epi16(c_lo, c_lo));
+        tint4(ii + 4, _mm_unpackhi_epi16(c_lo, c_lo));
+        tint4(ii + 8, _mm_unpacklo_epi16(c_hi, c_hi));
+        tint4(ii + 12, _mm_unpackhi_epi16(c_hi, c_hi));
+    }
+#endif
+    for (; ii < count; ++ii)
+    {
+        const uint32_t p = current[ii];
+        const uint32_t k = counters[ii];
+        const uint32_t r = std::max<uint32_t>((p >> 16) & 0xff, k);
+        const uint32_t g = std::min<uint32_t>((p >> 8) & 0xff, 0xff - k);
+        const uint32_t b = std::min<uint32_t>(p & 0xff, 0xff - k);
+        out[ii] = (p & 0xff000000) | (r << 16) | (g << 8) | b;
+    }
+}
+
+//------------------------------------------------------------------------------
+// FlickerTracker.
+
+void FlickerTracker::Reset()
+{
+    m_cx = 0;
+    m_cy = 0;
+}
+
+void FlickerTracker::Update(const PixelSource& src, int32_t x, int32_t y)
+{
+    if (src.cx <= 0 || src.cy <= 0)
+    {
+        Reset();
+        return;
+    }
+
+    const size_t count = size_t(src.cx) * src.cy;
+    if (x != m_x || y != m_y || src.cx != m_cx || src.cy != m_cy)
+    {
+        m_x = x;
+        m_y = y;
+        m_cx = src.cx;
+        m_cy = src.cy;
+        m_previous.resize(count);
+        for (int32_t yy = 0; yy < src.cy; ++yy)
+            memcpy(&m_previous[size_t(yy) * src.cx], src.bits + yy * src.stride, src.cx * sizeof(*src.bits));
+        m_counters.assign(count, 0);
+        return;
+    }
+
+    for (int32_t yy = 0; yy < src.cy; ++yy)
+    {
+        const size_t offset = size_t(yy) * src.cx;
+        UpdateFlickerCounters(src.bits + yy * src.stride, &m_previous[offset], &m_counters[offset], src.cx);
+    }
+}
+
+bool FlickerTracker::GetOverlay(const PixelSource& src, int32_t x, int32_t y, PixelSource& overlay)
+{
+    if (x != m_x || y != m_y || src.cx != m_cx || src.cy != m_cy || !m_cx || !m_cy)
+        return false;
+
+    m_overlay.resize(size_t(src.cx) * src.cy);
+    for (int32_t yy = 0; yy < src.cy; ++yy)
+    {
+        const size_t offset = size_t(yy) * src.cx;
+        CompositeFlicker(src.bits + yy * src.stride, &m_counters[offset], src.cx, &m_overlay[offset]);
+    }
+
+    overlay.bits = m_overlay.data();
+    overlay.stride = src.cx;
+    overlay.cx = src.cx;
+    overlay.cy = src.cy;
+    return true;
+}
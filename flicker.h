@@ -0,0 +1,53 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+#include "pixels.h"
+
+//------------------------------------------------------------------------------
+// Repaint flicker detector.
+//
+// Each captured frame is compared with the previous one, and every pixel has a
+// saturating 8-bit counter:  all counters decay by 1/16 (and at least 1) per
+// frame, and pixels that changed gain c_flicker_hit.  A pixel that changes
+// every frame saturates in a few frames, and one that changed once fades out
+// over about a second at typical refresh rates.
+//
+// The overlay tints pixels toward red by their counters, before scaling, so
+// it works with every renderer.
+
+constexpr uint8_t c_flicker_hit = 64;
+
+// Decays counters, adds hits for pixels that differ from previous, and copies
+// current over previous, in one pass.
+void UpdateFlickerCounters(const uint32_t* current, uint32_t* previous, uint8_t* counters, int32_t count);
+
+// Writes current tinted by counters:  red is raised to at least the counter,
+// and green and blue are lowered to at most 255 minus the counter.
+void CompositeFlicker(const uint32_t* current, const uint8_t* counters, int32_t count, uint32_t* out);
+
+class FlickerTracker
+{
+public:
+    void            Reset();
+
+    // Compares a newly captured frame of the zoom area at (x, y) with the
+    // previous one.  Moving or resizing the zoom area starts over.
+    void            Update(const PixelSource& src, int32_t x, int32_t y);
+
+    // Tints src by the counters into an internal buffer.  Returns false if
+    // the counters aren't for this zoom area.
+    bool            GetOverlay(const PixelSource& src, int32_t x, int32_t y, PixelSource& overlay);
+
+private:
+    int32_t         m_x = 0;
+    int32_t         m_y = 0;
+    int32_t         m_cx = 0;
+    int32_t         m_cy = 0;
+    std::vector<uint32_t> m_previous;
+    std::vector<uint8_t> m_counters;
+    std::vector<uint32_t> m_overlay;
+};
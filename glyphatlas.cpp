@@ -0,0 +1,176 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <dwrite.h>
+#include <wrl/client.h>
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "glyphatlas.h"
+
+using Microsoft::WRL::ComPtr;
+
+// Smaller glyphs aren't legible.
+constexpr int32_t c_min_em_pixels = 5;
+constexpr size_t c_max_cached_atlases = 4;
+
+struct CachedAtlas
+{
+    std::wstring    family;
+    WORD            dpi;
+    int32_t         max_slot_cx;
+    int32_t         max_slot_cy;
+    bool            valid;              // False if it couldn't be built.
+    GlyphAtlas      atlas;
+};
+
+// Most recently used first.
+static std::vector<std::unique_ptr<CachedAtlas>> s_atlases;
+static uint32_t s_generation = 0;
+
+static IDWriteFactory* GetDWriteFactory()
+{
+    static ComPtr<IDWriteFactory> s_factory;
+    static bool s_tried = false;
+    if (!s_tried)
+    {
+        s_tried = true;
+        DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory),
+                            reinterpret_cast<IUnknown**>(s_factory.GetAddressOf()));
+    }
+    return s_factory.Get();
+}
+
+static bool CreateFontFace(IDWriteFactory* factory, const WCHAR* family, ComPtr<IDWriteFontFace>& face)
+{
+    ComPtr<IDWriteFontCollection> collection;
+    if (FAILED(factory->GetSystemFontCollection(collection.GetAddressOf())))
+        return false;
+
+    UINT32 index;
+    BOOL exists = false;
+    if (FAILED(collection->FindFamilyName(family, &index, &exists)) || !exists)
+        return false;
+
+    ComPtr<IDWriteFontFamily> fontFamily;
+    ComPtr<IDWriteFont> font;
+    return (SUCCEEDED(collection->GetFontFamily(index, fontFamily.GetAddressOf())) &&
+            SUCCEEDED(fontFamily->GetFirstMatchingFont(DWRITE_FONT_WEIGHT_NORMAL, DWRITE_FONT_STRETCH_NORMAL, DWRITE_FONT_STYLE_NORMAL, font.GetAddressOf())) &&
+            SUCCEEDED(font->CreateFontFace(face.GetAddressOf())));
+}
+
+static bool BuildGlyphAtlas(const WCHAR* family, int32_t max_slot_cx, int32_t max_slot_cy, GlyphAtlas& atlas)
+{
+    IDWriteFactory* const factory = GetDWriteFactory();
+    ComPtr<IDWriteFontFace> face;
+    if (!factory || !CreateFontFace(factory, family, face))
+        return false;
+
+    DWRITE_FONT_METRICS fm;
+    face->GetMetrics(&fm);
+
+    UINT32 codepoints[c_label_glyph_count];
+    UINT16 indices[c_label_glyph_count];
+    DWRITE_GLYPH_METRICS gm[c_label_glyph_count];
+    for (int32_t ii = 0; ii < c_label_glyph_count; ++ii)
+        codepoints[ii] = UINT32(c_label_glyphs[ii]);
+    if (FAILED(face->GetGlyphIndices(codepoints, c_label_glyph_count, indices)) ||
+        FAILED(face->GetDesignGlyphMetrics(indices, c_label_glyph_count, gm)))
+        return false;
+
+    UINT32 advance = 0;
+    for (const auto& metrics : gm)
+        advance = std::max<UINT32>(advance, metrics.advanceWidth);
+    if (!advance || !fm.capHeight)
+        return false;
+
+    // Digits and capital letters have no descenders, so each slot only needs
+    // the cap height, plus a pixel to separate the lines.
+    const double du = fm.designUnitsPerEm;
+    auto slotCx = [&](int32_t em) { return int32_t(ceil(advance * em / du)); };
+    auto slotCy = [&](int32_t em) { return int32_t(ceil(fm.capHeight * em / du)) + 1; };
+
+    int32_t em = int32_t(std::min<double>(max_slot_cx * du / advance, max_slot_cy * du / fm.capHeight));
+    while (em >= c_min_em_pixels && (slotCx(em) > max_slot_cx || slotCy(em) > max_slot_cy))
+        --em;
+    if (em < c_min_em_pixels)
+        return false;
+
+    atlas.slot_cx = slotCx(em);
+    atlas.slot_cy = slotCy(em);
+    atlas.coverage.assign(size_t(atlas.GetStride()) * atlas.slot_cy, 0);
+    atlas.generation = ++s_generation;
+
+    // Aliased glyphs stay crisp at these sizes, and their alpha texture is
+    // directly usable as coverage.
+    const FLOAT baseline = FLOAT(atlas.slot_cy - 1);
+    std::vector<BYTE> texture;
+    for (int32_t ii = 0; ii < c_label_glyph_count; ++ii)
+    {
+        DWRITE_GLYPH_RUN run = {};
+        run.fontFace = face.Get();
+        run.fontEmSize = FLOAT(em);
+        run.glyphCount = 1;
+        run.glyphIndices = &indices[ii];
+
+        const int32_t slot_left = ii * atlas.slot_cx;
+        ComPtr<IDWriteGlyphRunAnalysis> analysis;
+        if (FAILED(factory->CreateGlyphRunAnalysis(&run, 1.0f, nullptr, DWRITE_RENDERING_MODE_ALIASED, DWRITE_MEASURING_MODE_NATURAL,
+                                                   FLOAT(slot_left), baseline, analysis.GetAddressOf())))
+            return false;
+
+        RECT rc;
+        if (FAILED(analysis->GetAlphaTextureBounds(DWRITE_TEXTURE_ALIASED_1x1, &rc)))
+            return false;
+        if (rc.right <= rc.left || rc.bottom <= rc.top)
+            continue;
+
+        const LONG cx = rc.right - rc.left;
+        texture.resize(size_t(cx) * (rc.bottom - rc.top));
+        if (FAILED(analysis->CreateAlphaTexture(DWRITE_TEXTURE_ALIASED_1x1, &rc, texture.data(), UINT32(texture.size()))))
+            return false;
+
+        // Clip to the glyph's slot.
+        const LONG left = std::max<LONG>(rc.left, slot_left);
+        const LONG right = std::min<LONG>(rc.right, slot_left + atlas.slot_cx);
+        const LONG top = std::max<LONG>(rc.top, 0);
+        const LONG bottom = std::min<LONG>(rc.bottom, atlas.slot_cy);
+        for (LONG yy = top; yy < bottom; ++yy)
+        {
+            for (LONG xx = left; xx < right; ++xx)
+                atlas.coverage[yy * atlas.GetStride() + xx] = texture[(yy - rc.top) * cx + (xx - rc.left)];
+        }
+    }
+
+    return true;
+}
+
+const GlyphAtlas* GetGlyphAtlas(const WCHAR* family, WORD dpi, int32_t max_slot_cx, int32_t max_slot_cy)
+{
+    for (size_t ii = 0; ii < s_atlases.size(); ++ii)
+    {
+        const CachedAtlas& cached = *s_atlases[ii];
+        if (cached.dpi == dpi && cached.max_slot_cx == max_slot_cx && cached.max_slot_cy == max_slot_cy && cached.family == family)
+        {
+            std::rotate(s_atlases.begin(), s_atlases.begin() + ii, s_atlases.begin() + ii + 1);
+            return s_atlases[0]->valid ? &s_atlases[0]->atlas : nullptr;
+        }
+    }
+
+    std::unique_ptr<CachedAtlas> cached(new CachedAtlas);
+    cached->family = family;
+    cached->dpi = dpi;
+    cached->max_slot_cx = max_slot_cx;
+    cached->max_slot_cy = max_slot_cy;
+    cached->valid = BuildGlyphAtlas(family, max_slot_cx, max_slot_cy, cached->atlas);
+
+    if (s_atlases.size() >= c_max_cached_atlases)
+        s_atlases.pop_back();
+    s_atlases.insert(s_atlases.begin(), std::move(cached));
+    return s_atlases[0]->valid ? &s_atlases[0]->atlas : nullptr;
+}
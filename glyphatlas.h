@@ -0,0 +1,15 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "labels.h"
+
+//------------------------------------------------------------------------------
+// Returns a glyph atlas for pixel value labels, rasterized with DirectWrite at
+// the largest size of the font whose glyphs fit in max_slot_cx by max_slot_cy
+// pixels.  Atlases are cached by font, DPI, and size, so each is only built
+// once.  Returns null if DirectWrite or the font is unavailable, or the glyphs
+// would be too small to read.
+
+const GlyphAtlas* GetGlyphAtlas(const WCHAR* family, WORD dpi, int32_t max_slot_cx, int32_t max_slot_cy);
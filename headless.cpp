@@ -0,0 +1,348 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <shellapi.h>
+#include <wincodec.h>
+#include <wrl/client.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "headless.h"
+#include "capture.h"
+#include "console.h"
+#include "moncache.h"
+#include "perf.h"
+#include "scaler.h"
+#include "threadpool.h"
+
+using Microsoft::WRL::ComPtr;
+
+constexpr int32_t c_max_factor = 32;
+constexpr uint64_t c_max_output_pixels = 128 * 1024 * 1024;   // 512 MB of output.
+
+struct CaptureRequest
+{
+    RECT            rc = {};
+    int32_t         factor = 1;
+    int32_t         minor = 0;
+    int32_t         major = 0;
+    uint32_t        color = 0;          // 0x00RRGGBB, like DIB pixels.
+    bool            reference = false;
+    std::wstring    output;
+};
+
+static bool ParseRect(const WCHAR* arg, RECT& rc)
+{
+    LONG values[4];
+    for (LONG& value : values)
+    {
+        WCHAR* end;
+        value = wcstol(arg, &end, 10);
+        if (end == arg || (*end && *end != ','))
+            return false;
+        arg = *end ? end + 1 : end;
+    }
+
+    if (*arg || values[2] <= 0 || values[3] <= 0)
+        return false;
+
+    rc.left = values[0];
+    rc.top = values[1];
+    rc.right = values[0] + values[2];
+    rc.bottom = values[1] + values[3];
+    return true;
+}
+
+static bool ParseRequest(int argc, WCHAR** argv, CaptureRequest& req)
+{
+    if (argc < 3 || !ParseRect(argv[0], req.rc))
+        return false;
+
+    req.factor = _wtoi(argv[1]);
+    if (req.factor < 1 || req.factor > c_max_factor)
+        return false;
+
+    req.output = argv[2];
+
+    for (int ii = 3; ii < argc; ++ii)
+    {
+        const WCHAR* const option = argv[ii];
+        if (!wcscmp(option, L"--reference"))
+        {
+            req.reference = true;
+            continue;
+        }
+
+        if (ii + 1 >= argc)
+            return false;
+
+        const WCHAR* const value = argv[++ii];
+        if (!wcscmp(option, L"--minor"))
+            req.minor = _wtoi(value);
+        else if (!wcscmp(option, L"--major"))
+            req.major = _wtoi(value);
+        else if (!wcscmp(option, L"--color"))
+            req.color = wcstoul(value, nullptr, 16) & 0x00ffffff;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+static bool EndsWith(const std::wstring& s, const WCHAR* suffix)
+{
+    const size_t len = wcslen(suffix);
+    return s.size() >= len && !_wcsicmp(s.c_str() + s.size() - len, suffix);
+}
+
+static bool WriteRaw(const WCHAR* path, const std::vector<uint32_t>& pixels)
+{
+    // Check the size first, so an oversize request doesn't leave an empty file.
+    const uint64_t size = uint64_t(pixels.size()) * sizeof(pixels[0]);
+    if (size > MAXDWORD)
+        return false;
+
+    const HANDLE h = CreateFile(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD written;
+    const DWORD cb = DWORD(size);
+    const bool ok = (WriteFile(h, pixels.data(), cb, &written, nullptr) && written == cb);
+    CloseHandle(h);
+    return ok;
+}
+
+static bool WritePng(IWICImagingFactory* factory, const WCHAR* path, std::vector<uint32_t>& pixels, LONG cx, LONG cy)
+{
+    // WIC takes the stride and buffer size as UINT.
+    const uint64_t stride = uint64_t(cx) * sizeof(pixels[0]);
+    const uint64_t size = stride * uint64_t(cy);
+    if (cx <= 0 || cy <= 0 || size > UINT_MAX || size > uint64_t(pixels.size()) * sizeof(pixels[0]))
+        return false;
+
+    // Captured pixels have an undefined alpha byte.
+    for (auto& pixel : pixels)
+        pixel |= 0xff000000;
+
+    ComPtr<IWICStream> stream;
+    ComPtr<IWICBitmapEncoder> encoder;
+    ComPtr<IWICBitmapFrameEncode> frame;
+    if (FAILED(factory->CreateStream(&stream)) ||
+        FAILED(stream->InitializeFromFilename(path, GENERIC_WRITE)) ||
+        FAILED(factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &encoder)) ||
+        FAILED(encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache)) ||
+        FAILED(encoder->CreateNewFrame(&frame, nullptr)) ||
+        FAILED(frame->Initialize(nullptr)) ||
+        FAILED(frame->SetSize(cx, cy)))
+        return false;
+
+    WICPixelFormatGUID format = GUID_WICPixelFormat32bppBGRA;
+    if (FAILED(frame->SetPixelFormat(&format)) || format != GUID_WICPixelFormat32bppBGRA)
+        return false;
+
+    return (SUCCEEDED(frame->WritePixels(cy, UINT(stride), UINT(size), reinterpret_cast<BYTE*>(pixels.data()))) &&
+            SUCCEEDED(frame->Commit()) &&
+            SUCCEEDED(encoder->Commit()));
+}
+
+static bool ProcessRequest(IWICImagingFactory* factory, ScreenCapture& capture, const CaptureRequest& req)
+{
+    const double start = GetPerfSeconds();
+
+    // Move the rect onto a single monitor, the same as GetZoomArea does.
+    POINT pt;
+    pt.x = req.rc.left + (req.rc.right - req.rc.left) / 2;
+    pt.y = req.rc.top + (req.rc.bottom - req.rc.top) / 2;
+    SIZE area;
+    area.cx = req.rc.right - req.rc.left;
+    area.cy = req.rc.bottom - req.rc.top;
+
+    CachedMonitorInfo info;
+    RECT rc;
+    if (!GetCachedMonitorInfo(pt, info))
+    {
+        ConsolePrintf(L"%s:  no monitor at %d,%d.\n", req.output.c_str(), pt.x, pt.y);
+        return false;
+    }
+    area.cx = std::min<LONG>(area.cx, info.rcMonitor.right - info.rcMonitor.left);
+    area.cy = std::min<LONG>(area.cy, info.rcMonitor.bottom - info.rcMonitor.top);
+    if (!ClampZoomArea(pt, area, info.rcMonitor, rc) || !capture.Capture(rc, info.rcMonitor, 0, 0))
+    {
+        ConsolePrintf(L"%s:  capture failed.\n", req.output.c_str());
+        return false;
+    }
+
+    const double captured = GetPerfSeconds();
+
+    PixelSource src;
+    src.bits = reinterpret_cast<const uint32_t*>(capture.GetBits());
+    src.stride = capture.GetStride();
+    src.cx = rc.right - rc.left;
+    src.cy = rc.bottom - rc.top;
+
+    const LONG cx = src.cx * req.factor;
+    const LONG cy = src.cy * req.factor;
+    if (uint64_t(cx) * uint64_t(cy) > c_max_output_pixels)
+    {
+        ConsolePrintf(L"%s:  %dx%d output is larger than %u megapixels; use a smaller region or factor.\n",
+                      req.output.c_str(), cx, cy, unsigned(c_max_output_pixels / (1024 * 1024)));
+        return false;
+    }
+    std::vector<uint32_t> pixels(size_t(cx) * size_t(cy));
+
+    PixelTarget dst;
+    dst.bits = pixels.data();
+    dst.stride = cx;
+    dst.cx = cx;
+    dst.cy = cy;
+
+    ScaleParams params;
+    params.factor = req.factor;
+    params.gridline_color = req.color;
+    SetGridlines(params, req.minor, req.major);
+    if (req.reference)
+        ScaleReference(src, dst, params);
+    else
+        ScaleTiled(ThreadPool::GetShared(), src, dst, params);
+
+    const double scaled = GetPerfSeconds();
+
+    const bool ok = (EndsWith(req.output, L".raw") ?
+                     WriteRaw(req.output.c_str(), pixels) :
+                     WritePng(factory, req.output.c_str(), pixels, cx, cy));
+
+    const double encoded = GetPerfSeconds();
+
+    if (!ok)
+    {
+        ConsolePrintf(L"%s:  write failed.\n", req.output.c_str());
+        return false;
+    }
+
+    ConsolePrintf(L"%s:  %d,%d %dx%d at %dx -> %dx%d;  capture %.3f ms, scale %.3f ms, encode %.3f ms.\n",
+                  req.output.c_str(), rc.left, rc.top, src.cx, src.cy, req.factor, cx, cy,
+                  (captured - start) * 1000, (scaled - captured) * 1000, (encoded - scaled) * 1000);
+    return true;
+}
+
+// Reads a UTF-8 (or ASCII) batch file into lines.
+static bool ReadBatchFile(const WCHAR* path, std::vector<std::wstring>& lines)
+{
+    const HANDLE h = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    std::string bytes;
+    char buffer[4096];
+    DWORD cb;
+    while (ReadFile(h, buffer, sizeof(buffer), &cb, nullptr) && cb)
+        bytes.append(buffer, cb);
+    CloseHandle(h);
+
+    if (bytes.compare(0, 3, "\xef\xbb\xbf") == 0)
+        bytes.erase(0, 3);
+
+    std::wstring text(bytes.size(), '\0');
+    text.resize(MultiByteToWideChar(CP_UTF8, 0, bytes.data(), int(bytes.size()), &text[0], int(text.size())));
+
+    size_t begin = 0;
+    while (begin < text.size())
+    {
+        size_t end = text.find('\n', begin);
+        if (end == std::wstring::npos)
+            end = text.size();
+        std::wstring line = text.substr(begin, end - begin);
+        begin = end + 1;
+
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+            line.pop_back();
+        const size_t first = line.find_first_not_of(L" \t");
+        if (first == std::wstring::npos || line[first] == '#')
+            continue;
+        lines.push_back(line.substr(first));
+    }
+
+    return true;
+}
+
+int RunHeadlessCapture(int argc, WCHAR** argv)
+{
+    if (!AttachConsoleOutput())
+        return 1;
+
+    std::vector<CaptureRequest> requests;
+    if (argc >= 2 && !wcscmp(argv[0], L"--capture-batch"))
+    {
+        std::vector<std::wstring> lines;
+        if (argc != 2 || !ReadBatchFile(argv[1], lines))
+        {
+            ConsolePrintf(L"Unable to read batch file.\n");
+            return 1;
+        }
+
+        for (size_t ii = 0; ii < lines.size(); ++ii)
+        {
+            // CommandLineToArgvW treats the first argument specially, so give
+            // it a placeholder program name.
+            int lineArgc = 0;
+            const std::wstring cmdline = L"zoomin " + lines[ii];
+            LPWSTR* lineArgv = CommandLineToArgvW(cmdline.c_str(), &lineArgc);
+            CaptureRequest req;
+            const bool ok = (lineArgv && ParseRequest(lineArgc - 1, lineArgv + 1, req));
+            if (lineArgv)
+                LocalFree(lineArgv);
+            if (!ok)
+            {
+                ConsolePrintf(L"Invalid request on line %u:  %s\n", unsigned(ii + 1), lines[ii].c_str());
+                return 1;
+            }
+            requests.push_back(std::move(req));
+        }
+    }
+    else
+    {
+        CaptureRequest req;
+        if (!ParseRequest(argc - 1, argv + 1, req))
+        {
+            ConsolePrintf(L"Usage:  zoomin --capture <left,top,width,height> <factor> <output> [--minor n] [--major n] [--color RRGGBB] [--reference]\n"
+                          L"        zoomin --capture-batch <file>\n");
+            return 1;
+        }
+        requests.push_back(std::move(req));
+    }
+
+    const HRESULT hrInit = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    ComPtr<IWICImagingFactory> factory;
+    if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory))))
+    {
+        ConsolePrintf(L"Unable to initialize WIC.\n");
+        if (SUCCEEDED(hrInit))
+            CoUninitialize();
+        return 1;
+    }
+
+    // The capture buffer is reused across requests.
+    unsigned failures = 0;
+    ScreenCapture capture;
+    const double start = GetPerfSeconds();
+    for (const auto& req : requests)
+    {
+        if (!ProcessRequest(factory.Get(), capture, req))
+            ++failures;
+    }
+
+    ConsolePrintf(L"%u regions, %u failed, %.3f ms total.\n", unsigned(requests.size()), failures, (GetPerfSeconds() - start) * 1000);
+
+    capture.Free();
+    factory.Reset();
+    if (SUCCEEDED(hrInit))
+        CoUninitialize();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+// Headless capture, for scripts.  No window is created.
+//
+//      zoomin --capture <left,top,width,height> <factor> <output> [options]
+//      zoomin --capture-batch <file>
+//
+// The rect is in physical screen pixels, and is moved as needed to be fully on
+// one monitor, the same as the zoom area in the window.  The output is a PNG
+// file, or raw top-down 32bpp BGRX pixels if the name ends with ".raw".
+//
+// Options:
+//      --minor <n>         Minor gridlines every n source pixels.
+//      --major <n>         Major gridlines every n source pixels.
+//      --color <RRGGBB>    Gridline color (default 000000).
+//      --reference         Scale with ScaleReference, the same as the software
+//                          reference renderer, e.g. to produce golden images.
+//
+// Each line of a batch file has the same arguments as --capture; blank lines
+// and lines starting with # are ignored.  The time to capture, scale, and
+// encode each region is printed.
+
+int RunHeadlessCapture(int argc, WCHAR** argv);
@@ -0,0 +1,216 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <commdlg.h>
+#include <wincodec.h>
+#include <wrl/client.h>
+
+#include "imagefile.h"
+
+using Microsoft::WRL::ComPtr;
+
+// Larger images are refused rather than risking huge allocations.
+constexpr UINT c_max_image_dimension = 16384;
+
+PixelSource ImageBuffer::GetSource() const
+{
+    PixelSource src;
+    src.bits = pixels.data();
+    src.stride = cx;
+    src.cx = cx;
+    src.cy = cy;
+    return src;
+}
+
+bool LoadImageFile(const WCHAR* path, ImageBuffer& image)
+{
+    // The UI thread doesn't otherwise use COM.
+    const HRESULT hrInit = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
+
+    bool ok = false;
+    {
+        ComPtr<IWICImagingFactory> factory;
+        ComPtr<IWICBitmapDecoder> decoder;
+        ComPtr<IWICBitmapFrameDecode> frame;
+        ComPtr<IWICBitmapSource> converted;
+        UINT cx = 0;
+        UINT cy = 0;
+        if (SUCCEEDED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory))) &&
+            SUCCEEDED(factory->CreateDecoderFromFilename(path, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder)) &&
+            SUCCEEDED(decoder->GetFrame(0, &frame)) &&
+            SUCCEEDED(WICConvertBitmapSource(GUID_WICPixelFormat32bppBGRA, frame.Get(), &converted)) &&
+            SUCCEEDED(converted->GetSize(&cx, &cy)) &&
+            cx && cy && cx <= c_max_image_dimension && cy <= c_max_image_dimension)
+        {
+            // BGRA bytes are 0xAARRGGBB pixels.
+            std::vector<uint32_t> pixels(size_t(cx) * cy);
+            const UINT stride = cx * sizeof(uint32_t);
+            if (SUCCEEDED(converted->CopyPixels(nullptr, stride, stride * cy, reinterpret_cast<BYTE*>(pixels.data()))))
+            {
+                image.pixels.swap(pixels);
+                image.cx = int32_t(cx);
+                image.cy = int32_t(cy);
+                ok = true;
+            }
+        }
+    }
+
+    if (SUCCEEDED(hrInit))
+        CoUninitialize();
+    return ok;
+}
+
+bool GetClipboardImage(HWND hwnd, ImageBuffer& image)
+{
+    if (!IsClipboardFormatAvailable(CF_BITMAP) || !OpenClipboard(hwnd))
+        return false;
+
+    // The system converts CF_DIB and CF_DIBV5 to CF_BITMAP as needed.
+    bool ok = false;
+    const HBITMAP hbmp = HBITMAP(GetClipboardData(CF_BITMAP));
+    BITMAP bm;
+    if (hbmp && GetObject(hbmp, sizeof(bm), &bm) &&
+        bm.bmWidth > 0 && bm.bmHeight > 0 &&
+        bm.bmWidth <= LONG(c_max_image_dimension) && bm.bmHeight <= LONG(c_max_image_dimension))
+    {
+        BITMAPINFO bmi = {};
+        bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+        bmi.bmiHeader.biWidth = bm.bmWidth;
+        bmi.bmiHeader.biHeight = -bm.bmHeight;  // Top-down.
+        bmi.bmiHeader.biPlanes = 1;
+        bmi.bmiHeader.biBitCount = 32;
+        bmi.bmiHeader.biCompression = BI_RGB;
+
+        std::vector<uint32_t> pixels(size_t(bm.bmWidth) * bm.bmHeight);
+        const HDC hdc = GetDC(NULL);
+        if (hdc && GetDIBits(hdc, hbmp, 0, bm.bmHeight, pixels.data(), &bmi, DIB_RGB_COLORS) == bm.bmHeight)
+        {
+            // GetDIBits leaves the top byte undefined.
+            for (auto& pixel : pixels)
+                pixel |= 0xff000000;
+            image.pixels.swap(pixels);
+            image.cx = bm.bmWidth;
+            image.cy = bm.bmHeight;
+            ok = true;
+        }
+        if (hdc)
+            ReleaseDC(NULL, hdc);
+    }
+
+    CloseClipboard();
+    return ok;
+}
+
+bool BrowseImageFile(HWND hwnd, const WCHAR* title, WCHAR* path, DWORD max_path)
+{
+    OPENFILENAME ofn = { sizeof(ofn) };
+    ofn.hwndOwner = hwnd;
+    ofn.lpstrFilter = TEXT("Images (*.png;*.bmp)\0*.png;*.bmp\0All Files (*.*)\0*.*\0");
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = max_path;
+    ofn.lpstrTitle = title;
+    ofn.Flags = OFN_FILEMUSTEXIST|OFN_PATHMUSTEXIST|OFN_HIDEREADONLY;
+    return !!GetOpenFileName(&ofn);
+}
+
+//------------------------------------------------------------------------------
+// ReferenceImage.
+
+bool ReferenceImage::Load(const WCHAR* path)
+{
+    Free();
+
+    if (MapBitmap(path))
+        return true;
+
+    if (!LoadImageFile(path, m_decoded))
+        return false;
+    m_src = m_decoded.GetSource();
+    m_alpha = true;
+    return true;
+}
+
+void ReferenceImage::Free()
+{
+    if (m_view)
+        UnmapViewOfFile(m_view);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    m_view = nullptr;
+    m_mapping = NULL;
+    m_decoded = ImageBuffer();
+    m_src = PixelSource();
+    m_alpha = false;
+}
+
+// Maps uncompressed 32bpp BMP files; returns false for anything else.
+bool ReferenceImage::MapBitmap(const WCHAR* path)
+{
+    const HANDLE hfile = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hfile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size = {};
+    if (GetFileSizeEx(hfile, &size) && size.QuadPart > LONGLONG(sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER)))
+        m_mapping = CreateFileMapping(hfile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(hfile);
+    if (m_mapping)
+        m_view = static_cast<const BYTE*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_view)
+    {
+        Free();
+        return false;
+    }
+
+    const auto& bfh = *reinterpret_cast<const BITMAPFILEHEADER*>(m_view);
+    const auto& bih = *reinterpret_cast<const BITMAPINFOHEADER*>(m_view + sizeof(BITMAPFILEHEADER));
+    const LONG cx = bih.biWidth;
+    const LONG cy = (bih.biHeight < 0) ? -bih.biHeight : bih.biHeight;
+    bool ok = (bfh.bfType == 0x4d42 &&  // "BM"
+               bih.biSize >= sizeof(BITMAPINFOHEADER) &&
+               sizeof(BITMAPFILEHEADER) + bih.biSize <= ULONGLONG(size.QuadPart) &&
+               bih.biPlanes == 1 && bih.biBitCount == 32 &&
+               cx > 0 && cy > 0 && cx <= LONG(c_max_image_dimension) && cy <= LONG(c_max_image_dimension) &&
+               bfh.bfOffBits + ULONGLONG(cx) * cy * sizeof(uint32_t) <= ULONGLONG(size.QuadPart));
+
+    // Only the standard channel layout can be used in place.  BI_BITFIELDS
+    // masks follow a BITMAPINFOHEADER, or are inside the larger headers.
+    DWORD alpha_mask = 0;
+    if (ok && bih.biCompression == BI_BITFIELDS)
+    {
+        const DWORD* const masks = reinterpret_cast<const DWORD*>(m_view + sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER));
+        const bool has_alpha_mask = (bih.biSize >= sizeof(BITMAPV4HEADER));
+        ok = (sizeof(BITMAPFILEHEADER) + sizeof(BITMAPINFOHEADER) + 3 * sizeof(DWORD) <= bfh.bfOffBits &&
+              masks[0] == 0x00ff0000 && masks[1] == 0x0000ff00 && masks[2] == 0x000000ff);
+        if (ok && has_alpha_mask)
+            alpha_mask = masks[3];
+    }
+    else if (bih.biCompression != BI_RGB)
+    {
+        ok = false;
+    }
+    if (!ok)
+    {
+        Free();
+        return false;
+    }
+
+    // Bottom-up bitmaps are read with a negative stride.
+    const uint32_t* const bits = reinterpret_cast<const uint32_t*>(m_view + bfh.bfOffBits);
+    m_src.cx = cx;
+    m_src.cy = cy;
+    m_src.stride = (bih.biHeight < 0) ? cx : -cx;
+    m_src.bits = (bih.biHeight < 0) ? bits : bits + size_t(cy - 1) * cx;
+
+    // Many programs write an alpha mask but leave alpha zero; such bitmaps
+    // are opaque.
+    if (alpha_mask == 0xff000000)
+    {
+        const size_t count = size_t(cx) * cy;
+        for (size_t ii = 0; ii < count && !m_alpha; ++ii)
+            m_alpha = !!(bits[ii] & 0xff000000);
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+#include "pixels.h"
+
+//------------------------------------------------------------------------------
+// Loading images from files and the clipboard, as 32bpp top-down pixels with
+// straight (not premultiplied) alpha in the top byte.
+
+struct ImageBuffer
+{
+    std::vector<uint32_t> pixels;       // 0xAARRGGBB.
+    int32_t         cx = 0;
+    int32_t         cy = 0;
+
+    bool            IsEmpty() const { return pixels.empty(); }
+    PixelSource     GetSource() const;
+};
+
+// Any format WIC can decode (e.g. PNG or BMP); the first frame.
+bool LoadImageFile(const WCHAR* path, ImageBuffer& image);
+// A bitmap on the clipboard, fully opaque.
+bool GetClipboardImage(HWND hwnd, ImageBuffer& image);
+// Prompts for an image file.
+bool BrowseImageFile(HWND hwnd, const WCHAR* title, WCHAR* path, DWORD max_path);
+
+// An image that stays loaded, e.g. for an onion skin overlay.  Uncompressed
+// 32bpp BMP files are memory-mapped and used in place, so even huge mockups
+// cost no copying; other files are decoded with WIC.
+class ReferenceImage
+{
+public:
+                    ReferenceImage() = default;
+                    ~ReferenceImage() { Free(); }
+
+    bool            Load(const WCHAR* path);
+    void            Free();
+
+    bool            IsEmpty() const { return !m_src.bits; }
+    const PixelSource& GetSource() const { return m_src; }
+    bool            HasAlpha() const { return m_alpha; }
+
+private:
+    bool            MapBitmap(const WCHAR* path);
+
+    HANDLE          m_mapping = NULL;
+    const BYTE*     m_view = nullptr;
+    ImageBuffer     m_decoded;
+    PixelSource     m_src;
+    bool            m_alpha = false;
+};
@@ -0,0 +1,72 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "inspector.h"
+
+constexpr size_t c_text_len = sizeof(InspectorReadout().text[0]) / sizeof(wchar_t);
+
+void RgbToHsl(uint32_t value, int32_t& h, int32_t& s, int32_t& l)
+{
+    const int32_t r = (value >> 16) & 0xff;
+    const int32_t g = (value >> 8) & 0xff;
+    const int32_t b = value & 0xff;
+    const int32_t max = std::max<int32_t>(r, std::max<int32_t>(g, b));
+    const int32_t min = std::min<int32_t>(r, std::min<int32_t>(g, b));
+    const int32_t chroma = max - min;
+
+    // Lightness is (max + min) / 2 in 0..255; as a rounded percent that's
+    // (max + min) * 100 / 510.
+    l = ((max + min) * 100 + 255) / 510;
+
+    if (!chroma)
+    {
+        h = 0;
+        s = 0;
+        return;
+    }
+
+    // Saturation is chroma / (1 - |2L - 1|), with L in 0..1.
+    const int32_t denominator = 255 - std::abs(max + min - 255);
+    s = (chroma * 100 + denominator / 2) / denominator;
+
+    // Hue in sixths of the circle, then rounded to degrees.
+    int32_t sixths;
+    int32_t offset;
+    if (max == r)
+    {
+        sixths = 0;
+        offset = g - b;
+    }
+    else if (max == g)
+    {
+        sixths = 2;
+        offset = b - r;
+    }
+    else
+    {
+        sixths = 4;
+        offset = r - g;
+    }
+    const int32_t degrees = (sixths * chroma + offset) * 60;
+    h = ((degrees + (degrees >= 0 ? chroma / 2 : -chroma / 2)) / chroma + 360) % 360;
+}
+
+void FormatInspectorReadout(const InspectorSample& sample, InspectorReadout& readout)
+{
+    const uint32_t r = (sample.value >> 16) & 0xff;
+    const uint32_t g = (sample.value >> 8) & 0xff;
+    const uint32_t b = sample.value & 0xff;
+
+    int32_t h, s, l;
+    RgbToHsl(sample.value, h, s, l);
+
+    swprintf(readout.text[IP_POSITION], c_text_len, L"%d, %d", sample.x, sample.y);
+    swprintf(readout.text[IP_UNSCALED], c_text_len, L"96 DPI: %d, %d", sample.unscaled_x, sample.unscaled_y);
+    swprintf(readout.text[IP_HEX], c_text_len, L"#%02X%02X%02X", r, g, b);
+    swprintf(readout.text[IP_RGB], c_text_len, L"rgb(%u, %u, %u)", r, g, b);
+    swprintf(readout.text[IP_HSL], c_text_len, L"hsl(%d, %d%%, %d%%)", h, s, l);
+}
@@ -0,0 +1,43 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+#include <wchar.h>
+
+//------------------------------------------------------------------------------
+// Pixel inspector readout.
+//
+// Formats the source position and color of the pixel under the mouse, for the
+// status bar.  The caller reads the pixel from the retained capture instead of
+// the screen, so this is cheap enough for every mouse move.
+
+enum InspectorPart
+{
+    IP_POSITION,                        // Physical screen coordinates.
+    IP_UNSCALED,                        // 96 DPI coordinates within the monitor.
+    IP_HEX,                             // #RRGGBB.
+    IP_RGB,                             // rgb(r, g, b).
+    IP_HSL,                             // hsl(h, s%, l%).
+    IP_COUNT
+};
+
+struct InspectorSample
+{
+    int32_t         x = 0;
+    int32_t         y = 0;
+    int32_t         unscaled_x = 0;
+    int32_t         unscaled_y = 0;
+    uint32_t        value = 0;          // 0x00RRGGBB.
+};
+
+struct InspectorReadout
+{
+    wchar_t         text[IP_COUNT][40];
+};
+
+// Hue in degrees, saturation and lightness in percent, all rounded.
+void RgbToHsl(uint32_t value, int32_t& h, int32_t& s, int32_t& l);
+
+void FormatInspectorReadout(const InspectorSample& sample, InspectorReadout& readout);
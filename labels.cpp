@@ -0,0 +1,232 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "labels.h"
+
+// Luminance weights (Rec. 709), scaled so they sum to 256.
+constexpr uint32_t c_weight_r = 54;
+constexpr uint32_t c_weight_g = 183;
+constexpr uint32_t c_weight_b = 19;
+static_assert(c_weight_r + c_weight_g + c_weight_b == 256, "weights must sum to 256");
+
+// Labels on pixels at least this bright are drawn in black, else in white.
+constexpr uint8_t c_dark_text_luminance = 128;
+
+int32_t GetLabelColumns(LabelFormat format)
+{
+    return (format == LF_HEX) ? 2 : 3;
+}
+
+//------------------------------------------------------------------------------
+// ComputeLuminance.
+
+void ComputeLuminance(const uint32_t* pixels, int32_t count, uint8_t* out)
+{
+    int32_t ii = 0;
+#ifdef USE_SSE2
+    // Each weighted channel fits in the low 16 bits of its 32-bit lane, so
+    // 16-bit multiplies are enough, and the sum fits in 16 bits as well.
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i wr = _mm_set1_epi32(c_weight_r);
+    const __m128i wg = _mm_set1_epi32(c_weight_g);
+    const __m128i wb = _mm_set1_epi32(c_weight_b);
+    const __m128i round = _mm_set1_epi32(128);
+    auto luminance4 = [&](const uint32_t* p)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), mask);
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8), mask);
+        const __m128i b = _mm_and_si128(v, mask);
+        __m128i y = _mm_add_epi32(_mm_mullo_epi16(r, wr), _mm_mullo_epi16(g, wg));
+        y = _mm_add_epi32(y, _mm_mullo_epi16(b, wb));
+        return _mm_srli_epi32(_mm_add_epi32(y, round), 8);
+    };
+    for (; ii + 8 <= count; ii += 8)
+    {
+        const __m128i words = _mm_packs_epi32(luminance4(pixels + ii), luminance4(pixels + ii + 4));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + ii), _mm_packus_epi16(words, words));
+    }
+#endif
+    for (; ii < count; ++ii)
+    {
+        const uint32_t p = pixels[ii];
+        const uint32_t y = ((p >> 16) & 0xff) * c_weight_r + ((p >> 8) & 0xff) * c_weight_g + (p & 0xff) * c_weight_b;
+        out[ii] = uint8_t((y + 128) >> 8);
+    }
+}
+
+//------------------------------------------------------------------------------
+// PixelLabels.
+
+static void FormatLabel(uint32_t value, LabelFormat format, uint8_t (&slots)[3][3])
+{
+    memset(slots, 0xff, sizeof(slots));
+    for (int32_t line = 0; line < 3; ++line)
+    {
+        uint32_t channel = (value >> (16 - line * 8)) & 0xff;
+        if (format == LF_HEX)
+        {
+            slots[line][0] = uint8_t(channel >> 4);
+            slots[line][1] = uint8_t(channel & 0xf);
+        }
+        else
+        {
+            // Right aligned, without leading zeros.
+            int32_t ii = 2;
+            do
+            {
+                slots[line][ii--] = uint8_t(channel % 10);
+                channel /= 10;
+            }
+            while (channel);
+        }
+    }
+}
+
+void PixelLabels::Clear()
+{
+    m_atlas = nullptr;
+    m_cells.clear();
+}
+
+uint32_t PixelLabels::Update(const PixelSource& src, const PixelSource& shown, int32_t factor, int32_t cx, int32_t cy, LabelFormat format, const GlyphAtlas* atlas)
+{
+    if (!atlas || atlas->coverage.empty() || factor <= 0)
+    {
+        Clear();
+        return 0;
+    }
+
+    const int32_t label_cx = GetLabelColumns(format) * atlas->slot_cx;
+    const int32_t label_cy = 3 * atlas->slot_cy;
+    if (label_cx + 2 * c_label_margin > factor || label_cy + 2 * c_label_margin > factor)
+    {
+        Clear();
+        return 0;
+    }
+
+    const int32_t cols = std::min<int32_t>(std::min<int32_t>(src.cx, shown.cx), (cx + factor - 1) / factor);
+    const int32_t rows = std::min<int32_t>(std::min<int32_t>(src.cy, shown.cy), (cy + factor - 1) / factor);
+
+    // Anything that moves the labels or changes their glyphs invalidates them.
+    if (atlas != m_atlas || atlas->generation != m_generation || format != m_format ||
+        factor != m_factor || cols != m_cols || rows != m_rows)
+    {
+        m_atlas = atlas;
+        m_generation = atlas->generation;
+        m_format = format;
+        m_factor = factor;
+        m_cols = cols;
+        m_rows = rows;
+        m_offset_x = (factor - label_cx) / 2;
+        m_offset_y = (factor - label_cy) / 2;
+        m_cells.assign(size_t(std::max<int32_t>(0, cols * rows)), Cell());
+    }
+
+    m_luminance.resize(size_t(std::max<int32_t>(0, cols)));
+
+    uint32_t changed = 0;
+    for (int32_t row = 0; row < rows; ++row)
+    {
+        const uint32_t* const pixels = src.bits + row * src.stride;
+        ComputeLuminance(shown.bits + row * shown.stride, cols, m_luminance.data());
+
+        Cell* const cells = m_cells.data() + row * cols;
+        for (int32_t col = 0; col < cols; ++col)
+        {
+            const uint32_t value = pixels[col] & 0x00ffffff;
+            const uint32_t color = (m_luminance[col] >= c_dark_text_luminance) ? 0x000000 : 0xffffff;
+            Cell& cell = cells[col];
+            if (cell.valid && cell.value == value && cell.color == color)
+                continue;
+
+            if (!cell.valid || cell.value != value)
+                FormatLabel(value, format, cell.slots);
+            cell.value = value;
+            cell.color = color;
+            cell.valid = true;
+            ++changed;
+        }
+    }
+
+    return changed;
+}
+
+uint32_t PixelLabels::UpdateContrast(const PixelSource& shown)
+{
+    if (!IsVisible())
+        return 0;
+
+    const int32_t cols = std::min<int32_t>(m_cols, shown.cx);
+    const int32_t rows = std::min<int32_t>(m_rows, shown.cy);
+    m_luminance.resize(size_t(std::max<int32_t>(0, cols)));
+
+    uint32_t changed = 0;
+    for (int32_t row = 0; row < rows; ++row)
+    {
+        ComputeLuminance(shown.bits + row * shown.stride, cols, m_luminance.data());
+
+        Cell* const cells = m_cells.data() + row * m_cols;
+        for (int32_t col = 0; col < cols; ++col)
+        {
+            const uint32_t color = (m_luminance[col] >= c_dark_text_luminance) ? 0x000000 : 0xffffff;
+            if (cells[col].color != color)
+            {
+                cells[col].color = color;
+                ++changed;
+            }
+        }
+    }
+
+    return changed;
+}
+
+void PixelLabels::Draw(const PixelTarget& dst) const
+{
+    const GlyphAtlas* const atlas = m_atlas;
+    const int32_t stride = atlas ? atlas->GetStride() : 0;
+
+    ForEachGlyph([&](int32_t x, int32_t y, uint8_t slot, uint32_t color)
+    {
+        const int32_t left = std::max<int32_t>(0, x);
+        const int32_t top = std::max<int32_t>(0, y);
+        const int32_t right = std::min<int32_t>(dst.cx, x + atlas->slot_cx);
+        const int32_t bottom = std::min<int32_t>(dst.cy, y + atlas->slot_cy);
+
+        for (int32_t yy = top; yy < bottom; ++yy)
+        {
+            const uint8_t* const coverage = atlas->coverage.data() + (yy - y) * stride + slot * atlas->slot_cx - x;
+            uint32_t* const out = dst.bits + yy * dst.stride;
+            for (int32_t xx = left; xx < right; ++xx)
+            {
+                const uint32_t a = coverage[xx];
+                if (!a)
+                    continue;
+                if (a == 255)
+                {
+                    out[xx] = color;
+                    continue;
+                }
+
+                // Blend each channel:  (color * a + bg * (255 - a)) / 255.
+                const uint32_t bg = out[xx];
+                uint32_t blended = 0;
+                for (int32_t shift = 0; shift <= 16; shift += 8)
+                {
+                    const uint32_t c = (color >> shift) & 0xff;
+                    const uint32_t b = (bg >> shift) & 0xff;
+                    blended |= ((c * a + b * (255 - a) + 127) / 255) << shift;
+                }
+                out[xx] = blended;
+            }
+        }
+    });
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "pixels.h"
+
+//------------------------------------------------------------------------------
+// Pixel value labels.
+//
+// At high zoom factors each magnified pixel can be labeled with its value, as
+// three lines (red, green, blue) in hex or decimal.  The glyphs come from a
+// GlyphAtlas (see glyphatlas.h for how one is built with DirectWrite).  A
+// label's glyphs are only re-laid out when its pixel value changes, but every
+// visible glyph is blended into the scaled target again each frame, since the
+// scaler overwrites it.
+
+// Glyphs in a GlyphAtlas, in slot order.
+constexpr char c_label_glyphs[] = "0123456789ABCDEF";
+constexpr int32_t c_label_glyph_count = sizeof(c_label_glyphs) - 1;
+
+// Pixels kept clear around a label, so it doesn't touch gridlines.
+constexpr int32_t c_label_margin = 2;
+
+struct GlyphAtlas
+{
+    int32_t         slot_cx = 0;        // Each glyph's slot, in pixels.
+    int32_t         slot_cy = 0;
+    std::vector<uint8_t> coverage;      // Slots side by side, 0..255.
+    uint32_t        generation = 0;     // Differs for each atlas built.
+
+    int32_t         GetStride() const { return slot_cx * c_label_glyph_count; }
+};
+
+enum LabelFormat
+{
+    LF_HEX,
+    LF_DECIMAL,
+};
+
+int32_t GetLabelColumns(LabelFormat format);
+
+// Stores the luminance (0..255) of each 0x00RRGGBB pixel.
+void ComputeLuminance(const uint32_t* pixels, int32_t count, uint8_t* out);
+
+class PixelLabels
+{
+public:
+    // Updates the labels for the source pixels visible in a cx by cy target at
+    // the given factor, and returns how many labels changed.  The labels show
+    // the values in src, and are black or white for contrast with the pixels
+    // drawn beneath them in shown (e.g. filtered or diffed), which is the same
+    // size as src.  Labels are hidden when the atlas is null or its glyphs
+    // don't fit in a magnified pixel.
+    uint32_t        Update(const PixelSource& src, const PixelSource& shown, int32_t factor, int32_t cx, int32_t cy, LabelFormat format, const GlyphAtlas* atlas);
+    // Re-picks black or white for contrast with shown, e.g. the difference
+    // image a renderer computes in diff mode, and returns how many labels
+    // changed color.
+    uint32_t        UpdateContrast(const PixelSource& shown);
+    void            Clear();
+
+    bool            IsVisible() const { return m_atlas && !m_cells.empty(); }
+    const GlyphAtlas* GetAtlas() const { return m_atlas; }
+
+    // Blends every visible label's glyphs into the scaled target.
+    void            Draw(const PixelTarget& dst) const;
+
+    // Calls func(x, y, slot, color) for each glyph, where x and y are the top
+    // left of the glyph in the target, and color is 0x00RRGGBB.
+    template <class F> void ForEachGlyph(F&& func) const;
+
+private:
+    struct Cell
+    {
+        uint32_t    value = 0;
+        uint32_t    color = 0;
+        uint8_t     slots[3][3];        // 0xff for none.
+        bool        valid = false;
+    };
+
+    const GlyphAtlas* m_atlas = nullptr;
+    uint32_t        m_generation = 0;
+    LabelFormat     m_format = LF_HEX;
+    int32_t         m_factor = 0;
+    int32_t         m_cols = 0;
+    int32_t         m_rows = 0;
+    int32_t         m_offset_x = 0;     // Label position within a magnified pixel.
+    int32_t         m_offset_y = 0;
+    std::vector<Cell> m_cells;
+    std::vector<uint8_t> m_luminance;
+};
+
+template <class F> void PixelLabels::ForEachGlyph(F&& func) const
+{
+    if (!IsVisible())
+        return;
+
+    const int32_t columns = GetLabelColumns(m_format);
+    for (int32_t row = 0; row < m_rows; ++row)
+    {
+        for (int32_t col = 0; col < m_cols; ++col)
+        {
+            const Cell& cell = m_cells[row * m_cols + col];
+            const int32_t left = col * m_factor + m_offset_x;
+            const int32_t top = row * m_factor + m_offset_y;
+            for (int32_t line = 0; line < 3; ++line)
+            {
+                for (int32_t ii = 0; ii < columns; ++ii)
+                {
+                    const uint8_t slot = cell.slots[line][ii];
+                    if (slot != 0xff)
+                        func(left + ii * m_atlas->slot_cx, top + line * m_atlas->slot_cy, slot, cell.color);
+                }
+            }
+        }
+    }
+}
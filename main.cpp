@@ -7,16 +7,44 @@
 #include <commctrl.h>
 #include <commdlg.h>
 #include <shellapi.h>
+#include <dwmapi.h>
+#include <wtsapi32.h>
 #include <stdlib.h>
+#include <math.h>
 #include <assert.h>
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #include "dpi.h"
+#include "bench.h"
+#include "cadencecapture.h"
+#include "capture.h"
+#include "edges.h"
+#include "elements.h"
+#include "flicker.h"
+#include "glyphatlas.h"
+#include "headless.h"
+#include "imagefile.h"
+#include "inspector.h"
+#include "moncache.h"
+#include "onionskin.h"
+#include "filters.h"
+#include "perf.h"
+#include "regsettings.h"
+#include "renderer.h"
 #include "reticle.h"
+#include "scaler.h"
+#include "search.h"
+#include "startup.h"
+#include "statspanel.h"
+#include "threadpool.h"
+#include "timelinepane.h"
 #include "version.h"
 #include "res.h"
 
 static const WCHAR c_reg_root[] = TEXT("Software\\chrisant996\\Zoomin");
+static const WCHAR c_settings_file[] = TEXT("Zoomin.settings");
 static const WCHAR c_wndclass_name[] = TEXT("ZoominMainWindow");
 static const WCHAR* const c_gridline_spacing_name[] =
 {
@@ -28,6 +56,40 @@ static const WCHAR* const c_show_gridlines_name[] =
     TEXT("ShowMinorGridlines"),
     TEXT("ShowMajorGridlines"),
 };
+static const WCHAR* const c_filter_name[] =
+{
+    TEXT("Filter1"),
+    TEXT("Filter2"),
+    TEXT("Filter3"),
+    TEXT("Filter4"),
+    TEXT("Filter5"),
+};
+static const WCHAR* const c_filter_param_name[] =
+{
+    TEXT("FilterParam1"),
+    TEXT("FilterParam2"),
+    TEXT("FilterParam3"),
+    TEXT("FilterParam4"),
+    TEXT("FilterParam5"),
+};
+static_assert(_countof(c_filter_name) == c_max_filters, "wrong number of filter setting names");
+static_assert(_countof(c_filter_param_name) == c_max_filters, "wrong number of filter setting names");
+static const WCHAR* const c_filter_kind_text[] =
+{
+    TEXT("(None)"),
+    TEXT("Red Channel"),
+    TEXT("Green Channel"),
+    TEXT("Blue Channel"),
+    TEXT("Alpha Channel"),
+    TEXT("Grayscale"),
+    TEXT("Invert"),
+    TEXT("Threshold"),
+    TEXT("Gamma"),
+    TEXT("Protanopia"),
+    TEXT("Deuteranopia"),
+    TEXT("Tritanopia"),
+};
+static_assert(_countof(c_filter_kind_text) == FK_COUNT, "wrong number of filter names");
 static const BYTE c_default_gridlines_spacing[] =
 {
     1,
@@ -36,47 +98,77 @@ static const BYTE c_default_gridlines_spacing[] =
 
 constexpr INT c_min_zoom = 1;
 constexpr INT c_max_zoom = 32;
+constexpr INT c_min_label_zoom = 16;
+constexpr size_t c_max_search_matches = 1000;
+constexpr uint8_t c_search_tolerance = 16;  // Per channel, for approximate matches.
+constexpr INT c_ruler_snap_distance = 8;   // In client pixels at 96 DPI.
+constexpr INT c_overlay_font_height = 11;   // 96 DPI.
+constexpr INT c_onion_opacity_step = 10;    // Percent.
+static const WCHAR c_label_font[] = L"Consolas";
 constexpr LONG c_def_width = 480;
 constexpr LONG c_def_height = 320;
 constexpr UINT c_refresh_timer_id = 1;
+constexpr UINT c_trim_timer_id = 2;
+constexpr UINT c_cadence_timer_id = 3;
+constexpr UINT c_covered_timer_id = 4;
+constexpr UINT c_covered_interval = 500;       // Milliseconds between occlusion checks.
+constexpr UINT c_cadence_title_interval = 250; // Milliseconds between title updates.
+constexpr UINT c_trim_delay = 10 * 1000;       // Milliseconds hidden before trimming the working set.
+constexpr int c_hotkey_id = 1;
+constexpr UINT c_tray_icon_id = 1;
+constexpr WORD c_default_hotkey = MAKEWORD('Z', HOTKEYF_CONTROL|HOTKEYF_ALT);
+constexpr LONG c_capture_slack = 32;
+constexpr INT c_min_adaptive_rate = 1;
+constexpr INT c_max_adaptive_rate = 60;
 
 static HINSTANCE g_hinst = 0;
 static HACCEL g_haccel = 0;
+static bool g_start_hidden = false;
+static UINT g_msgTaskbarCreated = 0;
+
+#define WMU_TRAYNOTIFY          (WM_APP + 1)
 
 //------------------------------------------------------------------------------
-// Registry.
+// Settings.
+//
+// Settings are loaded in one pass on first use and written back in one batch
+// when the main window is destroyed.  They live in the registry, unless a
+// Zoomin.settings file exists next to the executable (portable mode).
 
-LONG ReadRegLong(const WCHAR* name, LONG default_value)
+static Settings& GetSettings()
 {
-    HKEY hkey;
-    LONG ret = default_value;
-
-    if (ERROR_SUCCESS == RegOpenKey(HKEY_CURRENT_USER, c_reg_root, &hkey))
+    static Settings* s_settings = nullptr;
+    if (!s_settings)
     {
-        DWORD type;
-        LONG value;
-        DWORD cb = sizeof(value);
-        if (ERROR_SUCCESS == RegQueryValueEx(hkey, name, 0, &type, reinterpret_cast<BYTE*>(&value), &cb) &&
-            type == REG_DWORD &&
-            cb == sizeof(value))
+        std::unique_ptr<SettingsBackend> backend;
+
+        WCHAR path[MAX_PATH];
+        const DWORD len = GetModuleFileName(NULL, path, _countof(path));
+        WCHAR* const name = (len && len < _countof(path)) ? wcsrchr(path, '\\') : nullptr;
+        if (name && size_t(name + 1 - path) + _countof(c_settings_file) <= _countof(path))
         {
-            ret = value;
+            wcscpy(name + 1, c_settings_file);
+            if (GetFileAttributes(path) != INVALID_FILE_ATTRIBUTES)
+                backend.reset(new FileSettingsBackend(path));
         }
-        RegCloseKey(hkey);
-    }
+        if (!backend)
+            backend.reset(new RegistrySettingsBackend(HKEY_CURRENT_USER, c_reg_root));
 
-    return ret;
+        // Intentionally leaked; it lives as long as the process.
+        s_settings = new Settings(std::move(backend));
+        s_settings->Load();
+    }
+    return *s_settings;
 }
 
-void WriteRegLong(const WCHAR* name, LONG value)
+LONG ReadSetting(const WCHAR* name, LONG default_value)
 {
-    HKEY hkey;
+    return GetSettings().GetLong(name, default_value);
+}
 
-    if (ERROR_SUCCESS == RegCreateKey(HKEY_CURRENT_USER, c_reg_root, &hkey))
-    {
-        RegSetValueEx(hkey, name, 0, REG_DWORD, reinterpret_cast<const BYTE*>(&value), sizeof(value));
-        RegCloseKey(hkey);
-    }
+void WriteSetting(const WCHAR* name, LONG value)
+{
+    GetSettings().SetLong(name, value);
 }
 
 //------------------------------------------------------------------------------
@@ -85,10 +177,10 @@ void WriteRegLong(const WCHAR* name, LONG value)
 class SizeTracker
 {
 public:
-    void OnCreate(HWND hwnd);
+    void OnCreate(HWND hwnd, bool show);
     void OnSize();
     void OnDpiChanged(const DpiScaler& dpi);
-    void OnDestroy();
+    void WriteSettings();
 
 private:
     HWND m_hwnd;
@@ -98,7 +190,7 @@ private:
     bool m_resized = false;
 };
 
-void SizeTracker::OnCreate(HWND hwnd)
+void SizeTracker::OnCreate(HWND hwnd, bool show)
 {
     assert(!m_hwnd);
 
@@ -114,8 +206,8 @@ void SizeTracker::OnCreate(HWND hwnd)
     MONITORINFO info = { sizeof(info) };
     {
         POINT ptMonitor;
-        ptMonitor.x = ReadRegLong(TEXT("MonitorX"), CW_USEDEFAULT);
-        ptMonitor.y = ReadRegLong(TEXT("MonitorY"), CW_USEDEFAULT);
+        ptMonitor.x = ReadSetting(TEXT("MonitorX"), CW_USEDEFAULT);
+        ptMonitor.y = ReadSetting(TEXT("MonitorY"), CW_USEDEFAULT);
 
         HMONITOR hmon;
         const bool use_hwnd = (ptMonitor.x == CW_USEDEFAULT || ptMonitor.y == CW_USEDEFAULT);
@@ -140,11 +232,11 @@ void SizeTracker::OnCreate(HWND hwnd)
         }
     }
 
-    const LONG xx = ReadRegLong(TEXT("WindowLeftRatio"), CW_USEDEFAULT);
-    const LONG yy = ReadRegLong(TEXT("WindowTopRatio"), CW_USEDEFAULT);
-    LONG cx96 = ReadRegLong(TEXT("WindowWidth"), CW_USEDEFAULT);
-    LONG cy96 = ReadRegLong(TEXT("WindowHeight"), CW_USEDEFAULT);
-    const bool maximized = !!ReadRegLong(TEXT("Maximized"), false);
+    const LONG xx = ReadSetting(TEXT("WindowLeftRatio"), CW_USEDEFAULT);
+    const LONG yy = ReadSetting(TEXT("WindowTopRatio"), CW_USEDEFAULT);
+    LONG cx96 = ReadSetting(TEXT("WindowWidth"), CW_USEDEFAULT);
+    LONG cy96 = ReadSetting(TEXT("WindowHeight"), CW_USEDEFAULT);
+    const bool maximized = !!ReadSetting(TEXT("Maximized"), false);
 
     RECT rcWindow;
     GetWindowRect(hwnd, &rcWindow);
@@ -182,7 +274,8 @@ void SizeTracker::OnCreate(HWND hwnd)
 
     GetWindowRect(hwnd, &m_rcRestore);
 
-    ShowWindow(hwnd, m_maximized ? SW_MAXIMIZE : SW_NORMAL);
+    if (show)
+        ShowWindow(hwnd, m_maximized ? SW_MAXIMIZE : SW_NORMAL);
 }
 
 void SizeTracker::OnSize()
@@ -216,7 +309,7 @@ void SizeTracker::OnDpiChanged(const DpiScaler& dpi)
     m_dpi.OnDpiChanged(dpi);
 }
 
-void SizeTracker::OnDestroy()
+void SizeTracker::WriteSettings()
 {
     MONITORINFO info = { sizeof(info) };
     HMONITOR hmon = MonitorFromWindow(m_hwnd, MONITOR_DEFAULTTONEAREST);
@@ -225,13 +318,13 @@ void SizeTracker::OnDestroy()
     const LONG cxWork = (info.rcWork.right - info.rcWork.left);
     const LONG cyWork = (info.rcWork.bottom - info.rcWork.top);
 
-    WriteRegLong(TEXT("MonitorX"), (info.rcMonitor.left + info.rcMonitor.right) / 2);
-    WriteRegLong(TEXT("MonitorY"), (info.rcMonitor.top + info.rcMonitor.bottom) / 2);
-    WriteRegLong(TEXT("WindowLeftRatio"), (cxWork > 0) ? (m_rcRestore.left - info.rcWork.left) * 50000 / cxWork : 0);
-    WriteRegLong(TEXT("WindowTopRatio"), (cyWork > 0) ? (m_rcRestore.top - info.rcWork.top) * 50000 / cyWork : 0);
-    WriteRegLong(TEXT("WindowWidth"), m_dpi.ScaleTo(m_rcRestore.right - m_rcRestore.left, 96));
-    WriteRegLong(TEXT("WindowHeight"), m_dpi.ScaleTo(m_rcRestore.bottom - m_rcRestore.top, 96));
-    WriteRegLong(TEXT("Maximized"), m_maximized);
+    WriteSetting(TEXT("MonitorX"), (info.rcMonitor.left + info.rcMonitor.right) / 2);
+    WriteSetting(TEXT("MonitorY"), (info.rcMonitor.top + info.rcMonitor.bottom) / 2);
+    WriteSetting(TEXT("WindowLeftRatio"), (cxWork > 0) ? (m_rcRestore.left - info.rcWork.left) * 50000 / cxWork : 0);
+    WriteSetting(TEXT("WindowTopRatio"), (cyWork > 0) ? (m_rcRestore.top - info.rcWork.top) * 50000 / cyWork : 0);
+    WriteSetting(TEXT("WindowWidth"), m_dpi.ScaleTo(m_rcRestore.right - m_rcRestore.left, 96));
+    WriteSetting(TEXT("WindowHeight"), m_dpi.ScaleTo(m_rcRestore.bottom - m_rcRestore.top, 96));
+    WriteSetting(TEXT("Maximized"), m_maximized);
 
     m_resized = false;
 }
@@ -264,6 +357,67 @@ static HPALETTE CreatePhysicalPalette()
     return hpal;
 }
 
+//------------------------------------------------------------------------------
+// Visibility.
+//
+// So auto-refresh can stop capturing while nobody can see the result.
+
+static bool IsWindowCloaked(HWND hwnd)
+{
+    DWORD cloaked = 0;
+    return (SUCCEEDED(DwmGetWindowAttribute(hwnd, DWMWA_CLOAKED, &cloaked, sizeof(cloaked))) && cloaked);
+}
+
+static bool IsWindowOccluded(HWND hwnd)
+{
+    RECT rc;
+    RECT rcScreen;
+    GetClientRect(hwnd, &rc);
+    MapWindowPoints(hwnd, NULL, LPPOINT(&rc), 2);
+    rcScreen.left = GetSystemMetrics(SM_XVIRTUALSCREEN);
+    rcScreen.top = GetSystemMetrics(SM_YVIRTUALSCREEN);
+    rcScreen.right = rcScreen.left + GetSystemMetrics(SM_CXVIRTUALSCREEN);
+    rcScreen.bottom = rcScreen.top + GetSystemMetrics(SM_CYVIRTUALSCREEN);
+    if (!IntersectRect(&rc, &rc, &rcScreen))
+        return true;
+
+    const HRGN hrgnVisible = CreateRectRgnIndirect(&rc);
+    const HRGN hrgnAbove = CreateRectRgn(0, 0, 0, 0);
+    bool occluded = false;
+
+    // Subtract each opaque window above this one in the z-order.
+    if (hrgnVisible && hrgnAbove)
+    {
+        for (HWND hwndAbove = GetWindow(hwnd, GW_HWNDPREV); hwndAbove; hwndAbove = GetWindow(hwndAbove, GW_HWNDPREV))
+        {
+            if (!IsWindowVisible(hwndAbove) || IsIconic(hwndAbove) || IsWindowCloaked(hwndAbove))
+                continue;
+
+            // Layered or transparent windows may not hide what's beneath them.
+            if (GetWindowLong(hwndAbove, GWL_EXSTYLE) & (WS_EX_LAYERED|WS_EX_TRANSPARENT))
+                continue;
+
+            RECT rcAbove;
+            if (FAILED(DwmGetWindowAttribute(hwndAbove, DWMWA_EXTENDED_FRAME_BOUNDS, &rcAbove, sizeof(rcAbove))) &&
+                !GetWindowRect(hwndAbove, &rcAbove))
+                continue;
+
+            SetRectRgn(hrgnAbove, rcAbove.left, rcAbove.top, rcAbove.right, rcAbove.bottom);
+            if (CombineRgn(hrgnVisible, hrgnVisible, hrgnAbove, RGN_DIFF) == NULLREGION)
+            {
+                occluded = true;
+                break;
+            }
+        }
+    }
+
+    if (hrgnAbove)
+        DeleteObject(hrgnAbove);
+    if (hrgnVisible)
+        DeleteObject(hrgnVisible);
+    return occluded;
+}
+
 //------------------------------------------------------------------------------
 // Main window.
 
@@ -288,6 +442,10 @@ private:
     LRESULT OnNotify(WPARAM wParam, LPARAM lParam);
     void OnSize();
     void OnDpiChanged(const DpiScaler& dpi);
+    void OnSessionChange(WPARAM wParam);
+    void OnHotkey();
+    void OnTrayNotify(LPARAM lParam);
+    void OnMouseLeave();
 
     // Internal helpers.
     void Init();
@@ -297,11 +455,56 @@ private:
     void SetZoomFactor(INT factor);
     void SetRefresh(bool refresh);
     void SetInterval(UINT interval);
+    void SetAdaptive(bool adaptive, INT min_rate, INT max_rate);
+    void UpdateTimer();
+    void UpdateCovered();
+    bool CheckSuspended();
+    void AdaptRefreshRate();
     void SetReticleOpacity(UINT opacity);
     void CalcZoomArea();
+    void GetZoomClientRect(RECT& rc) const;
+    INT GetScaledFactor() const;
     bool GetZoomArea(RECT& rc, POINT* ptCenter=nullptr);
-    void PaintZoomRect(HDC hdc=NULL);
+    bool EnsureCapture(const RECT& rc, bool recapture);
+    bool GetZoomSource(const RECT& rc, PixelSource& src) const;
+    void SetBaseline();
+    void ShowDifferences(bool show);
+    bool GetBaselineSource(const RECT& rc, PixelSource& src) const;
+    void ShowFlicker(bool show);
+    void AnalyzeCadence(bool analyze);
+    void ShowCadenceReport();
+    void SearchForTemplate();
+    void GoToMatch(size_t index);
+    void ShowRuler(bool show);
+    bool GetRulerCorner(LPARAM lParam, POINT& pt);
+    bool EnsureEdges(const RECT& rc);
+    void ShowElements(bool show);
+    void LoadOnionSkin();
+    void ShowOnionSkin(bool show);
+    void SetOnionOpacity(INT opacity);
+    void ResetOnionOffset();
+    void SetFilters(const FilterStep* steps, bool apply);
+    void DrawOverlay(HDC hdc, const RECT& rc, INT factor);
+    void DrawElements(HDC hdc, const RECT& rc, INT factor);
+    void DrawRuler(HDC hdc, const RECT& rc, INT factor);
+    void PaintZoomRect(HDC hdc=NULL, bool recapture=true);
+    void SetRenderer(RendererKind kind);
+    RenderTarget GetRenderTarget(HDC hdc) const;
+    void ShowInspector(bool show);
+    void LayoutStatusBar();
+    void LayoutTimeline();
+    void UpdateInspector();
+    void ShowRegionStats(bool show);
+    void ShowTimeline(bool show);
+    void AddTimelineProbe();
     void CopyZoomContent();
+    void ShowStatistics();
+    void WriteSettings();
+    void SetResident(bool resident, WORD hotkey);
+    void UpdateTrayIcon(bool recreate=false);
+    void PrewarmResident();
+    void Activate(bool atCursor);
+    void HideToTray();
     void RelayEvent(UINT msg, WPARAM wParam, LPARAM lParam);
 
     static INT_PTR CALLBACK OptionsDlgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -310,6 +513,7 @@ private:
 private:
     HWND m_hwnd = NULL;
     HWND m_tooltips = NULL;
+    HWND m_statusbar = NULL;
     HPALETTE m_hpal = NULL;
     DpiScaler m_dpi;
     bool m_show_gridlines[2] = {};
@@ -318,21 +522,103 @@ private:
     SIZE m_area;
     INT m_factor = 0;
     RECT m_rcMonitor;
+    ScreenCapture m_capture;
+    RendererKind m_rendererKind = RK_GDI;
+    SubpixelOrder m_subpixels = SO_NONE;
+    std::unique_ptr<Renderer> m_renderer;
+    bool m_show_labels = false;
+    bool m_labels_hex = true;
+    PixelLabels m_labels;
+    bool m_show_inspector = true;
+    bool m_trackingMouse = false;
+    POINT m_ptInspect = { -1, -1 };
+    InspectorReadout m_readout = {};
+    StatsPanel m_statsPanel;
+    std::vector<uint32_t> m_baseline;
+    RECT m_rcBaseline = {};
+    bool m_show_diff = false;
+    bool m_diff_heatmap = true;
+    bool m_diff_valid = false;          // False if the baseline doesn't cover the zoom area.
+    DiffResult m_diffResult;            // In screen coordinates.
+    bool m_show_flicker = false;
+    FlickerTracker m_flicker;
+    TimelinePane m_timeline;
+    CadenceCapture m_cadence;
+    ImageBuffer m_searchTemplate;
+    bool m_search_tolerant = false;
+    std::vector<RECT> m_matches;        // In screen coordinates, in reading order.
+    size_t m_matchIndex = 0;
+    bool m_on_match = false;            // The zoom area contains the current match.
+    bool m_show_ruler = false;          // Dragging measures instead of moving the zoom area.
+    bool m_has_ruler = false;
+    bool m_measuring = false;
+    POINT m_rulerFrom = {};             // Pixel corners, in screen coordinates.
+    POINT m_rulerTo = {};
+    EdgeMap m_edges;
+    bool m_show_elements = false;
+    ElementFinder m_elements;
+    HFONT m_hfontOverlay = NULL;
+    ReferenceImage m_onion;
+    bool m_show_onion = false;
+    POINT m_onionPos = {};              // Top left of the image, in screen coordinates.
+    INT m_onionOpacity = 50;            // Percent.
+    std::vector<uint32_t> m_onionPixels;
+    FilterStep m_filters[c_max_filters];
+    FilterPipeline m_pipeline;
+    bool m_apply_filters = false;
+    std::vector<uint32_t> m_filteredPixels;
+    std::vector<uint32_t> m_filteredBaseline;
     bool m_captured = false;
     bool m_refresh = false;
+    bool m_timer = false;
+    bool m_locked = false;
+    bool m_suspended = false;
+    bool m_covered = false;             // Cloaked or occluded, as of the last check.
+    double m_suspendStart = 0;
     INT m_interval = 0;
+    bool m_adaptive = false;
+    INT m_adaptiveMinRate = 1;
+    INT m_adaptiveMaxRate = 30;
+    UINT m_adaptiveMs = 0;
+    uint64_t m_frameHash = 0;
     COLORREF m_crGridlines = RGB(0, 0, 0);
     COLORREF m_crReticle = RGB(255, 0, 0);
     COLORREF m_crReticleBorder = RGB(255, 255, 255);
     INT m_reticleOpacity = 75;
     std::unique_ptr<ZoomReticle> m_reticle;
     SizeTracker m_sizeTracker;
+    bool m_resident = false;
+    bool m_residentSetting = false;         // Saved preference; --resident only overrides it for this run.
+    WORD m_hotkey = 0;
+    bool m_hotkeyRegistered = false;
+    bool m_trayIcon = false;
+    HICON m_hiconTray = NULL;
+
+    struct
+    {
+        ULONG captures = 0;
+        ULONG frames = 0;
+        double capture_seconds = 0;
+        double render_seconds = 0;
+        ULONG renderer_frames[RK_COUNT] = {};
+        double renderer_seconds[RK_COUNT] = {};
+        ULONG labels_updated = 0;
+        ULONG suspensions = 0;
+        double suspended_seconds = 0;
+    } m_stats;
 };
 
 static Zoomin s_zoomin;
 
 LRESULT CALLBACK Zoomin::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
+    // Explorer restarted; the tray icon needs to be added again.
+    if (msg == g_msgTaskbarCreated && g_msgTaskbarCreated)
+    {
+        s_zoomin.UpdateTrayIcon(true);
+        return 0;
+    }
+
     switch (msg)
     {
     case WM_ERASEBKGND:
@@ -351,6 +637,9 @@ LRESULT CALLBACK Zoomin::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPar
         s_zoomin.RelayEvent(msg, wParam, lParam);
         s_zoomin.OnMouseMove(lParam);
         break;
+    case WM_MOUSELEAVE:
+        s_zoomin.OnMouseLeave();
+        break;
     case WM_NCMOUSEMOVE:
         s_zoomin.RelayEvent(msg, wParam, lParam);
         goto LDefault;
@@ -385,8 +674,20 @@ LRESULT CALLBACK Zoomin::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPar
     case WM_WINDOWPOSCHANGED:
         s_zoomin.OnSize();
         goto LDefault;
+    case WM_WTSSESSION_CHANGE:
+        s_zoomin.OnSessionChange(wParam);
+        break;
+    case WM_DISPLAYCHANGE:
+        InvalidateMonitorCache();
+        s_zoomin.m_capture.Invalidate();
+        goto LDefault;
+    case WM_SETTINGCHANGE:
+        // E.g. the work area changed.
+        InvalidateMonitorCache();
+        goto LDefault;
     case WM_DPICHANGED:
         {
+            InvalidateMonitorCache();
             const RECT& rc = *LPCRECT(lParam);
             const DWORD c_flags = SWP_NOACTIVATE|SWP_NOZORDER|SWP_NOOWNERZORDER|SWP_DRAWFRAME;
             s_zoomin.OnDpiChanged(DpiScaler(wParam));
@@ -394,6 +695,26 @@ LRESULT CALLBACK Zoomin::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPar
         }
         break;
 
+    case WM_HOTKEY:
+        if (wParam == c_hotkey_id)
+            s_zoomin.OnHotkey();
+        break;
+    case WMU_TRAYNOTIFY:
+        s_zoomin.OnTrayNotify(lParam);
+        break;
+
+    case WM_CLOSE:
+        // In resident mode closing only hides the window; exit from the tray.
+        if (!s_zoomin.m_resident)
+            goto LDefault;
+        s_zoomin.HideToTray();
+        break;
+    case WM_ENDSESSION:
+        // A resident instance usually isn't destroyed before the session ends.
+        if (wParam)
+            s_zoomin.WriteSettings();
+        break;
+
     case WM_CREATE:
         s_zoomin.OnCreate(hwnd);
         goto LDefault;
@@ -416,32 +737,27 @@ void Zoomin::OnCreate(HWND hwnd)
 {
     m_hwnd = hwnd;
     m_dpi = __GetDpiForWindow(m_hwnd);
+    StartupMark(L"GetDpiForWindow");
     Init();
     SendMessage(hwnd, WM_SETICON, true, LPARAM(LoadImage(g_hinst, MAKEINTRESOURCE(IDI_MAIN), IMAGE_ICON, 0, 0, 0)));
     SendMessage(hwnd, WM_SETICON, false, LPARAM(LoadImage(g_hinst, MAKEINTRESOURCE(IDI_MAIN), IMAGE_ICON, 16, 16, 0)));
-    m_sizeTracker.OnCreate(hwnd);
+    StartupMark(L"Icons");
+    m_sizeTracker.OnCreate(hwnd, !g_start_hidden);
+    StartupMark(L"SizeTracker::OnCreate");
+    WTSRegisterSessionNotification(hwnd, NOTIFY_FOR_THIS_SESSION);
+
+    g_msgTaskbarCreated = RegisterWindowMessage(TEXT("TaskbarCreated"));
+    m_residentSetting = !!ReadSetting(TEXT("Resident"), false);
+    SetResident(m_residentSetting || g_start_hidden, WORD(ReadSetting(TEXT("Hotkey"), c_default_hotkey)));
+    if (m_resident)
+        PrewarmResident();
 }
 
 void Zoomin::OnDestroy()
 {
-    m_sizeTracker.OnDestroy();
-
-    WriteRegLong(TEXT("PointX"), m_pt.x);
-    WriteRegLong(TEXT("PointY"), m_pt.y);
-    WriteRegLong(TEXT("ZoomFactor"), m_factor);
-    WriteRegLong(TEXT("RefreshEnabled"), m_refresh);
-    WriteRegLong(TEXT("RefreshInterval"), m_interval);
-
-    WriteRegLong(TEXT("GridlinesColor"), m_crGridlines);
-    WriteRegLong(TEXT("ReticleColor"), m_crReticle);
-    WriteRegLong(TEXT("ReticleOutlineColor"), m_crReticleBorder);
-    WriteRegLong(TEXT("ReticleOpacity"), clamp<INT>(m_reticleOpacity, 10, 100));
-
-    for (size_t ii = _countof(m_show_gridlines); ii--;)
-    {
-        WriteRegLong(c_show_gridlines_name[ii], m_show_gridlines[ii]);
-        WriteRegLong(c_gridline_spacing_name[ii], m_gridline_spacing[ii]);
-    }
+    WTSUnRegisterSessionNotification(m_hwnd);
+    WriteSettings();
+    SetResident(false, m_hotkey);
 
     if (m_tooltips)
     {
@@ -454,6 +770,64 @@ void Zoomin::OnDestroy()
         DeleteObject(m_hpal);
         m_hpal = NULL;
     }
+
+    if (m_hfontOverlay)
+    {
+        DeleteObject(m_hfontOverlay);
+        m_hfontOverlay = NULL;
+    }
+
+    m_statsPanel.Destroy();
+    m_timeline.Destroy();
+    m_cadence.Stop();
+    m_capture.Free();
+    m_renderer.reset();
+}
+
+void Zoomin::WriteSettings()
+{
+    m_sizeTracker.WriteSettings();
+
+    WriteSetting(TEXT("PointX"), m_pt.x);
+    WriteSetting(TEXT("PointY"), m_pt.y);
+    WriteSetting(TEXT("ZoomFactor"), m_factor);
+    WriteSetting(TEXT("RefreshEnabled"), m_refresh);
+    WriteSetting(TEXT("RefreshInterval"), m_interval);
+    WriteSetting(TEXT("AdaptiveRefresh"), m_adaptive);
+    WriteSetting(TEXT("AdaptiveMinRate"), m_adaptiveMinRate);
+    WriteSetting(TEXT("AdaptiveMaxRate"), m_adaptiveMaxRate);
+    WriteSetting(TEXT("Resident"), m_residentSetting);
+    WriteSetting(TEXT("Hotkey"), m_hotkey);
+    WriteSetting(TEXT("Renderer"), m_rendererKind);
+    WriteSetting(TEXT("Subpixels"), m_subpixels);
+    WriteSetting(TEXT("PixelLabels"), m_show_labels);
+    WriteSetting(TEXT("PixelLabelsHex"), m_labels_hex);
+    WriteSetting(TEXT("Inspector"), m_show_inspector);
+    WriteSetting(TEXT("RegionStats"), m_statsPanel.IsShown());
+    WriteSetting(TEXT("PixelTimeline"), m_timeline.IsShown());
+    WriteSetting(TEXT("DiffHeatmap"), m_diff_heatmap);
+    WriteSetting(TEXT("SearchTolerant"), m_search_tolerant);
+    WriteSetting(TEXT("OnionSkinOpacity"), m_onionOpacity);
+    WriteSetting(TEXT("ApplyFilters"), m_apply_filters);
+
+    WriteSetting(TEXT("GridlinesColor"), m_crGridlines);
+    WriteSetting(TEXT("ReticleColor"), m_crReticle);
+    WriteSetting(TEXT("ReticleOutlineColor"), m_crReticleBorder);
+    WriteSetting(TEXT("ReticleOpacity"), clamp<INT>(m_reticleOpacity, 10, 100));
+
+    for (size_t ii = _countof(m_show_gridlines); ii--;)
+    {
+        WriteSetting(c_show_gridlines_name[ii], m_show_gridlines[ii]);
+        WriteSetting(c_gridline_spacing_name[ii], m_gridline_spacing[ii]);
+    }
+
+    for (size_t ii = 0; ii < c_max_filters; ++ii)
+    {
+        WriteSetting(c_filter_name[ii], m_filters[ii].kind);
+        WriteSetting(c_filter_param_name[ii], m_filters[ii].param);
+    }
+
+    GetSettings().Save();
 }
 
 void Zoomin::OnPaint()
@@ -462,19 +836,46 @@ void Zoomin::OnPaint()
     BeginPaint(m_hwnd, &ps);
     SaveDC(ps.hdc);
 
-    PaintZoomRect(ps.hdc);
+    // Repaint from the retained capture when it covers the zoom area; e.g.
+    // zoom factor changes and window resizing only need to re-render.
+    PaintZoomRect(ps.hdc, false);
 
     RestoreDC(ps.hdc, -1);
     EndPaint(m_hwnd, &ps);
+
+    // Startup is complete after the first paint, even if there was nothing to
+    // zoom (e.g. no saved point yet), so --startup-trace always finishes.
+    StartupComplete(L"First WM_PAINT");
 }
 
 void Zoomin::OnTimer(WPARAM wParam)
 {
     if (wParam == c_refresh_timer_id)
     {
+        if (CheckSuspended())
+            return;
+
         const HCURSOR hcur = SetCursor(LoadCursor(NULL, IDC_WAIT));
         PaintZoomRect();
         SetCursor(hcur);
+
+        if (m_adaptive)
+            AdaptRefreshRate();
+    }
+    else if (wParam == c_covered_timer_id)
+    {
+        UpdateCovered();
+        CheckSuspended();
+    }
+    else if (wParam == c_cadence_timer_id)
+    {
+        UpdateTitle();
+    }
+    else if (wParam == c_trim_timer_id)
+    {
+        // Resident and hidden for a while; give back pages until activated.
+        KillTimer(m_hwnd, c_trim_timer_id);
+        SetProcessWorkingSetSize(GetCurrentProcess(), SIZE_T(-1), SIZE_T(-1));
     }
 }
 
@@ -484,10 +885,24 @@ void Zoomin::OnButtonDown(LPARAM lParam)
     RECT rcClient;
     pt.x = SHORT(LOWORD(lParam));
     pt.y = SHORT(HIWORD(lParam));
-    GetClientRect(m_hwnd, &rcClient);
+    GetZoomClientRect(rcClient);
     if (!PtInRect(&rcClient, pt))
         return;
 
+    if (m_show_ruler)
+    {
+        if (!GetRulerCorner(lParam, m_rulerFrom))
+            return;
+        m_rulerTo = m_rulerFrom;
+        m_has_ruler = true;
+        m_measuring = true;
+        SetCapture(m_hwnd);
+        m_captured = true;
+        UpdateTitle();
+        PaintZoomRect(NULL, false);
+        return;
+    }
+
     RECT rc;
     if (!GetZoomArea(rc))
         return;
@@ -516,10 +931,39 @@ void Zoomin::OnButtonDown(LPARAM lParam)
 
 void Zoomin::OnMouseMove(LPARAM lParam)
 {
-    if (!m_captured)
+    if (m_captured)
+    {
+        if (!m_measuring)
+        {
+            SetZoomPoint(lParam);
+        }
+        else if (GetRulerCorner(lParam, m_rulerTo))
+        {
+            UpdateTitle();
+            PaintZoomRect(NULL, false);
+        }
         return;
+    }
 
-    SetZoomPoint(lParam);
+    if (!m_trackingMouse)
+    {
+        TRACKMOUSEEVENT tme = { sizeof(tme) };
+        tme.dwFlags = TME_LEAVE;
+        tme.hwndTrack = m_hwnd;
+        m_trackingMouse = !!TrackMouseEvent(&tme);
+    }
+
+    m_ptInspect.x = SHORT(LOWORD(lParam));
+    m_ptInspect.y = SHORT(HIWORD(lParam));
+    UpdateInspector();
+}
+
+void Zoomin::OnMouseLeave()
+{
+    m_trackingMouse = false;
+    m_ptInspect.x = -1;
+    m_ptInspect.y = -1;
+    UpdateInspector();
 }
 
 void Zoomin::OnCancelMode()
@@ -528,6 +972,7 @@ void Zoomin::OnCancelMode()
         return;
 
     m_reticle = nullptr;
+    m_measuring = false;
 
     ReleaseCapture();
     m_captured = false;
@@ -568,7 +1013,29 @@ void Zoomin::OnKeyDown(WPARAM wParam, LPARAM lParam)
     case VK_DOWN:
     case VK_LEFT:
     case VK_RIGHT:
-        if (m_pt.x != MAXINT && m_pt.y != MAXINT)
+        if (m_show_onion && !m_onion.IsEmpty())
+        {
+            // Nudge the onion skin instead of the zoom area.
+            const LONG step = (GetKeyState(VK_SHIFT) < 0) ? 8 : 1;
+            switch (wParam)
+            {
+            case VK_UP:
+                m_onionPos.y -= step;
+                break;
+            case VK_DOWN:
+                m_onionPos.y += step;
+                break;
+            case VK_LEFT:
+                m_onionPos.x -= step;
+                break;
+            case VK_RIGHT:
+                m_onionPos.x += step;
+                break;
+            }
+            UpdateTitle();
+            PaintZoomRect(NULL, false);
+        }
+        else if (m_pt.x != MAXINT && m_pt.y != MAXINT)
         {
             const bool shift = (GetKeyState(VK_SHIFT) < 0);
             const bool ctrl = (GetKeyState(VK_CONTROL) < 0);
@@ -605,6 +1072,31 @@ void Zoomin::OnKeyDown(WPARAM wParam, LPARAM lParam)
 void Zoomin::OnInitMenuPopup(HMENU hmenu)
 {
     CheckMenuItem(hmenu, IDM_OPTIONS_GRIDLINES, m_show_gridlines[0] ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_LABELS, m_show_labels ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_LABELS_HEX, m_labels_hex ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_INSPECTOR, m_show_inspector ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_REGIONSTATS, m_statsPanel.IsShown() ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_DIFF, m_show_diff ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_DIFF_HEATMAP, m_diff_heatmap ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_FLICKER, m_show_flicker ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_TIMELINE, m_timeline.IsShown() ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_RULER, m_show_ruler ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_ELEMENTS, m_show_elements ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_OPTIONS_FILTERS, m_apply_filters ? MF_CHECKED : MF_UNCHECKED);
+    EnableMenuItem(hmenu, IDM_OPTIONS_FILTERS, m_pipeline.IsEmpty() ? MF_GRAYED : MF_ENABLED);
+    CheckMenuItem(hmenu, IDM_OVERLAY_SHOW, (m_show_onion && !m_onion.IsEmpty()) ? MF_CHECKED : MF_UNCHECKED);
+    EnableMenuItem(hmenu, IDM_OVERLAY_MORE_OPAQUE, (!m_onion.IsEmpty() && m_onionOpacity < 100) ? MF_ENABLED : MF_GRAYED);
+    EnableMenuItem(hmenu, IDM_OVERLAY_LESS_OPAQUE, (!m_onion.IsEmpty() && m_onionOpacity > c_onion_opacity_step) ? MF_ENABLED : MF_GRAYED);
+    EnableMenuItem(hmenu, IDM_OVERLAY_RESET, m_onion.IsEmpty() ? MF_GRAYED : MF_ENABLED);
+    CheckMenuItem(hmenu, IDM_EDIT_CADENCE, m_cadence.IsRunning() ? MF_CHECKED : MF_UNCHECKED);
+    CheckMenuItem(hmenu, IDM_SEARCH_TOLERANT, m_search_tolerant ? MF_CHECKED : MF_UNCHECKED);
+    EnableMenuItem(hmenu, IDM_SEARCH_CLIPBOARD, IsClipboardFormatAvailable(CF_BITMAP) ? MF_ENABLED : MF_GRAYED);
+    EnableMenuItem(hmenu, IDM_SEARCH_NEXT, m_matches.empty() ? MF_GRAYED : MF_ENABLED);
+    EnableMenuItem(hmenu, IDM_SEARCH_PREVIOUS, m_matches.empty() ? MF_GRAYED : MF_ENABLED);
+    EnableMenuItem(hmenu, IDM_EDIT_CLEARPROBES, m_timeline.GetProbeCount() ? MF_ENABLED : MF_GRAYED);
+    if (m_renderer)
+        CheckMenuRadioItem(hmenu, IDM_RENDERER_GDI, IDM_RENDERER_SOFTWARE, IDM_RENDERER_GDI + m_renderer->GetKind(), MF_BYCOMMAND);
+    CheckMenuRadioItem(hmenu, IDM_SUBPIXELS_OFF, IDM_SUBPIXELS_BGR, IDM_SUBPIXELS_OFF + m_subpixels, MF_BYCOMMAND);
 }
 
 bool Zoomin::OnCommand(WORD id, WORD code, HWND hwndCtrl)
@@ -617,17 +1109,157 @@ bool Zoomin::OnCommand(WORD id, WORD code, HWND hwndCtrl)
     case IDM_EDIT_REFRESH:
         PaintZoomRect();
         break;
+    case IDM_EDIT_BASELINE:
+        SetBaseline();
+        break;
+    case IDM_EDIT_ADDPROBE:
+        AddTimelineProbe();
+        break;
+    case IDM_EDIT_CLEARPROBES:
+        m_timeline.ClearProbes();
+        break;
+    case IDM_EDIT_CADENCE:
+        AnalyzeCadence(!m_cadence.IsRunning());
+        break;
+    case IDM_SEARCH_ZOOMAREA:
+        {
+            RECT rc;
+            PixelSource src;
+            if (!GetZoomArea(rc) || !EnsureCapture(rc, false) || !GetZoomSource(rc, src))
+            {
+                MessageBeep(0xffffffff);
+                break;
+            }
+            ImageBuffer image;
+            image.cx = src.cx;
+            image.cy = src.cy;
+            image.pixels.resize(size_t(src.cx) * src.cy);
+            for (int32_t yy = 0; yy < src.cy; ++yy)
+                memcpy(&image.pixels[size_t(yy) * src.cx], src.bits + yy * src.stride, src.cx * sizeof(uint32_t));
+            m_searchTemplate = std::move(image);
+            SearchForTemplate();
+        }
+        break;
+    case IDM_SEARCH_CLIPBOARD:
+        if (GetClipboardImage(m_hwnd, m_searchTemplate))
+            SearchForTemplate();
+        else
+            MessageBeep(0xffffffff);
+        break;
+    case IDM_SEARCH_FILE:
+        {
+            WCHAR path[MAX_PATH] = {};
+            if (!BrowseImageFile(m_hwnd, TEXT("Find Image"), path, _countof(path)))
+                break;
+            if (LoadImageFile(path, m_searchTemplate))
+                SearchForTemplate();
+            else
+                MessageBeep(0xffffffff);
+        }
+        break;
+    case IDM_SEARCH_NEXT:
+    case IDM_SEARCH_PREVIOUS:
+        if (m_matches.empty())
+            MessageBeep(0xffffffff);
+        else if (id == IDM_SEARCH_NEXT)
+            GoToMatch((m_matchIndex + 1) % m_matches.size());
+        else
+            GoToMatch((m_matchIndex + m_matches.size() - 1) % m_matches.size());
+        break;
+    case IDM_SEARCH_TOLERANT:
+        m_search_tolerant = !m_search_tolerant;
+        if (!m_searchTemplate.IsEmpty())
+            SearchForTemplate();
+        break;
+    case IDM_OVERLAY_LOAD:
+        LoadOnionSkin();
+        break;
+    case IDM_OVERLAY_SHOW:
+        ShowOnionSkin(!(m_show_onion && !m_onion.IsEmpty()));
+        break;
+    case IDM_OVERLAY_MORE_OPAQUE:
+        SetOnionOpacity(m_onionOpacity + c_onion_opacity_step);
+        break;
+    case IDM_OVERLAY_LESS_OPAQUE:
+        SetOnionOpacity(m_onionOpacity - c_onion_opacity_step);
+        break;
+    case IDM_OVERLAY_RESET:
+        ResetOnionOffset();
+        break;
     case IDM_OPTIONS_GRIDLINES:
         m_show_gridlines[0] = !m_show_gridlines[0];
-        PaintZoomRect();
+        PaintZoomRect(NULL, false);
+        break;
+    case IDM_OPTIONS_LABELS:
+        m_show_labels = !m_show_labels;
+        PaintZoomRect(NULL, false);
+        break;
+    case IDM_OPTIONS_LABELS_HEX:
+        m_labels_hex = !m_labels_hex;
+        PaintZoomRect(NULL, false);
+        break;
+    case IDM_OPTIONS_INSPECTOR:
+        ShowInspector(!m_show_inspector);
+        break;
+    case IDM_OPTIONS_REGIONSTATS:
+        ShowRegionStats(!m_statsPanel.IsShown());
+        break;
+    case IDM_OPTIONS_DIFF:
+        ShowDifferences(!m_show_diff);
+        break;
+    case IDM_OPTIONS_DIFF_HEATMAP:
+        m_diff_heatmap = !m_diff_heatmap;
+        PaintZoomRect(NULL, false);
+        break;
+    case IDM_OPTIONS_FLICKER:
+        ShowFlicker(!m_show_flicker);
+        break;
+    case IDM_OPTIONS_TIMELINE:
+        ShowTimeline(!m_timeline.IsShown());
+        break;
+    case IDM_OPTIONS_RULER:
+        ShowRuler(!m_show_ruler);
+        break;
+    case IDM_OPTIONS_ELEMENTS:
+        ShowElements(!m_show_elements);
+        break;
+    case IDM_OPTIONS_FILTERS:
+        SetFilters(m_filters, !m_apply_filters);
+        break;
+    case IDM_RENDERER_GDI:
+    case IDM_RENDERER_DIRECT2D:
+    case IDM_RENDERER_SOFTWARE:
+        SetRenderer(RendererKind(id - IDM_RENDERER_GDI));
+        PaintZoomRect(NULL, false);
+        break;
+    case IDM_SUBPIXELS_OFF:
+    case IDM_SUBPIXELS_RGB:
+    case IDM_SUBPIXELS_BGR:
+        m_subpixels = SubpixelOrder(id - IDM_SUBPIXELS_OFF);
+        UpdateTitle();
+        PaintZoomRect(NULL, false);
+        break;
+    case IDM_TRAY_SHOW:
+        Activate(false);
+        break;
+    case IDM_TRAY_EXIT:
+        DestroyWindow(m_hwnd);
         break;
+
     case IDM_OPTIONS_OPTIONS:
+        {
+            INITCOMMONCONTROLSEX icc = { sizeof(icc), ICC_HOTKEY_CLASS };
+            InitCommonControlsEx(&icc);
+        }
         if (DialogBox(g_hinst, MAKEINTRESOURCE(IDD_OPTIONS), m_hwnd, OptionsDlgProc))
-            PaintZoomRect();
+            PaintZoomRect(NULL, false);
         break;
     case IDM_HELP_ABOUT:
         DialogBox(g_hinst, MAKEINTRESOURCE(IDD_ABOUT), m_hwnd, AboutDlgProc);
         break;
+    case IDM_HELP_STATISTICS:
+        ShowStatistics();
+        break;
     case IDM_REFRESH_ONOFF:
         SetRefresh(!m_refresh);
         break;
@@ -707,41 +1339,263 @@ LRESULT Zoomin::OnNotify(WPARAM wParam, LPARAM lParam)
 void Zoomin::OnSize()
 {
     m_sizeTracker.OnSize();
+    m_statsPanel.OnOwnerChanged();
+    LayoutStatusBar();
+    LayoutTimeline();
     CalcZoomArea();
+
+    // Minimizing stops the refresh timer, and restoring catches up.
+    UpdateTimer();
+    CheckSuspended();
 }
 
 void Zoomin::OnDpiChanged(const DpiScaler& dpi)
 {
     m_dpi.OnDpiChanged(dpi);
     m_sizeTracker.OnDpiChanged(dpi);
+    if (m_hfontOverlay)
+    {
+        DeleteObject(m_hfontOverlay);
+        m_hfontOverlay = NULL;
+    }
+    m_timeline.OnDpiChanged(dpi);
+    LayoutStatusBar();
+    LayoutTimeline();
     CalcZoomArea();
     InvalidateRect(m_hwnd, nullptr, false);
 }
 
+void Zoomin::OnSessionChange(WPARAM wParam)
+{
+    switch (wParam)
+    {
+    case WTS_SESSION_LOCK:
+        m_locked = true;
+        break;
+    case WTS_SESSION_UNLOCK:
+        m_locked = false;
+        break;
+    default:
+        return;
+    }
+
+    UpdateTimer();
+    CheckSuspended();
+}
+
+void Zoomin::OnHotkey()
+{
+    // The hotkey toggles a resident window.
+    if (IsWindowVisible(m_hwnd) && !IsIconic(m_hwnd) && GetForegroundWindow() == m_hwnd)
+        HideToTray();
+    else
+        Activate(true);
+}
+
+void Zoomin::OnTrayNotify(LPARAM lParam)
+{
+    switch (lParam)
+    {
+    case WM_LBUTTONUP:
+        Activate(false);
+        break;
+    case WM_RBUTTONUP:
+        {
+            const HMENU hmenu = LoadMenu(g_hinst, MAKEINTRESOURCE(IDR_TRAYMENU));
+            if (!hmenu)
+                break;
+
+            POINT pt;
+            GetCursorPos(&pt);
+            SetMenuDefaultItem(GetSubMenu(hmenu, 0), IDM_TRAY_SHOW, false);
+
+            // The window must be foreground for the menu to dismiss properly.
+            SetForegroundWindow(m_hwnd);
+            TrackPopupMenu(GetSubMenu(hmenu, 0), TPM_RIGHTBUTTON, pt.x, pt.y, 0, m_hwnd, nullptr);
+            PostMessage(m_hwnd, WM_NULL, 0, 0);
+            DestroyMenu(hmenu);
+        }
+        break;
+    }
+}
+
+void Zoomin::SetResident(bool resident, WORD hotkey)
+{
+    m_resident = resident;
+    m_hotkey = hotkey;
+
+    if (m_hotkeyRegistered)
+    {
+        UnregisterHotKey(m_hwnd, c_hotkey_id);
+        m_hotkeyRegistered = false;
+    }
+
+    if (m_resident && LOBYTE(m_hotkey))
+    {
+        // The hotkey is stored in the hotkey control's format.
+        UINT mods = MOD_NOREPEAT;
+        if (HIBYTE(m_hotkey) & HOTKEYF_ALT)
+            mods |= MOD_ALT;
+        if (HIBYTE(m_hotkey) & HOTKEYF_CONTROL)
+            mods |= MOD_CONTROL;
+        if (HIBYTE(m_hotkey) & HOTKEYF_SHIFT)
+            mods |= MOD_SHIFT;
+        m_hotkeyRegistered = !!RegisterHotKey(m_hwnd, c_hotkey_id, mods, LOBYTE(m_hotkey));
+    }
+
+    UpdateTrayIcon();
+
+    if (!m_resident)
+        KillTimer(m_hwnd, c_trim_timer_id);
+}
+
+void Zoomin::UpdateTrayIcon(bool recreate)
+{
+    NOTIFYICONDATA nid = { sizeof(nid) };
+    nid.hWnd = m_hwnd;
+    nid.uID = c_tray_icon_id;
+
+    if (!m_resident || recreate)
+    {
+        if (m_trayIcon)
+            Shell_NotifyIcon(NIM_DELETE, &nid);
+        m_trayIcon = false;
+    }
+
+    if (!m_resident)
+    {
+        if (m_hiconTray)
+        {
+            DestroyIcon(m_hiconTray);
+            m_hiconTray = NULL;
+        }
+        return;
+    }
+
+    if (m_trayIcon)
+        return;
+
+    if (!m_hiconTray)
+        LoadIconMetric(g_hinst, MAKEINTRESOURCE(IDI_MAIN), LIM_SMALL, &m_hiconTray);
+
+    nid.uFlags = NIF_ICON|NIF_MESSAGE|NIF_TIP;
+    nid.uCallbackMessage = WMU_TRAYNOTIFY;
+    nid.hIcon = m_hiconTray;
+    lstrcpyn(nid.szTip, TEXT("Zoomin"), _countof(nid.szTip));
+    m_trayIcon = !!Shell_NotifyIcon(NIM_ADD, &nid);
+}
+
+void Zoomin::PrewarmResident()
+{
+    // Allocate the capture and back buffers, and create (and discard) a
+    // reticle so its window classes and modules are loaded, so activation
+    // only has to capture and paint.
+    RECT rc;
+    const RenderTarget target = GetRenderTarget(NULL);
+    if (m_renderer && target.cx > 0 && target.cy > 0)
+        m_renderer->Prepare(target);
+    if (GetZoomArea(rc))
+    {
+        EnsureCapture(rc, true);
+
+        ZoomReticleSettings settings;
+        settings.m_mainColor = m_crReticle;
+        settings.m_borderColor = m_crReticleBorder;
+        settings.m_opacity = m_reticleOpacity;
+        std::unique_ptr<ZoomReticle> reticle = CreateZoomReticle(g_hinst, rc.right - rc.left, rc.bottom - rc.top, settings);
+        if (reticle)
+            reticle->InitReticle();
+    }
+
+    if (!IsWindowVisible(m_hwnd))
+        SetTimer(m_hwnd, c_trim_timer_id, c_trim_delay, nullptr);
+}
+
+void Zoomin::Activate(bool atCursor)
+{
+    KillTimer(m_hwnd, c_trim_timer_id);
+
+    const bool hidden = !IsWindowVisible(m_hwnd);
+    if (hidden && atCursor && !IsZoomed(m_hwnd))
+    {
+        POINT pt;
+        CachedMonitorInfo info;
+        if (GetCursorPos(&pt) && GetCachedMonitorInfo(pt, info))
+        {
+            RECT rc;
+            GetWindowRect(m_hwnd, &rc);
+            const LONG cx = rc.right - rc.left;
+            const LONG cy = rc.bottom - rc.top;
+            const LONG x = clamp<LONG>(pt.x - cx / 2, info.rcWork.left, std::max<LONG>(info.rcWork.left, info.rcWork.right - cx));
+            const LONG y = clamp<LONG>(pt.y - cy / 2, info.rcWork.top, std::max<LONG>(info.rcWork.top, info.rcWork.bottom - cy));
+            SetWindowPos(m_hwnd, NULL, x, y, 0, 0, SWP_NOSIZE|SWP_NOZORDER|SWP_NOACTIVATE);
+        }
+    }
+
+    // Capture while still hidden, so the first paint after showing only has
+    // to render.  With auto-refresh on, resuming catches up instead.
+    if (hidden && !m_refresh)
+        PaintZoomRect();
+
+    ShowWindow(m_hwnd, IsIconic(m_hwnd) ? SW_RESTORE : SW_SHOW);
+    SetForegroundWindow(m_hwnd);
+}
+
+void Zoomin::HideToTray()
+{
+    if (m_captured)
+        OnCancelMode();
+
+    ShowWindow(m_hwnd, SW_HIDE);
+    WriteSettings();
+    SetTimer(m_hwnd, c_trim_timer_id, c_trim_delay, nullptr);
+}
+
 void Zoomin::Init()
 {
     POINT pt;
-    pt.x = ReadRegLong(TEXT("PointX"), MAXINT);
-    pt.y = ReadRegLong(TEXT("PointY"), MAXINT);
+    pt.x = ReadSetting(TEXT("PointX"), MAXINT);
+    pt.y = ReadSetting(TEXT("PointY"), MAXINT);
     SetZoomPoint(pt);
 
-    SetZoomFactor(ReadRegLong(TEXT("ZoomFactor"), 4));
+    SetZoomFactor(ReadSetting(TEXT("ZoomFactor"), 4));
 
-    SetInterval(ReadRegLong(TEXT("RefreshInterval"), 20));
-    SetRefresh(!!ReadRegLong(TEXT("RefreshEnabled"), false));
+    SetInterval(ReadSetting(TEXT("RefreshInterval"), 20));
+    SetAdaptive(!!ReadSetting(TEXT("AdaptiveRefresh"), false),
+                ReadSetting(TEXT("AdaptiveMinRate"), 1),
+                ReadSetting(TEXT("AdaptiveMaxRate"), 30));
+    SetRefresh(!!ReadSetting(TEXT("RefreshEnabled"), false));
 
-    m_crGridlines = ReadRegLong(L"GridlinesColor", RGB(0, 0, 0));
-    m_crReticle = ReadRegLong(L"ReticleColor", RGB(255, 0, 0));
-    m_crReticleBorder = ReadRegLong(L"ReticleOutlineColor", RGB(255, 255, 255));
-    SetReticleOpacity(ReadRegLong(L"ReticleOpacity", 75));
+    m_crGridlines = ReadSetting(L"GridlinesColor", RGB(0, 0, 0));
+    m_crReticle = ReadSetting(L"ReticleColor", RGB(255, 0, 0));
+    m_crReticleBorder = ReadSetting(L"ReticleOutlineColor", RGB(255, 255, 255));
+    SetReticleOpacity(ReadSetting(L"ReticleOpacity", 75));
 
     for (size_t ii = _countof(m_show_gridlines); ii--;)
     {
-        m_show_gridlines[ii] = !!ReadRegLong(c_show_gridlines_name[ii], false);
-        m_gridline_spacing[ii] = ReadRegLong(c_gridline_spacing_name[ii], c_default_gridlines_spacing[ii]);
+        m_show_gridlines[ii] = !!ReadSetting(c_show_gridlines_name[ii], false);
+        m_gridline_spacing[ii] = ReadSetting(c_gridline_spacing_name[ii], c_default_gridlines_spacing[ii]);
+    }
+    SetRenderer(RendererKind(clamp<LONG>(ReadSetting(TEXT("Renderer"), RK_GDI), 0, RK_COUNT - 1)));
+    m_subpixels = SubpixelOrder(clamp<LONG>(ReadSetting(TEXT("Subpixels"), SO_NONE), 0, SO_COUNT - 1));
+    m_show_labels = !!ReadSetting(TEXT("PixelLabels"), false);
+    m_labels_hex = !!ReadSetting(TEXT("PixelLabelsHex"), true);
+    m_show_inspector = !!ReadSetting(TEXT("Inspector"), true);
+    m_diff_heatmap = !!ReadSetting(TEXT("DiffHeatmap"), true);
+    m_search_tolerant = !!ReadSetting(TEXT("SearchTolerant"), false);
+    m_onionOpacity = clamp<INT>(ReadSetting(TEXT("OnionSkinOpacity"), 50), c_onion_opacity_step, 100);
+    for (size_t ii = 0; ii < c_max_filters; ++ii)
+    {
+        const FilterKind kind = FilterKind(clamp<LONG>(ReadSetting(c_filter_name[ii], FK_NONE), FK_NONE, FK_COUNT - 1));
+        m_filters[ii].kind = kind;
+        m_filters[ii].param = ClampFilterParam(kind, ReadSetting(c_filter_param_name[ii], GetDefaultFilterParam(kind)));
     }
+    m_pipeline.Compile(m_filters, c_max_filters);
+    m_apply_filters = (!!ReadSetting(TEXT("ApplyFilters"), false) && !m_pipeline.IsEmpty());
+    StartupMark(L"Init: registry settings");
 
     m_hpal = CreatePhysicalPalette();
+    StartupMark(L"Init: palette");
 
     m_tooltips = CreateWindow(TOOLTIPS_CLASS, L"", WS_POPUP,
                             CW_USEDEFAULT, CW_USEDEFAULT,
@@ -758,18 +1612,115 @@ void Zoomin::Init()
         ti.lpszText = L"Click and drag to select zoomin area.";
         SendMessage(m_tooltips, TTM_ADDTOOL, 0, LPARAM(&ti));
     }
+    StartupMark(L"Init: tooltip");
+
+    INITCOMMONCONTROLSEX icc = { sizeof(icc), ICC_BAR_CLASSES };
+    InitCommonControlsEx(&icc);
+    m_statusbar = CreateWindow(STATUSCLASSNAME, L"", WS_CHILD|SBARS_SIZEGRIP,
+                               0, 0, 0, 0,
+                               m_hwnd, NULL, g_hinst, NULL);
+    ShowInspector(m_show_inspector);
+    StartupMark(L"Init: status bar");
+
+    // The panel stays hidden until the main window is shown.
+    if (ReadSetting(TEXT("RegionStats"), false) && m_statsPanel.Create(g_hinst, m_hwnd))
+        m_statsPanel.Show(true);
+    StartupMark(L"Init: region statistics");
+
+    if (ReadSetting(TEXT("PixelTimeline"), false))
+        ShowTimeline(true);
+    StartupMark(L"Init: pixel timeline");
 }
 
 void Zoomin::UpdateTitle()
 {
-    WCHAR title[64];
-    wsprintfW(title, TEXT("Zoomin \u00b7 %ux"), m_factor);
-    SetWindowText(m_hwnd, title);
-}
+    // The segments are each formatted into a small buffer, and the title grows
+    // as needed, since many modes can be on at once.
+    WCHAR base[80];
+    if (m_refresh && m_adaptive && m_adaptiveMs)
+    {
+        // Tenths of frames per second; wsprintf doesn't support floating point.
+        const UINT rate = (10000 + m_adaptiveMs / 2) / m_adaptiveMs;
+        wsprintfW(base, TEXT("Zoomin \u00b7 %ux \u00b7 %u.%u fps"), m_factor, rate / 10, rate % 10);
+    }
+    else
+    {
+        wsprintfW(base, TEXT("Zoomin \u00b7 %ux"), m_factor);
+    }
+    std::wstring title(base);
 
-void Zoomin::SetZoomPoint(LPARAM lParam)
-{
-    POINT pt;
+    if (m_show_diff)
+    {
+        WCHAR diff[80];
+        if (!m_diff_valid)
+            wcscpy(diff, TEXT(" \u00b7 outside baseline"));
+        else if (!m_diffResult.differing)
+            wcscpy(diff, TEXT(" \u00b7 no differences"));
+        else
+            wsprintfW(diff, TEXT(" \u00b7 %u differ in %d,%d %dx%d"), m_diffResult.differing,
+                      m_diffResult.left, m_diffResult.top,
+                      m_diffResult.right - m_diffResult.left, m_diffResult.bottom - m_diffResult.top);
+        title += diff;
+    }
+
+    if (m_on_match)
+    {
+        WCHAR match[40];
+        wsprintfW(match, TEXT(" \u00b7 match %u of %u"), UINT(m_matchIndex + 1), UINT(m_matches.size()));
+        title += match;
+    }
+
+    if (m_apply_filters && !m_pipeline.IsEmpty())
+        title += TEXT(" \u00b7 filtered");
+
+    // Stripes need a third of a pixel to be a whole number of pixels.
+    if (m_subpixels != SO_NONE)
+    {
+        if (GetScaledFactor() % 3)
+            title += TEXT(" \u00b7 stripes need a multiple of 3x");
+        else
+            title += (m_subpixels == SO_BGR) ? TEXT(" \u00b7 BGR stripes") : TEXT(" \u00b7 RGB stripes");
+    }
+
+    if (m_show_onion && !m_onion.IsEmpty())
+    {
+        WCHAR onion[80];
+        wsprintfW(onion, TEXT(" \u00b7 overlay %d%% at %d,%d"), m_onionOpacity, m_onionPos.x, m_onionPos.y);
+        title += onion;
+    }
+
+    if (m_show_ruler && m_has_ruler)
+    {
+        // Tenths of pixels; wsprintf doesn't support floating point.
+        const LONG dx = abs(m_rulerTo.x - m_rulerFrom.x);
+        const LONG dy = abs(m_rulerTo.y - m_rulerFrom.y);
+        const UINT length = UINT(sqrt(double(dx) * dx + double(dy) * dy) * 10 + 0.5);
+
+        CachedMonitorInfo info;
+        const DpiScaler dpi(GetCachedMonitorInfo(m_rulerFrom, info) ? info.dpi : WORD(96));
+        const UINT unscaled = UINT(dpi.ScaleTo(INT(length), 96));
+        WCHAR ruler[128];
+        wsprintfW(ruler, TEXT(" \u00b7 ruler %d\u00d7%d, %u.%u px (%d\u00d7%d, %u.%u at 96 DPI)"),
+                  dx, dy, length / 10, length % 10,
+                  dpi.ScaleTo(dx, 96), dpi.ScaleTo(dy, 96), unscaled / 10, unscaled % 10);
+        title += ruler;
+    }
+
+    if (m_cadence.IsRunning())
+    {
+        CadenceReport report;
+        m_cadence.GetReport(report);
+        const UINT rate = UINT(report.GetRate() * 10 + 0.5);
+        WCHAR cadence[80];
+        wsprintfW(cadence, TEXT(" \u00b7 analyzing:  %u.%u fps, %u skipped"), rate / 10, rate % 10, report.skipped);
+        title += cadence;
+    }
+    SetWindowText(m_hwnd, title.c_str());
+}
+
+void Zoomin::SetZoomPoint(LPARAM lParam)
+{
+    POINT pt;
     pt.x = SHORT(LOWORD(lParam));
     pt.y = SHORT(HIWORD(lParam));
 
@@ -783,15 +1734,14 @@ void Zoomin::SetZoomPoint(POINT pt)
     if (pt.x == MAXINT || pt.y == MAXINT)
         return;
 
-    MONITORINFO mi = { sizeof(mi) };
-    HMONITOR hmon = MonitorFromPoint(pt, MONITOR_DEFAULTTONEAREST);
-    if (!GetMonitorInfo(hmon, &mi))
+    CachedMonitorInfo info;
+    if (!GetCachedMonitorInfo(pt, info))
     {
         SetRectEmpty(&m_rcMonitor);
         return;
     }
 
-    m_rcMonitor = mi.rcMonitor;
+    m_rcMonitor = info.rcMonitor;
 
     m_pt.x = clamp(pt.x, m_rcMonitor.left, m_rcMonitor.right - 1);
     m_pt.y = clamp(pt.y, m_rcMonitor.top, m_rcMonitor.bottom - 1);
@@ -845,10 +1795,9 @@ void Zoomin::SetRefresh(bool refresh)
 
     m_refresh = refresh;
 
-    if (refresh)
-        SetInterval(m_interval);
-    else
-        KillTimer(m_hwnd, c_refresh_timer_id);
+    UpdateTimer();
+    CheckSuspended();
+    UpdateTitle();
 
     MENUITEMINFO mii = { sizeof(mii) };
     mii.fMask = MIIM_STRING;
@@ -861,8 +1810,86 @@ void Zoomin::SetRefresh(bool refresh)
 void Zoomin::SetInterval(UINT interval)
 {
     m_interval = interval;
+    if (m_timer)
+    {
+        KillTimer(m_hwnd, c_refresh_timer_id);
+        m_timer = false;
+    }
+    UpdateTimer();
+}
+
+void Zoomin::SetAdaptive(bool adaptive, INT min_rate, INT max_rate)
+{
+    m_adaptiveMinRate = clamp<INT>(min_rate, c_min_adaptive_rate, c_max_adaptive_rate);
+    m_adaptiveMaxRate = clamp<INT>(max_rate, m_adaptiveMinRate, c_max_adaptive_rate);
+    m_adaptive = adaptive;
+
+    // Start at the fastest rate; AdaptRefreshRate backs off if nothing changes.
+    m_adaptiveMs = 1000 / m_adaptiveMaxRate;
+    m_frameHash = 0;
+
+    SetInterval(m_interval);
+    UpdateTitle();
+}
+
+void Zoomin::UpdateTimer()
+{
+    // Hiding, minimizing, and locking the session send notifications, so the
+    // timer can stop entirely.  Being covered or cloaked doesn't, so the timer
+    // keeps running to poll for those, but CheckSuspended skips capturing.
+    // Polling them walks the whole z-order, so it has its own slower timer.
+    // Analyzing frame cadence also stops it, so repainting doesn't perturb the
+    // measurement.
+    const bool timer = (m_refresh && !m_locked && !m_cadence.IsRunning() && IsWindowVisible(m_hwnd) && !IsIconic(m_hwnd));
+    if (timer == m_timer)
+        return;
+
+    m_timer = timer;
+    if (timer)
+    {
+        UpdateCovered();
+        SetTimer(m_hwnd, c_refresh_timer_id, m_adaptive ? m_adaptiveMs : std::max<INT>(m_interval, 1) * 100, nullptr);
+        SetTimer(m_hwnd, c_covered_timer_id, c_covered_interval, nullptr);
+    }
+    else
+    {
+        KillTimer(m_hwnd, c_refresh_timer_id);
+        KillTimer(m_hwnd, c_covered_timer_id);
+        m_covered = false;
+    }
+}
+
+void Zoomin::UpdateCovered()
+{
+    m_covered = (IsWindowCloaked(m_hwnd) || IsWindowOccluded(m_hwnd));
+}
+
+bool Zoomin::CheckSuspended()
+{
+    const bool suspend = (m_refresh &&
+                          (m_locked ||
+                           !IsWindowVisible(m_hwnd) ||
+                           IsIconic(m_hwnd) ||
+                           m_covered));
+
+    if (suspend == m_suspended)
+        return suspend;
+
+    m_suspended = suspend;
+
+    if (suspend)
+    {
+        m_suspendStart = GetPerfSeconds();
+        ++m_stats.suspensions;
+        return true;
+    }
+
+    m_stats.suspended_seconds += GetPerfSeconds() - m_suspendStart;
+
+    // Catch up with a single refresh.
     if (m_refresh)
-        SetTimer(m_hwnd, c_refresh_timer_id, std::max<INT>(m_interval, 1) * 100, nullptr);
+        PaintZoomRect();
+    return true;
 }
 
 void Zoomin::SetReticleOpacity(UINT opacity)
@@ -870,30 +1897,70 @@ void Zoomin::SetReticleOpacity(UINT opacity)
     m_reticleOpacity = clamp<INT>(opacity, 10, 100);
 }
 
+void Zoomin::AdaptRefreshRate()
+{
+    RECT rc;
+    PixelSource src;
+    if (!GetZoomArea(rc) || !GetZoomSource(rc, src))
+        return;
+
+    // A hash of the zoom area is a cheap signal for whether anything changed.
+    const uint64_t hash = HashPixels(src);
+    const bool changed = (hash != m_frameHash);
+    m_frameHash = hash;
+
+    // Jump to the fastest rate as soon as anything changes, and back off
+    // exponentially toward the slowest rate while nothing changes.
+    const UINT fastest = 1000 / m_adaptiveMaxRate;
+    const UINT slowest = 1000 / m_adaptiveMinRate;
+    const UINT ms = changed ? fastest : std::min<UINT>(slowest, m_adaptiveMs * 3 / 2 + 1);
+    if (ms == m_adaptiveMs)
+        return;
+
+    m_adaptiveMs = ms;
+    if (m_timer)
+        SetTimer(m_hwnd, c_refresh_timer_id, m_adaptiveMs, nullptr);
+    UpdateTitle();
+}
+
 void Zoomin::CalcZoomArea()
 {
     RECT rc;
-    GetClientRect(m_hwnd, &rc);
-    const INT factor = std::max<INT>(0, m_dpi.Scale(m_factor));
+    GetZoomClientRect(rc);
+    const INT factor = GetScaledFactor();
     m_area.cx = ((rc.right - rc.left) + factor - 1) / factor;
     m_area.cy = ((rc.bottom - rc.top) + factor - 1) / factor;
     UpdateTitle();
 }
 
+// The part of the client area that shows the zoom area, above the timeline
+// pane and the status bar.
+void Zoomin::GetZoomClientRect(RECT& rc) const
+{
+    GetClientRect(m_hwnd, &rc);
+    if (m_statusbar && m_show_inspector)
+    {
+        RECT rcStatus;
+        GetWindowRect(m_statusbar, &rcStatus);
+        rc.bottom = std::max<LONG>(rc.top, rc.bottom - (rcStatus.bottom - rcStatus.top));
+    }
+    rc.bottom = std::max<LONG>(rc.top, rc.bottom - m_timeline.GetHeight());
+}
+
+// Target pixels per source pixel.
+INT Zoomin::GetScaledFactor() const
+{
+    return std::max<INT>(1, m_dpi.Scale(m_factor));
+}
+
 bool Zoomin::GetZoomArea(RECT& rc, POINT* pt)
 {
     if (m_pt.x == MAXINT || m_pt.y == MAXINT)
         return false;
 
-    const LONG xx = clamp(m_pt.x, m_rcMonitor.left + m_area.cx / 2, m_rcMonitor.right - (m_area.cx - m_area.cx / 2));
-    const LONG yy = clamp(m_pt.y, m_rcMonitor.top + m_area.cy / 2, m_rcMonitor.bottom - (m_area.cy - m_area.cy / 2));
-
-    rc.left = xx - m_area.cx / 2;
-    rc.top = yy - m_area.cy / 2;
-    rc.right = rc.left + m_area.cx;
-    rc.bottom = rc.top + m_area.cy;
-
     // GetZoomArea adjusts the rect to be fully on a single monitor.
+    const bool ok = ClampZoomArea(m_pt, m_area, m_rcMonitor, rc);
+
     // Update the point so the reticle position matches the zoom area.
     if (pt)
     {
@@ -901,10 +1968,523 @@ bool Zoomin::GetZoomArea(RECT& rc, POINT* pt)
         pt->y = rc.top + (rc.bottom - rc.top) / 2;
     }
 
-    return (rc.right > rc.left && rc.bottom > rc.top);
+    return ok;
+}
+
+bool Zoomin::EnsureCapture(const RECT& rc, bool recapture)
+{
+    if (!recapture && m_capture.Contains(rc))
+        return true;
+
+    // Over-capture so the area needed at half the current zoom factor (or a
+    // somewhat larger window) is already retained.  That way dragging the zoom
+    // factor scrollbar or resizing the window rarely needs to recapture.
+    const LONG cxMargin = std::max<LONG>((rc.right - rc.left) / 2, c_capture_slack);
+    const LONG cyMargin = std::max<LONG>((rc.bottom - rc.top) / 2, c_capture_slack);
+    return m_capture.Capture(rc, m_rcMonitor, cxMargin, cyMargin);
+}
+
+bool Zoomin::GetZoomSource(const RECT& rc, PixelSource& src) const
+{
+    if (!m_capture.Contains(rc))
+        return false;
+
+    const RECT& rcFrom = m_capture.GetRect();
+    src.stride = m_capture.GetStride();
+    src.bits = reinterpret_cast<const uint32_t*>(m_capture.GetBits()) + (rc.top - rcFrom.top) * src.stride + (rc.left - rcFrom.left);
+    src.cx = rc.right - rc.left;
+    src.cy = rc.bottom - rc.top;
+    return true;
+}
+
+// Freezes the retained capture (which extends past the zoom area) as the
+// baseline for diff mode.
+void Zoomin::SetBaseline()
+{
+    PaintZoomRect();
+
+    RECT rc;
+    if (!GetZoomArea(rc) || !m_capture.Contains(rc))
+    {
+        MessageBeep(0xffffffff);
+        return;
+    }
+
+    m_rcBaseline = m_capture.GetRect();
+    const LONG cx = m_rcBaseline.right - m_rcBaseline.left;
+    const LONG cy = m_rcBaseline.bottom - m_rcBaseline.top;
+    const uint32_t* const bits = reinterpret_cast<const uint32_t*>(m_capture.GetBits());
+    const LONG stride = m_capture.GetStride();
+    m_baseline.resize(size_t(cx) * cy);
+    for (LONG yy = 0; yy < cy; ++yy)
+        memcpy(&m_baseline[size_t(yy) * cx], bits + yy * stride, cx * sizeof(uint32_t));
+
+    ShowDifferences(true);
+}
+
+void Zoomin::ShowDifferences(bool show)
+{
+    if (show && m_baseline.empty())
+    {
+        // SetBaseline shows differences when it's done.
+        SetBaseline();
+        return;
+    }
+
+    // The difference is against the source, not the flicker overlay.
+    if (show && m_show_flicker)
+        ShowFlicker(false);
+
+    m_show_diff = show;
+    m_diff_valid = false;
+    m_diffResult = DiffResult();
+    UpdateTitle();
+    PaintZoomRect(NULL, false);
+}
+
+// Tints pixels by how often they've changed between recent captures.  That
+// needs captures to compare, so it turns on auto-refresh.
+void Zoomin::ShowFlicker(bool show)
+{
+    if (show && m_show_diff)
+        ShowDifferences(false);
+
+    m_show_flicker = show;
+    m_flicker.Reset();
+    if (show)
+        SetRefresh(true);
+    PaintZoomRect(NULL, false);
+}
+
+// Measures how often the zoom area's content changes, on a separate thread.
+// Stopping shows the report.
+void Zoomin::AnalyzeCadence(bool analyze)
+{
+    if (analyze)
+    {
+        RECT rc;
+        if (!GetZoomArea(rc) || !m_cadence.Start(rc))
+        {
+            MessageBeep(0xffffffff);
+            return;
+        }
+        SetTimer(m_hwnd, c_cadence_timer_id, c_cadence_title_interval, nullptr);
+    }
+    else
+    {
+        m_cadence.Stop();
+        KillTimer(m_hwnd, c_cadence_timer_id);
+    }
+
+    UpdateTimer();
+    UpdateTitle();
+
+    if (!analyze)
+        ShowCadenceReport();
+}
+
+void Zoomin::ShowCadenceReport()
+{
+    CadenceReport report;
+    m_cadence.GetReport(report);
+
+    // wsprintf doesn't support floating point.
+    WCHAR text[1024];
+    int len = _snwprintf(text, _countof(text) - 1,
+                         L"Display refresh:\t%.2f Hz\n"
+                         L"Captures:\t%u\n"
+                         L"\n"
+                         L"Distinct frames:\t%u in %.2f seconds\n"
+                         L"Update rate:\t%.1f fps\n"
+                         L"Frame times:\t%.1f to %.1f ms\n"
+                         L"Usual frame time:\t%u refreshes\n"
+                         L"Duplicated refreshes:\t%u\n"
+                         L"Skipped refreshes:\t%u\n"
+                         L"\n"
+                         L"Frame time histogram:\n",
+                         report.refresh_seconds > 0 ? 1 / report.refresh_seconds : 0.0,
+                         report.captures,
+                         report.frames, report.seconds,
+                         report.GetRate(),
+                         report.min_seconds * 1000, report.max_seconds * 1000,
+                         report.cadence,
+                         report.duplicated,
+                         report.skipped);
+
+    for (int32_t bin = 0; bin < c_cadence_bins && len >= 0; ++bin)
+    {
+        const int added = _snwprintf(text + len, _countof(text) - 1 - len,
+                                     L"%d%s refresh%s:\t%u\n",
+                                     bin + 1, (bin == c_cadence_bins - 1) ? L"+" : L"", bin ? L"es" : L"",
+                                     report.histogram[bin]);
+        len = (added < 0) ? -1 : len + added;
+    }
+    text[_countof(text) - 1] = '\0';
+
+    __MessageBox(m_hwnd, text, TEXT("Zoomin Frame Cadence"), MB_OK);
+}
+
+// Searches every monitor for m_searchTemplate, and goes to the first match after
+// the zoom area in reading order.  E.g. searching for the zoom area itself
+// goes to the next place that looks the same.
+void Zoomin::SearchForTemplate()
+{
+    m_matches.clear();
+    m_matchIndex = 0;
+
+    const HCURSOR hcur = SetCursor(LoadCursor(NULL, IDC_WAIT));
+
+    RECT rcSelf;
+    GetWindowRect(m_hwnd, &rcSelf);
+    const PixelSource needle = m_searchTemplate.GetSource();
+    const uint8_t tolerance = m_search_tolerant ? c_search_tolerance : 0;
+
+    // One monitor at a time, so only one monitor's pixels are held at once.
+    std::vector<CachedMonitorInfo> monitors;
+    std::vector<SearchMatch> found;
+    ScreenCapture capture;
+    GetCachedMonitors(monitors);
+    for (const auto& info : monitors)
+    {
+        if (m_matches.size() >= c_max_search_matches || !capture.Capture(info.rcMonitor, info.rcMonitor, 0, 0))
+            continue;
+
+        PixelSource haystack;
+        haystack.bits = reinterpret_cast<const uint32_t*>(capture.GetBits());
+        haystack.stride = capture.GetStride();
+        haystack.cx = info.rcMonitor.right - info.rcMonitor.left;
+        haystack.cy = info.rcMonitor.bottom - info.rcMonitor.top;
+        FindTemplate(ThreadPool::GetShared(), haystack, needle, tolerance, c_max_search_matches - m_matches.size(), found);
+
+        for (const auto& match : found)
+        {
+            RECT rc;
+            rc.left = info.rcMonitor.left + match.x;
+            rc.top = info.rcMonitor.top + match.y;
+            rc.right = rc.left + needle.cx;
+            rc.bottom = rc.top + needle.cy;
+
+            // At 1x the zoom window itself shows the template.
+            RECT rcOverlap;
+            if (IsWindowVisible(m_hwnd) && IntersectRect(&rcOverlap, &rc, &rcSelf))
+                continue;
+            m_matches.push_back(rc);
+        }
+    }
+    capture.Free();
+
+    std::sort(m_matches.begin(), m_matches.end(), [](const RECT& a, const RECT& b)
+    {
+        return (a.top != b.top) ? a.top < b.top : a.left < b.left;
+    });
+
+    SetCursor(hcur);
+
+    if (m_matches.empty())
+    {
+        MessageBeep(0xffffffff);
+        m_on_match = false;
+        UpdateTitle();
+        return;
+    }
+
+    RECT rc;
+    size_t index = 0;
+    if (GetZoomArea(rc))
+    {
+        while (index < m_matches.size() &&
+               (m_matches[index].top < rc.top || (m_matches[index].top == rc.top && m_matches[index].left <= rc.left)))
+            ++index;
+        if (index >= m_matches.size())
+            index = 0;
+    }
+    GoToMatch(index);
+}
+
+void Zoomin::GoToMatch(size_t index)
+{
+    m_matchIndex = index;
+
+    const RECT& rc = m_matches[index];
+    POINT pt;
+    pt.x = rc.left + (rc.right - rc.left) / 2;
+    pt.y = rc.top + (rc.bottom - rc.top) / 2;
+    SetZoomPoint(pt);
+    UpdateTitle();
+}
+
+void Zoomin::ShowRuler(bool show)
+{
+    if (m_measuring)
+        OnCancelMode();
+
+    m_show_ruler = show;
+    m_has_ruler = false;
+    if (!show)
+        m_edges.Reset();
+
+    UpdateTitle();
+    PaintZoomRect(NULL, false);
+}
+
+// Maps the mouse position to the nearest pixel corner in the zoom area, and
+// snaps it to nearby edges unless Shift is down.
+bool Zoomin::GetRulerCorner(LPARAM lParam, POINT& pt)
+{
+    RECT rc;
+    if (!GetZoomArea(rc))
+        return false;
+
+    const INT factor = GetScaledFactor();
+    const LONG cx = rc.right - rc.left;
+    const LONG cy = rc.bottom - rc.top;
+    const LONG xClient = clamp<LONG>(SHORT(LOWORD(lParam)), 0, cx * factor);
+    const LONG yClient = clamp<LONG>(SHORT(HIWORD(lParam)), 0, cy * factor);
+
+    int32_t x = (xClient + factor / 2) / factor;
+    int32_t y = (yClient + factor / 2) / factor;
+    if (GetKeyState(VK_SHIFT) >= 0 && EnsureEdges(rc))
+    {
+        // Snap within a fixed distance on screen, regardless of zoom factor.
+        const int32_t radius = std::max<int32_t>(1, m_dpi.Scale(c_ruler_snap_distance) / factor);
+        m_edges.Snap(x, y, yClient / factor, xClient / factor, radius);
+    }
+
+    pt.x = rc.left + x;
+    pt.y = rc.top + y;
+    return true;
+}
+
+bool Zoomin::EnsureEdges(const RECT& rc)
+{
+    if (m_edges.IsFor(rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top))
+        return true;
+
+    PixelSource src;
+    if (!EnsureCapture(rc, false) || !GetZoomSource(rc, src))
+        return false;
+
+    m_edges.Build(src, rc.left, rc.top);
+    return true;
+}
+
+void Zoomin::ShowElements(bool show)
+{
+    m_show_elements = show;
+    if (!show)
+        m_elements.Reset();
+    PaintZoomRect(NULL, false);
+}
+
+void Zoomin::LoadOnionSkin()
+{
+    WCHAR path[MAX_PATH] = {};
+    if (!BrowseImageFile(m_hwnd, TEXT("Load Overlay Image"), path, _countof(path)))
+        return;
+
+    if (!m_onion.Load(path))
+    {
+        MessageBeep(0xffffffff);
+        m_onionPixels.clear();
+        UpdateTitle();
+        PaintZoomRect(NULL, false);
+        return;
+    }
+
+    ResetOnionOffset();
+    ShowOnionSkin(true);
+}
+
+void Zoomin::ShowOnionSkin(bool show)
+{
+    if (show && m_onion.IsEmpty())
+    {
+        LoadOnionSkin();
+        return;
+    }
+
+    m_show_onion = show;
+    if (!show)
+        m_onionPixels.clear();
+    UpdateTitle();
+    PaintZoomRect(NULL, false);
+}
+
+void Zoomin::SetOnionOpacity(INT opacity)
+{
+    m_onionOpacity = clamp<INT>(opacity, c_onion_opacity_step, 100);
+    UpdateTitle();
+    PaintZoomRect(NULL, false);
 }
 
-void Zoomin::PaintZoomRect(HDC hdc)
+// Filters are configured in the Options dialog; the menu just toggles them.
+void Zoomin::SetFilters(const FilterStep* steps, bool apply)
+{
+    if (steps != m_filters)
+    {
+        for (size_t ii = 0; ii < c_max_filters; ++ii)
+        {
+            m_filters[ii].kind = steps[ii].kind;
+            m_filters[ii].param = ClampFilterParam(steps[ii].kind, steps[ii].param);
+        }
+    }
+
+    m_pipeline.Compile(m_filters, c_max_filters);
+    m_apply_filters = (apply && !m_pipeline.IsEmpty());
+    if (!m_apply_filters)
+    {
+        m_filteredPixels.clear();
+        m_filteredBaseline.clear();
+    }
+    UpdateTitle();
+    PaintZoomRect(NULL, false);
+}
+
+// Puts the top left of the onion skin at the top left of the zoom area.
+void Zoomin::ResetOnionOffset()
+{
+    RECT rc;
+    if (GetZoomArea(rc))
+    {
+        m_onionPos.x = rc.left;
+        m_onionPos.y = rc.top;
+    }
+    UpdateTitle();
+    PaintZoomRect(NULL, false);
+}
+
+// Draws the element bounds and the ruler over the rendered zoom area.
+void Zoomin::DrawOverlay(HDC hdc, const RECT& rc, INT factor)
+{
+    if (!m_show_elements && !(m_show_ruler && m_has_ruler))
+        return;
+
+    const HDC hdcWindow = hdc ? NULL : GetDC(m_hwnd);
+    if (hdcWindow)
+        hdc = hdcWindow;
+    if (!hdc)
+        return;
+
+    SaveDC(hdc);
+
+    RECT rcClient;
+    GetZoomClientRect(rcClient);
+    IntersectClipRect(hdc, rcClient.left, rcClient.top, rcClient.right, rcClient.bottom);
+
+    if (m_show_elements)
+        DrawElements(hdc, rc, factor);
+    if (m_show_ruler && m_has_ruler)
+        DrawRuler(hdc, rc, factor);
+
+    RestoreDC(hdc, -1);
+    if (hdcWindow)
+        ReleaseDC(m_hwnd, hdcWindow);
+}
+
+// Outlines each element, and labels it with its size where the label fits.
+void Zoomin::DrawElements(HDC hdc, const RECT& rc, INT factor)
+{
+    if (!m_elements.IsFor(rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top))
+        return;
+
+    if (!m_hfontOverlay)
+        m_hfontOverlay = CreateFont(-m_dpi.Scale(c_overlay_font_height), 0, 0, 0, FW_NORMAL, false, false, false, DEFAULT_CHARSET,
+                                    OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, FIXED_PITCH|FF_MODERN, c_label_font);
+
+    const HPEN hpen = CreatePen(PS_SOLID, std::max<INT>(1, m_dpi.Scale(1)), m_crReticle);
+    const HPEN hpenOld = hpen ? SelectPen(hdc, hpen) : NULL;
+    const HBRUSH hbrOld = SelectBrush(hdc, GetStockBrush(HOLLOW_BRUSH));
+    const HFONT hfontOld = m_hfontOverlay ? SelectFont(hdc, m_hfontOverlay) : NULL;
+    SetBkMode(hdc, OPAQUE);
+    SetBkColor(hdc, m_crReticle);
+    SetTextColor(hdc, m_crReticleBorder);
+
+    for (const ElementRect& element : m_elements.GetElements())
+    {
+        const RECT rcElement =
+        {
+            element.left * factor, element.top * factor,
+            element.right * factor, element.bottom * factor
+        };
+        Rectangle(hdc, rcElement.left, rcElement.top, rcElement.right, rcElement.bottom);
+
+        WCHAR text[32];
+        const int len = wsprintfW(text, TEXT("%d\u00d7%d"), element.right - element.left, element.bottom - element.top);
+        SIZE size;
+        if (GetTextExtentPoint32(hdc, text, len, &size) &&
+            size.cx + 2 <= rcElement.right - rcElement.left &&
+            size.cy + 2 <= rcElement.bottom - rcElement.top)
+            TextOut(hdc, rcElement.left + 1, rcElement.top + 1, text, len);
+    }
+
+    if (hfontOld)
+        SelectFont(hdc, hfontOld);
+    SelectBrush(hdc, hbrOld);
+    if (hpenOld)
+        SelectPen(hdc, hpenOld);
+    if (hpen)
+        DeleteObject(hpen);
+}
+
+// Draws the ruler, with ticks across its ends.
+void Zoomin::DrawRuler(HDC hdc, const RECT& rc, INT factor)
+{
+    const POINT from = { (m_rulerFrom.x - rc.left) * factor, (m_rulerFrom.y - rc.top) * factor };
+    const POINT to = { (m_rulerTo.x - rc.left) * factor, (m_rulerTo.y - rc.top) * factor };
+
+    // Ticks are perpendicular to the ruler (or horizontal, before it has any
+    // length).
+    const double dx = to.x - from.x;
+    const double dy = to.y - from.y;
+    const double length = sqrt(dx * dx + dy * dy);
+    const double tick = m_dpi.Scale(6);
+    POINT offset = { LONG(tick), 0 };
+    if (length > 0)
+    {
+        offset.x = LONG(-dy * tick / length);
+        offset.y = LONG(dx * tick / length);
+    }
+
+    // The outline keeps the ruler visible over any colors.
+    const INT width = std::max<INT>(1, m_dpi.Scale(1));
+    const HPEN hpenBorder = CreatePen(PS_SOLID, width * 3, m_crReticleBorder);
+    const HPEN hpen = CreatePen(PS_SOLID, width, m_crReticle);
+    const HPEN hpenOld = SelectPen(hdc, GetStockPen(NULL_PEN));
+    for (const HPEN pen : { hpenBorder, hpen })
+    {
+        if (!pen)
+            continue;
+        SelectPen(hdc, pen);
+        MoveToEx(hdc, from.x, from.y, nullptr);
+        LineTo(hdc, to.x, to.y);
+        for (const POINT& end : { from, to })
+        {
+            MoveToEx(hdc, end.x - offset.x, end.y - offset.y, nullptr);
+            LineTo(hdc, end.x + offset.x, end.y + offset.y);
+        }
+    }
+
+    SelectPen(hdc, hpenOld);
+    if (hpenBorder)
+        DeleteObject(hpenBorder);
+    if (hpen)
+        DeleteObject(hpen);
+}
+
+bool Zoomin::GetBaselineSource(const RECT& rc, PixelSource& src) const
+{
+    RECT rcInside;
+    if (m_baseline.empty() || !IntersectRect(&rcInside, &rc, &m_rcBaseline) || !EqualRect(&rcInside, &rc))
+        return false;
+
+    src.stride = m_rcBaseline.right - m_rcBaseline.left;
+    src.bits = m_baseline.data() + (rc.top - m_rcBaseline.top) * src.stride + (rc.left - m_rcBaseline.left);
+    src.cx = rc.right - rc.left;
+    src.cy = rc.bottom - rc.top;
+    return true;
+}
+
+void Zoomin::PaintZoomRect(HDC hdc, bool recapture)
 {
     RECT rc;
     if (!GetZoomArea(rc))
@@ -913,63 +2493,337 @@ void Zoomin::PaintZoomRect(HDC hdc)
     assert(rc.right > rc.left);
     assert(rc.bottom > rc.top);
 
+    const double start = GetPerfSeconds();
+    const bool captured = (recapture || !m_capture.Contains(rc));
+    if (!EnsureCapture(rc, recapture))
+        return;
+
+    const double rendered = GetPerfSeconds();
+    if (captured)
+    {
+        ++m_stats.captures;
+        m_stats.capture_seconds += rendered - start;
+    }
+
+    const RenderTarget target = GetRenderTarget(hdc);
+    if (target.cx <= 0 || target.cy <= 0 || !m_renderer)
+        return;
+
+    const INT factor = GetScaledFactor();
+
+    PixelSource src;
+    if (!GetZoomSource(rc, src))
+        return;
+
+    // Find the edges and elements once per captured frame.
+    if (m_show_ruler && (captured || !m_edges.IsFor(rc.left, rc.top, src.cx, src.cy)))
+        m_edges.Build(src, rc.left, rc.top);
+    if (m_show_elements && (captured || !m_elements.IsFor(rc.left, rc.top, src.cx, src.cy)))
+        m_elements.Find(src, rc.left, rc.top);
+
+    // Filters apply to the captured pixels; everything else sees the original
+    // pixels and is drawn over the filtered ones.
+    const bool filtered = (m_apply_filters && !m_pipeline.IsEmpty());
+    PixelSource shown = src;
+    if (filtered)
+        m_pipeline.Apply(src, m_filteredPixels, shown);
+
+    // Only new captures count toward flicker; repaints just show the overlay.
+    if (m_show_flicker)
+    {
+        if (captured)
+            m_flicker.Update(src, rc.left, rc.top);
+        PixelSource overlay;
+        if (m_flicker.GetOverlay(shown, rc.left, rc.top, overlay))
+            shown = overlay;
+    }
+
+    // The onion skin is blended over whatever else is shown.
+    if (m_show_onion && !m_onion.IsEmpty())
+    {
+        PixelSource blended;
+        BlendOnionSkin(shown, m_onion.GetSource(), m_onionPos.x - rc.left, m_onionPos.y - rc.top,
+                       uint8_t(m_onionOpacity * 255 / 100), m_onion.HasAlpha(), m_onionPixels, blended);
+        shown = blended;
+    }
+
+    // DIB pixels are 0x00RRGGBB, but COLORREF is 0x00BBGGRR.
+    ScaleParams params;
+    params.factor = factor;
+    params.gridline_color = RGB(GetBValue(m_crGridlines), GetGValue(m_crGridlines), GetRValue(m_crGridlines));
+    params.subpixels = m_subpixels;
+
+    SetGridlines(params, m_show_gridlines[0] ? m_gridline_spacing[0] : 0, m_show_gridlines[1] ? m_gridline_spacing[1] : 0);
+
+    // Show differences from the baseline where it covers the zoom area.
+    DiffParams diff;
+    DiffResult diffResult;
+    const bool diffValid = (m_show_diff && GetBaselineSource(rc, diff.baseline));
+    if (diffValid)
+    {
+        // Compare like with like.
+        if (filtered)
+            m_pipeline.Apply(diff.baseline, m_filteredBaseline, diff.baseline);
+        diff.style = m_diff_heatmap ? DS_HEATMAP : DS_HIGHLIGHT;
+        diff.result = &diffResult;
+        params.diff = &diff;
+    }
+
+    // Label each magnified pixel with its value at high zoom factors.
+    PixelLabels* labels = nullptr;
+    if (m_show_labels && m_factor >= c_min_label_zoom)
+    {
+        const LabelFormat format = m_labels_hex ? LF_HEX : LF_DECIMAL;
+        const int32_t room = factor - 2 * c_label_margin;
+        const GlyphAtlas* atlas = GetGlyphAtlas(c_label_font, WORD(m_dpi.Scale(96)), room / GetLabelColumns(format), room / 3);
+        // The labels show the captured values, but contrast with the shown
+        // pixels; in diff mode the renderer re-picks the contrast from the
+        // difference image it computes anyway.
+        m_stats.labels_updated += m_labels.Update(src, shown, factor, target.cx, target.cy, format, atlas);
+        if (m_labels.IsVisible())
+            labels = &m_labels;
+    }
+    else
+    {
+        m_labels.Clear();
+    }
+
+    // If the chosen renderer can't render (e.g. Direct2D is unavailable), fall
+    // back to GDI for the rest of the session.
+    const double drawing = GetPerfSeconds();
+    if (!m_renderer->Render(target, shown, params, labels))
+    {
+        if (m_renderer->GetKind() == RK_GDI)
+            return;
+        m_renderer = CreateRenderer(RK_GDI);
+        if (!m_renderer->Render(target, shown, params, labels))
+            return;
+    }
+
+    const RendererKind kind = m_renderer->GetKind();
+    ++m_stats.renderer_frames[kind];
+    m_stats.renderer_seconds[kind] += GetPerfSeconds() - drawing;
+
+    DrawOverlay(hdc, rc, factor);
+
+    ++m_stats.frames;
+    m_stats.render_seconds += GetPerfSeconds() - rendered;
+
+    // The pixel under the mouse may have changed.
+    UpdateInspector();
+
+    // Report the bounding box in screen coordinates.
+    if (diffValid && diffResult.differing)
+    {
+        diffResult.left += rc.left;
+        diffResult.right += rc.left;
+        diffResult.top += rc.top;
+        diffResult.bottom += rc.top;
+    }
+    if (m_show_diff && (diffValid != m_diff_valid || memcmp(&diffResult, &m_diffResult, sizeof(diffResult))))
+    {
+        m_diff_valid = diffValid;
+        m_diffResult = diffResult;
+        UpdateTitle();
+    }
+
+    // The title shows the match number while the zoom area contains the match.
+    RECT rcMatch;
+    const bool onMatch = (!m_matches.empty() &&
+                          IntersectRect(&rcMatch, &rc, &m_matches[m_matchIndex]) &&
+                          EqualRect(&rcMatch, &m_matches[m_matchIndex]));
+    if (onMatch != m_on_match)
+    {
+        m_on_match = onMatch;
+        UpdateTitle();
+    }
+
+    // The panel copies the pixels and computes the statistics on its worker.
+    if (m_statsPanel.IsShown())
+        m_statsPanel.Submit(src);
+}
+
+static_assert(IDM_RENDERER_DIRECT2D - IDM_RENDERER_GDI == RK_DIRECT2D &&
+              IDM_RENDERER_SOFTWARE - IDM_RENDERER_GDI == RK_SOFTWARE, "renderer menu ids must match RendererKind");
+static_assert(IDM_SUBPIXELS_RGB - IDM_SUBPIXELS_OFF == SO_RGB &&
+              IDM_SUBPIXELS_BGR - IDM_SUBPIXELS_OFF == SO_BGR, "subpixel menu ids must match SubpixelOrder");
+
+void Zoomin::SetRenderer(RendererKind kind)
+{
+    m_rendererKind = kind;
+    if (!m_renderer || m_renderer->GetKind() != kind)
+        m_renderer = CreateRenderer(kind);
+}
+
+RenderTarget Zoomin::GetRenderTarget(HDC hdc) const
+{
     RECT rcClient;
-    GetClientRect(m_hwnd, &rcClient);
+    GetZoomClientRect(rcClient);
+
+    RenderTarget target;
+    target.hwnd = m_hwnd;
+    target.hdc = hdc;
+    target.hpal = m_hpal;
+    target.cx = rcClient.right - rcClient.left;
+    target.cy = rcClient.bottom - rcClient.top;
+    return target;
+}
 
-    const HDC hdcTo = hdc ? hdc : GetDC(m_hwnd);
-    const HDC hdcFrom = GetDC(NULL);
-    const int bltmode = SetStretchBltMode(hdcTo, COLORONCOLOR);
+void Zoomin::ShowInspector(bool show)
+{
+    m_show_inspector = show;
+    if (!m_statusbar)
+        return;
 
-    HPALETTE hpal;
-    if (m_hpal)
+    ShowWindow(m_statusbar, show ? SW_SHOWNA : SW_HIDE);
+    LayoutStatusBar();
+    LayoutTimeline();
+    CalcZoomArea();
+    m_readout = InspectorReadout();
+    for (int part = 0; part < IP_COUNT; ++part)
+        SendMessage(m_statusbar, SB_SETTEXT, part, LPARAM(L""));
+    UpdateInspector();
+    InvalidateRect(m_hwnd, nullptr, false);
+}
+
+void Zoomin::LayoutStatusBar()
+{
+    if (!m_statusbar || !m_show_inspector)
+        return;
+
+    // Let the status bar position itself, then split it into parts.
+    static const int c_part_widths[IP_COUNT - 1] = { 100, 130, 70, 120 };
+    SendMessage(m_statusbar, WM_SIZE, 0, 0);
+    int edges[IP_COUNT];
+    int right = 0;
+    for (int part = 0; part < IP_COUNT - 1; ++part)
     {
-        hpal = SelectPalette(hdcTo, m_hpal, false);
-        RealizePalette(hdcTo);
+        right += m_dpi.Scale(c_part_widths[part]);
+        edges[part] = right;
     }
+    edges[IP_COUNT - 1] = -1;
+    SendMessage(m_statusbar, SB_SETPARTS, IP_COUNT, LPARAM(edges));
+}
 
-    const INT factor = std::max<INT>(1, m_dpi.Scale(m_factor));
+// Shows the source position and color of the pixel under the mouse.  This reads
+// the retained capture rather than the screen, and maps client coordinates to
+// source coordinates the same way the scaler does, so it's cheap enough for
+// every mouse move.
+void Zoomin::UpdateInspector()
+{
+    if (!m_statusbar || !m_show_inspector)
+        return;
 
-    StretchBlt(hdcTo, 0, 0, factor * m_area.cx, factor * m_area.cy,
-               hdcFrom, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, SRCCOPY);
+    InspectorReadout readout = {};
 
-    static_assert(_countof(m_show_gridlines) == _countof(m_gridline_spacing), "array size mismatch");
-    for (size_t ii = 0; ii < _countof(m_show_gridlines); ++ii)
+    RECT rcClient;
+    RECT rc;
+    GetZoomClientRect(rcClient);
+    if (m_ptInspect.x >= 0 && m_ptInspect.y >= 0 && PtInRect(&rcClient, m_ptInspect) && GetZoomArea(rc))
     {
-        const int thick = !ii ? 0 : (m_show_gridlines[0] ? 2 : 0);
-        if (m_show_gridlines[ii] && factor > (thick ? 2 : 1))
+        const INT factor = GetScaledFactor();
+        POINT pt;
+        pt.x = rc.left + m_ptInspect.x / factor;
+        pt.y = rc.top + m_ptInspect.y / factor;
+
+        const RECT rcPixel = { pt.x, pt.y, pt.x + 1, pt.y + 1 };
+        PixelSource src;
+        CachedMonitorInfo info;
+        if (pt.x < rc.right && pt.y < rc.bottom && GetZoomSource(rcPixel, src) && GetCachedMonitorInfo(pt, info))
         {
-            const HPEN hpenLine = CreatePen(PS_SOLID, thick, m_crGridlines);
-            const HPEN hpenOld = SelectPen(hdcTo, hpenLine);
-            for (LONG xx = rcClient.left; xx <= rcClient.right; xx += factor * m_gridline_spacing[ii])
-            {
-                MoveToEx(hdcTo, xx, rcClient.top, nullptr);
-                LineTo(hdcTo, xx, rcClient.bottom);
-            }
-            for (LONG yy = rcClient.top; yy <= rcClient.bottom; yy += factor * m_gridline_spacing[ii])
-            {
-                MoveToEx(hdcTo, rcClient.left, yy, nullptr);
-                LineTo(hdcTo, rcClient.right, yy);
-            }
-            SelectPen(hdcTo, hpenOld);
-            DeleteObject(hpenLine);
+            const DpiScaler dpi(info.dpi);
+            InspectorSample sample;
+            sample.x = pt.x;
+            sample.y = pt.y;
+            sample.unscaled_x = dpi.ScaleTo(pt.x - info.rcMonitor.left, 96);
+            sample.unscaled_y = dpi.ScaleTo(pt.y - info.rcMonitor.top, 96);
+            sample.value = src.bits[0] & 0x00ffffff;
+            FormatInspectorReadout(sample, readout);
         }
     }
 
-    if (m_hpal)
+    // Only update the parts whose text changed.
+    for (int part = 0; part < IP_COUNT; ++part)
     {
-        SelectPalette(hdcTo, hpal, false);
+        if (wcscmp(readout.text[part], m_readout.text[part]))
+            SendMessage(m_statusbar, SB_SETTEXT, part, LPARAM(readout.text[part]));
     }
+    m_readout = readout;
+}
 
-    SetStretchBltMode(hdcTo, bltmode);
-    ReleaseDC(NULL, hdcFrom);
-    if (!hdc)
-        ReleaseDC(m_hwnd, hdcTo);
+void Zoomin::ShowRegionStats(bool show)
+{
+    if (show && !m_statsPanel.Create(g_hinst, m_hwnd))
+    {
+        MessageBeep(0xffffffff);
+        return;
+    }
+
+    m_statsPanel.Show(show);
+    if (show)
+        PaintZoomRect(NULL, false);
+}
+
+void Zoomin::ShowTimeline(bool show)
+{
+    if (show && !m_timeline.Create(g_hinst, m_hwnd))
+    {
+        MessageBeep(0xffffffff);
+        return;
+    }
+
+    m_timeline.Show(show);
+    LayoutTimeline();
+    CalcZoomArea();
+    InvalidateRect(m_hwnd, nullptr, false);
+}
+
+// Puts the timeline pane between the zoom area and the status bar.
+void Zoomin::LayoutTimeline()
+{
+    if (!m_timeline.IsShown())
+        return;
+
+    RECT rc;
+    GetZoomClientRect(rc);
+    rc.top = rc.bottom;
+    rc.bottom += m_timeline.GetHeight();
+    m_timeline.SetRect(rc);
+}
+
+// Probes the pixel under the mouse, or the center of the zoom area when the
+// mouse isn't over it (e.g. when using the keyboard).
+void Zoomin::AddTimelineProbe()
+{
+    RECT rc;
+    RECT rcClient;
+    if (!GetZoomArea(rc))
+        return;
+    GetZoomClientRect(rcClient);
+
+    POINT pt;
+    if (m_ptInspect.x >= 0 && m_ptInspect.y >= 0 && PtInRect(&rcClient, m_ptInspect))
+    {
+        const INT factor = GetScaledFactor();
+        pt.x = std::min<LONG>(rc.left + m_ptInspect.x / factor, rc.right - 1);
+        pt.y = std::min<LONG>(rc.top + m_ptInspect.y / factor, rc.bottom - 1);
+    }
+    else
+    {
+        pt.x = rc.left + (rc.right - rc.left) / 2;
+        pt.y = rc.top + (rc.bottom - rc.top) / 2;
+    }
+
+    if (!m_timeline.IsShown())
+        ShowTimeline(true);
+    if (!m_timeline.IsShown() || !m_timeline.AddProbe(pt))
+        MessageBeep(0xffffffff);
 }
 
 void Zoomin::CopyZoomContent()
 {
     RECT rc;
-    GetClientRect(m_hwnd, &rc);
+    GetZoomClientRect(rc);
 
     HDC hdcFrom = GetDC(m_hwnd);
     HDC hdcTo = hdcFrom ? CreateCompatibleDC(hdcFrom) : NULL;
@@ -1005,6 +2859,53 @@ void Zoomin::CopyZoomContent()
         ReleaseDC(m_hwnd, hdcFrom);
 }
 
+void Zoomin::ShowStatistics()
+{
+    double suspended = m_stats.suspended_seconds;
+    if (m_suspended)
+        suspended += GetPerfSeconds() - m_suspendStart;
+
+    // wsprintf doesn't support floating point.
+    WCHAR text[1024];
+    int len = _snwprintf(text, _countof(text) - 1,
+                         L"Captures:\t%lu\n"
+                         L"Average capture time:\t%.2f ms\n"
+                         L"\n"
+                         L"Frames rendered:\t%lu\n"
+                         L"Average render time:\t%.2f ms\n"
+                         L"Pixel labels updated:\t%lu\n"
+                         L"\n"
+                         L"Refresh suspensions:\t%lu%s\n"
+                         L"Time suspended:\t%.1f seconds\n"
+                         L"\n"
+                         L"Renderer:\t%s\n",
+                         m_stats.captures,
+                         m_stats.captures ? m_stats.capture_seconds * 1000 / m_stats.captures : 0.0,
+                         m_stats.frames,
+                         m_stats.frames ? m_stats.render_seconds * 1000 / m_stats.frames : 0.0,
+                         m_stats.labels_updated,
+                         m_stats.suspensions,
+                         m_suspended ? L" (suspended now)" : L"",
+                         suspended,
+                         m_renderer ? m_renderer->GetName() : L"");
+
+    // Average frame time of each renderer used so far.
+    for (int kind = 0; kind < RK_COUNT && len >= 0; ++kind)
+    {
+        const ULONG frames = m_stats.renderer_frames[kind];
+        if (!frames)
+            continue;
+        const int added = _snwprintf(text + len, _countof(text) - 1 - len,
+                                     L"%s:\t%lu frames, %.2f ms average\n",
+                                     GetRendererName(RendererKind(kind)), frames,
+                                     m_stats.renderer_seconds[kind] * 1000 / frames);
+        len = (added < 0) ? -1 : len + added;
+    }
+    text[_countof(text) - 1] = '\0';
+
+    __MessageBox(m_hwnd, text, TEXT("Zoomin Statistics"), MB_OK);
+}
+
 void Zoomin::RelayEvent(UINT msg, WPARAM wParam, LPARAM lParam)
 {
     if (m_tooltips)
@@ -1032,6 +2933,19 @@ static void CenterDialog(HWND hwnd)
     MoveWindow(hwnd, xx, yy, rc.right - rc.left, rc.bottom - rc.top, false);
 }
 
+// Shows a filter's parameter, or disables the parameter if it has none.
+static void UpdateFilterParam(HWND hwnd, size_t index, int32_t param)
+{
+    const HWND hwndParam = GetDlgItem(hwnd, INT(IDC_FILTER_PARAM1 + index));
+    const INT sel = ComboBox_GetCurSel(GetDlgItem(hwnd, INT(IDC_FILTER_KIND1 + index)));
+    const bool has_param = (sel > FK_NONE && sel < FK_COUNT && FilterHasParam(FilterKind(sel)));
+    if (has_param)
+        SetDlgItemInt(hwnd, INT(IDC_FILTER_PARAM1 + index), param, false);
+    else
+        SetWindowText(hwndParam, TEXT(""));
+    EnableWindow(hwndParam, has_param);
+}
+
 INT_PTR CALLBACK Zoomin::OptionsDlgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
     static COLORREF s_crGridlines;
@@ -1042,18 +2956,35 @@ INT_PTR CALLBACK Zoomin::OptionsDlgProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
     {
     case WM_INITDIALOG:
         CheckDlgButton(hwnd, IDC_ENABLE_REFRESH, s_zoomin.m_refresh ? BST_CHECKED : BST_UNCHECKED);
+        CheckDlgButton(hwnd, IDC_ENABLE_ADAPTIVE, s_zoomin.m_adaptive ? BST_CHECKED : BST_UNCHECKED);
         CheckDlgButton(hwnd, IDC_ENABLE_MINORLINES, s_zoomin.m_show_gridlines[0] ? BST_CHECKED : BST_UNCHECKED);
         CheckDlgButton(hwnd, IDC_ENABLE_MAJORLINES, s_zoomin.m_show_gridlines[1] ? BST_CHECKED : BST_UNCHECKED);
         SendDlgItemMessage(hwnd, IDC_REFRESH_INTERVAL, EM_LIMITTEXT, 3, 0);
+        SendDlgItemMessage(hwnd, IDC_ADAPTIVE_MIN_RATE, EM_LIMITTEXT, 2, 0);
+        SendDlgItemMessage(hwnd, IDC_ADAPTIVE_MAX_RATE, EM_LIMITTEXT, 2, 0);
         SendDlgItemMessage(hwnd, IDC_MINOR_RESOLUTION, EM_LIMITTEXT, 4, 0);
         SendDlgItemMessage(hwnd, IDC_MAJOR_RESOLUTION, EM_LIMITTEXT, 4, 0);
         SetDlgItemInt(hwnd, IDC_REFRESH_INTERVAL, s_zoomin.m_interval, false);
+        SetDlgItemInt(hwnd, IDC_ADAPTIVE_MIN_RATE, s_zoomin.m_adaptiveMinRate, false);
+        SetDlgItemInt(hwnd, IDC_ADAPTIVE_MAX_RATE, s_zoomin.m_adaptiveMaxRate, false);
         SetDlgItemInt(hwnd, IDC_MINOR_RESOLUTION, s_zoomin.m_gridline_spacing[0], false);
         SetDlgItemInt(hwnd, IDC_MAJOR_RESOLUTION, s_zoomin.m_gridline_spacing[1], false);
         s_crGridlines = s_zoomin.m_crGridlines;
         s_crReticle = s_zoomin.m_crReticle;
         s_crReticleBorder = s_zoomin.m_crReticleBorder;
         SetDlgItemInt(hwnd, IDC_RETICLE_OPACITY, s_zoomin.m_reticleOpacity, false);
+        CheckDlgButton(hwnd, IDC_RESIDENT, s_zoomin.m_residentSetting ? BST_CHECKED : BST_UNCHECKED);
+        SendDlgItemMessage(hwnd, IDC_HOTKEY, HKM_SETRULES, HKCOMB_NONE|HKCOMB_S, MAKELPARAM(HOTKEYF_CONTROL|HOTKEYF_ALT, 0));
+        SendDlgItemMessage(hwnd, IDC_HOTKEY, HKM_SETHOTKEY, s_zoomin.m_hotkey, 0);
+        for (size_t ii = 0; ii < c_max_filters; ++ii)
+        {
+            const HWND hwndKind = GetDlgItem(hwnd, INT(IDC_FILTER_KIND1 + ii));
+            for (const WCHAR* text : c_filter_kind_text)
+                ComboBox_AddString(hwndKind, text);
+            ComboBox_SetCurSel(hwndKind, s_zoomin.m_filters[ii].kind);
+            SendDlgItemMessage(hwnd, INT(IDC_FILTER_PARAM1 + ii), EM_LIMITTEXT, 4, 0);
+            UpdateFilterParam(hwnd, ii, s_zoomin.m_filters[ii].param);
+        }
         CenterDialog(hwnd);
         return true;
 
@@ -1126,8 +3057,24 @@ INT_PTR CALLBACK Zoomin::OptionsDlgProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
             }
             break;
 
+        case IDC_FILTER_KIND1:
+        case IDC_FILTER_KIND2:
+        case IDC_FILTER_KIND3:
+        case IDC_FILTER_KIND4:
+        case IDC_FILTER_KIND5:
+            if (HIWORD(wParam) == CBN_SELCHANGE)
+            {
+                const size_t index = LOWORD(wParam) - IDC_FILTER_KIND1;
+                const FilterKind kind = FilterKind(ComboBox_GetCurSel(HWND(lParam)));
+                UpdateFilterParam(hwnd, index, GetDefaultFilterParam(kind));
+            }
+            break;
+
         case IDOK:
             s_zoomin.SetInterval(GetDlgItemInt(hwnd, IDC_REFRESH_INTERVAL, nullptr, false));
+            s_zoomin.SetAdaptive(!!IsDlgButtonChecked(hwnd, IDC_ENABLE_ADAPTIVE),
+                                 GetDlgItemInt(hwnd, IDC_ADAPTIVE_MIN_RATE, nullptr, false),
+                                 GetDlgItemInt(hwnd, IDC_ADAPTIVE_MAX_RATE, nullptr, false));
             s_zoomin.m_gridline_spacing[0] = GetDlgItemInt(hwnd, IDC_MINOR_RESOLUTION, nullptr, false);
             s_zoomin.m_gridline_spacing[1] = GetDlgItemInt(hwnd, IDC_MAJOR_RESOLUTION, nullptr, false);
             s_zoomin.SetRefresh(!!IsDlgButtonChecked(hwnd, IDC_ENABLE_REFRESH));
@@ -1141,6 +3088,28 @@ INT_PTR CALLBACK Zoomin::OptionsDlgProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
             s_zoomin.m_crReticle = s_crReticle;
             s_zoomin.m_crReticleBorder = s_crReticleBorder;
             s_zoomin.SetReticleOpacity(GetDlgItemInt(hwnd, IDC_RETICLE_OPACITY, nullptr, false));
+            {
+                // The checkbox is the saved preference; leaving it alone keeps
+                // the current mode, which --resident may have forced.
+                const bool resident = !!IsDlgButtonChecked(hwnd, IDC_RESIDENT);
+                const bool changed = (resident != s_zoomin.m_residentSetting);
+                s_zoomin.m_residentSetting = resident;
+                s_zoomin.SetResident(changed ? resident : s_zoomin.m_resident,
+                                     LOWORD(SendDlgItemMessage(hwnd, IDC_HOTKEY, HKM_GETHOTKEY, 0, 0)));
+            }
+            {
+                // Changing the filters turns them on, so the change is seen.
+                FilterStep filters[c_max_filters];
+                bool changed = false;
+                for (size_t ii = 0; ii < c_max_filters; ++ii)
+                {
+                    const INT sel = ComboBox_GetCurSel(GetDlgItem(hwnd, INT(IDC_FILTER_KIND1 + ii)));
+                    filters[ii].kind = FilterKind(clamp<INT>(sel, FK_NONE, FK_COUNT - 1));
+                    filters[ii].param = ClampFilterParam(filters[ii].kind, INT(GetDlgItemInt(hwnd, INT(IDC_FILTER_PARAM1 + ii), nullptr, false)));
+                    changed |= (filters[ii].kind != s_zoomin.m_filters[ii].kind || filters[ii].param != s_zoomin.m_filters[ii].param);
+                }
+                s_zoomin.SetFilters(filters, s_zoomin.m_apply_filters || changed);
+            }
             EndDialog(hwnd, true);
             break;
 
@@ -1200,11 +3169,14 @@ static HWND CreateMainWindow()
     wc.hInstance = g_hinst;
     wc.lpfnWndProc = Zoomin::WndProc;
     RegisterClass(&wc);
-
-    const DWORD c_style = WS_OVERLAPPEDWINDOW|WS_VSCROLL;
-    return CreateWindow(c_wndclass_name, TEXT("Zoomin"), c_style,
-                        CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT,
-                        NULL, NULL, g_hinst, NULL);
+    StartupMark(L"RegisterClass");
+
+    const DWORD c_style = WS_OVERLAPPEDWINDOW|WS_VSCROLL|WS_CLIPCHILDREN;
+    const HWND hwnd = CreateWindow(c_wndclass_name, TEXT("Zoomin"), c_style,
+                                   CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT,
+                                   NULL, NULL, g_hinst, NULL);
+    StartupMark(L"CreateMainWindow");
+    return hwnd;
 }
 
 //------------------------------------------------------------------------------
@@ -1212,14 +3184,49 @@ static HWND CreateMainWindow()
 
 int PASCAL WinMain(HINSTANCE hinstCurrent, HINSTANCE /*hinstPrevious*/, LPSTR /*lpszCmdLine*/, int nCmdShow)
 {
+    StartupMark(L"WinMain");
+
     MSG msg = {};
     g_hinst = hinstCurrent;
+
+    {
+        int argc = 0;
+        LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+        if (argv && argc == 3 && !wcscmp(argv[1], L"--bench"))
+        {
+            const int ret = RunBenchmark(argv[2]);
+            LocalFree(argv);
+            return ret;
+        }
+        if (argv && argc == 3 && !wcscmp(argv[1], L"--startup-bench"))
+        {
+            const int ret = RunStartupBenchmark(unsigned(_wtoi(argv[2])));
+            LocalFree(argv);
+            return ret;
+        }
+        if (argv && argc >= 3 && (!wcscmp(argv[1], L"--capture") || !wcscmp(argv[1], L"--capture-batch")))
+        {
+            const int ret = RunHeadlessCapture(argc - 1, argv + 1);
+            LocalFree(argv);
+            return ret;
+        }
+        if (argv && argc == 2 && !wcscmp(argv[1], L"--startup-trace"))
+            EnableStartupTrace();
+        if (argv && argc == 2 && !wcscmp(argv[1], L"--resident"))
+            g_start_hidden = true;
+        if (argv)
+            LocalFree(argv);
+    }
+
     g_haccel = LoadAccelerators(g_hinst, MAKEINTRESOURCE(IDR_ACCEL));
+    StartupMark(L"LoadAccelerators");
 
     HWND hwnd = CreateMainWindow();
     if (hwnd)
     {
-        ShowWindow(hwnd, nCmdShow);
+        if (!g_start_hidden)
+            ShowWindow(hwnd, nCmdShow);
+        StartupMark(L"ShowWindow");
 
         while (GetMessage(&msg, nullptr, 0, 0))
         {
@@ -0,0 +1,109 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "moncache.h"
+#include "monitors.h"
+#include "dpi.h"
+
+static MonitorTable s_table;
+static bool s_valid = false;
+
+static MonitorRect ToMonitorRect(const RECT& rc)
+{
+    MonitorRect mr;
+    mr.left = rc.left;
+    mr.top = rc.top;
+    mr.right = rc.right;
+    mr.bottom = rc.bottom;
+    return mr;
+}
+
+static RECT ToRect(const MonitorRect& mr)
+{
+    RECT rc;
+    rc.left = mr.left;
+    rc.top = mr.top;
+    rc.right = mr.right;
+    rc.bottom = mr.bottom;
+    return rc;
+}
+
+static BOOL CALLBACK EnumMonitorProc(HMONITOR hmon, HDC /*hdc*/, LPRECT /*prc*/, LPARAM /*lParam*/)
+{
+    MONITORINFO mi = { sizeof(mi) };
+    if (GetMonitorInfo(hmon, &mi))
+    {
+        MonitorEntry entry;
+        entry.monitor = ToMonitorRect(mi.rcMonitor);
+        entry.work = ToMonitorRect(mi.rcWork);
+        entry.dpi = __GetDpiForMonitor(hmon);
+        entry.handle = hmon;
+        s_table.Add(entry);
+    }
+    return true;
+}
+
+static bool EnsureMonitorCache()
+{
+    if (!s_valid)
+    {
+        s_table.Clear();
+        EnumDisplayMonitors(NULL, nullptr, EnumMonitorProc, 0);
+        s_table.Build();
+        s_valid = !s_table.IsEmpty();
+    }
+    return s_valid;
+}
+
+bool GetCachedMonitorInfo(POINT pt, CachedMonitorInfo& info)
+{
+    if (EnsureMonitorCache())
+    {
+        const MonitorEntry* entry = s_table.FromPoint(pt.x, pt.y, true/*nearest*/);
+        if (entry)
+        {
+            info.hmon = HMONITOR(entry->handle);
+            info.rcMonitor = ToRect(entry->monitor);
+            info.rcWork = ToRect(entry->work);
+            info.dpi = WORD(entry->dpi);
+            return true;
+        }
+    }
+
+    // Fall back to asking the OS.
+    MONITORINFO mi = { sizeof(mi) };
+    info.hmon = MonitorFromPoint(pt, MONITOR_DEFAULTTONEAREST);
+    if (!info.hmon || !GetMonitorInfo(info.hmon, &mi))
+        return false;
+    info.rcMonitor = mi.rcMonitor;
+    info.rcWork = mi.rcWork;
+    info.dpi = __GetDpiForMonitor(info.hmon);
+    return true;
+}
+
+bool GetCachedMonitors(std::vector<CachedMonitorInfo>& monitors)
+{
+    monitors.clear();
+    if (!EnsureMonitorCache())
+        return false;
+
+    for (size_t ii = 0; ii < s_table.GetCount(); ++ii)
+    {
+        const MonitorEntry& entry = s_table.GetEntry(ii);
+        CachedMonitorInfo info;
+        info.hmon = HMONITOR(entry.handle);
+        info.rcMonitor = ToRect(entry.monitor);
+        info.rcWork = ToRect(entry.work);
+        info.dpi = WORD(entry.dpi);
+        monitors.push_back(info);
+    }
+    return true;
+}
+
+void InvalidateMonitorCache()
+{
+    s_valid = false;
+}
@@ -0,0 +1,24 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Cached monitor topology, shared by the main window and the reticle, so that
+// mouse moves don't need MonitorFromPoint, GetMonitorInfo, and GetDpiForMonitor
+// kernel transitions.  The cache is rebuilt on the next lookup after it's
+// invalidated (on WM_DISPLAYCHANGE, WM_DPICHANGED, and WM_SETTINGCHANGE).
+
+struct CachedMonitorInfo
+{
+    HMONITOR        hmon;
+    RECT            rcMonitor;
+    RECT            rcWork;
+    WORD            dpi;
+};
+
+bool GetCachedMonitorInfo(POINT pt, CachedMonitorInfo& info);
+bool GetCachedMonitors(std::vector<CachedMonitorInfo>& monitors);
+void InvalidateMonitorCache();
@@ -0,0 +1,113 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <assert.h>
+#include <algorithm>
+
+#include "monitors.h"
+
+void MonitorTable::Clear()
+{
+    m_entries.clear();
+    m_xs.clear();
+    m_ys.clear();
+    m_cells.clear();
+    m_last = 0;
+}
+
+void MonitorTable::Add(const MonitorEntry& entry)
+{
+    m_entries.push_back(entry);
+}
+
+void MonitorTable::Build()
+{
+    m_xs.clear();
+    m_ys.clear();
+    m_cells.clear();
+    m_last = 0;
+
+    for (const auto& entry : m_entries)
+    {
+        m_xs.push_back(entry.monitor.left);
+        m_xs.push_back(entry.monitor.right);
+        m_ys.push_back(entry.monitor.top);
+        m_ys.push_back(entry.monitor.bottom);
+    }
+
+    std::sort(m_xs.begin(), m_xs.end());
+    std::sort(m_ys.begin(), m_ys.end());
+    m_xs.erase(std::unique(m_xs.begin(), m_xs.end()), m_xs.end());
+    m_ys.erase(std::unique(m_ys.begin(), m_ys.end()), m_ys.end());
+
+    if (m_xs.size() < 2 || m_ys.size() < 2)
+        return;
+
+    const size_t cols = m_xs.size() - 1;
+    const size_t rows = m_ys.size() - 1;
+    m_cells.assign(cols * rows, -1);
+
+    // Cells never straddle an edge, so testing one corner of a cell is enough.
+    // The first monitor wins where monitors overlap (e.g. when mirrored).
+    for (size_t row = 0; row < rows; ++row)
+    {
+        for (size_t col = 0; col < cols; ++col)
+        {
+            for (size_t ii = 0; ii < m_entries.size(); ++ii)
+            {
+                if (m_entries[ii].monitor.Contains(m_xs[col], m_ys[row]))
+                {
+                    m_cells[row * cols + col] = int32_t(ii);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+const MonitorEntry* MonitorTable::FromPoint(int32_t x, int32_t y, bool nearest) const
+{
+    if (m_entries.empty())
+        return nullptr;
+
+    assert(m_last < m_entries.size());
+    if (m_entries[m_last].monitor.Contains(x, y))
+        return &m_entries[m_last];
+
+    if (!m_cells.empty() &&
+        x >= m_xs.front() && x < m_xs.back() &&
+        y >= m_ys.front() && y < m_ys.back())
+    {
+        const size_t col = size_t(std::upper_bound(m_xs.begin(), m_xs.end(), x) - m_xs.begin()) - 1;
+        const size_t row = size_t(std::upper_bound(m_ys.begin(), m_ys.end(), y) - m_ys.begin()) - 1;
+        const int32_t index = m_cells[row * (m_xs.size() - 1) + col];
+        if (index >= 0)
+        {
+            m_last = size_t(index);
+            return &m_entries[m_last];
+        }
+    }
+
+    return nearest ? FindNearest(x, y) : nullptr;
+}
+
+const MonitorEntry* MonitorTable::FindNearest(int32_t x, int32_t y) const
+{
+    const MonitorEntry* best = nullptr;
+    int64_t best_distance = 0;
+
+    for (const auto& entry : m_entries)
+    {
+        const MonitorRect& rc = entry.monitor;
+        const int64_t dx = (x < rc.left) ? int64_t(rc.left) - x : (x >= rc.right) ? int64_t(x) - (rc.right - 1) : 0;
+        const int64_t dy = (y < rc.top) ? int64_t(rc.top) - y : (y >= rc.bottom) ? int64_t(y) - (rc.bottom - 1) : 0;
+        const int64_t distance = dx * dx + dy * dy;
+        if (!best || distance < best_distance)
+        {
+            best = &entry;
+            best_distance = distance;
+        }
+    }
+
+    return best;
+}
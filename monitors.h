@@ -0,0 +1,61 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// MonitorTable holds the monitor topology (monitor rects, work areas, and
+// effective DPIs) with a small spatial index for point lookups.
+//
+// The index is a grid formed by the distinct monitor edges; each cell records
+// which monitor covers it, so a lookup is two binary searches.  The most
+// recent hit is checked first, since consecutive lookups (e.g. mouse moves)
+// are almost always on the same monitor.
+//
+// See moncache.h for the Windows glue.  tests/monitors_test.cpp checks
+// lookups against a brute force search of the monitors.
+
+struct MonitorRect
+{
+    int32_t         left = 0;
+    int32_t         top = 0;
+    int32_t         right = 0;
+    int32_t         bottom = 0;
+
+    bool            Contains(int32_t x, int32_t y) const { return x >= left && x < right && y >= top && y < bottom; }
+};
+
+struct MonitorEntry
+{
+    MonitorRect     monitor;
+    MonitorRect     work;
+    uint32_t        dpi = 96;
+    void*           handle = nullptr;
+};
+
+class MonitorTable
+{
+public:
+    void            Clear();
+    void            Add(const MonitorEntry& entry);
+    void            Build();
+
+    bool            IsEmpty() const { return m_entries.empty(); }
+    size_t          GetCount() const { return m_entries.size(); }
+    const MonitorEntry& GetEntry(size_t index) const { return m_entries[index]; }
+
+    const MonitorEntry* FromPoint(int32_t x, int32_t y, bool nearest) const;
+
+private:
+    const MonitorEntry* FindNearest(int32_t x, int32_t y) const;
+
+    std::vector<MonitorEntry> m_entries;
+    std::vector<int32_t> m_xs;          // Sorted distinct vertical edges.
+    std::vector<int32_t> m_ys;          // Sorted distinct horizontal edges.
+    std::vector<int32_t> m_cells;       // Monitor index per cell, or -1.
+    mutable size_t  m_last = 0;
+};
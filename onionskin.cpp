@@ -0,0 +1,105 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "onionskin.h"
+
+// Rounds v / 255 exactly for v in 0 .. 255 * 255.
+static uint32_t Div255(uint32_t v)
+{
+    v += 128;
+    return (v + (v >> 8)) >> 8;
+}
+
+#ifdef USE_SSE2
+static __m128i Div255(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+#endif
+
+void BlendOnionSkinRow(const uint32_t* base, const uint32_t* layer, int32_t count, uint8_t opacity, bool use_alpha, uint32_t* out)
+{
+    int32_t ii = 0;
+#ifdef USE_SSE2
+    // Two pixels per register, as 16-bit channels.  The products and their
+    // sum fit in 16 bits, since the weights sum to 255.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    const __m128i vopacity = _mm_set1_epi16(opacity);
+    const __m128i rgb = _mm_set1_epi32(0x00ffffff);
+    auto blend2 = [&](__m128i b, __m128i l)
+    {
+        __m128i a = vopacity;
+        if (use_alpha)
+        {
+            const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(l, 0xff), 0xff);
+            a = Div255(_mm_mullo_epi16(alpha, vopacity));
+        }
+        const __m128i sum = _mm_add_epi16(_mm_mullo_epi16(b, _mm_sub_epi16(max, a)), _mm_mullo_epi16(l, a));
+        return Div255(sum);
+    };
+    for (; ii + 4 <= count; ii += 4)
+    {
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + ii));
+        const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(layer + ii));
+        const __m128i lo = blend2(_mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(l, zero));
+        const __m128i hi = blend2(_mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(l, zero));
+        const __m128i blended = _mm_packus_epi16(lo, hi);
+        const __m128i result = _mm_or_si128(_mm_and_si128(blended, rgb), _mm_andnot_si128(rgb, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + ii), result);
+    }
+#endif
+    for (; ii < count; ++ii)
+    {
+        const uint32_t b = base[ii];
+        const uint32_t l = layer[ii];
+        const uint32_t a = use_alpha ? Div255((l >> 24) * opacity) : opacity;
+        uint32_t result = b & 0xff000000;
+        for (uint32_t shift = 0; shift < 24; shift += 8)
+        {
+            const uint32_t channel = Div255(((b >> shift) & 0xff) * (255 - a) + ((l >> shift) & 0xff) * a);
+            result |= channel << shift;
+        }
+        out[ii] = result;
+    }
+}
+
+void BlendOnionSkin(const PixelSource& base, const PixelSource& layer, int32_t x, int32_t y, uint8_t opacity, bool use_alpha,
+                    std::vector<uint32_t>& pixels, PixelSource& out)
+{
+    pixels.resize(size_t(base.cx) * base.cy);
+
+    // The columns of base that the layer covers.
+    const int32_t left = std::max<int32_t>(x, 0);
+    const int32_t right = std::min<int32_t>(x + layer.cx, base.cx);
+
+    for (int32_t yy = 0; yy < base.cy; ++yy)
+    {
+        const uint32_t* const from = base.bits + yy * base.stride;
+        uint32_t* const to = &pixels[size_t(yy) * base.cx];
+        const int32_t layer_y = yy - y;
+        if (layer_y < 0 || layer_y >= layer.cy || left >= right)
+        {
+            memcpy(to, from, base.cx * sizeof(*to));
+            continue;
+        }
+
+        memcpy(to, from, left * sizeof(*to));
+        BlendOnionSkinRow(from + left, layer.bits + layer_y * layer.stride + (left - x), right - left, opacity, use_alpha, to + left);
+        memcpy(to + right, from + right, (base.cx - right) * sizeof(*to));
+    }
+
+    out.bits = pixels.data();
+    out.stride = base.cx;
+    out.cx = base.cx;
+    out.cy = base.cy;
+}
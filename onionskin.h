@@ -0,0 +1,25 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <vector>
+
+#include "pixels.h"
+
+//------------------------------------------------------------------------------
+// Onion skin overlay.
+//
+// A reference image (e.g. a design mockup) is alpha blended over the zoom area
+// before scaling, so it works with every renderer and the gridlines and labels
+// still line up with the pixels.
+
+// Blends one row:  each channel is base + (layer - base) * alpha, rounded,
+// where alpha is opacity times the layer pixel's alpha (when use_alpha) over
+// 255.  The top byte of out is the top byte of base.
+void BlendOnionSkinRow(const uint32_t* base, const uint32_t* layer, int32_t count, uint8_t opacity, bool use_alpha, uint32_t* out);
+
+// Blends layer, with its top left at (x, y) relative to base, over base into
+// pixels.  Returns the blended pixels as out.
+void BlendOnionSkin(const PixelSource& base, const PixelSource& layer, int32_t x, int32_t y, uint8_t opacity, bool use_alpha,
+                    std::vector<uint32_t>& pixels, PixelSource& out);
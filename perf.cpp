@@ -0,0 +1,18 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "perf.h"
+
+double GetPerfSeconds()
+{
+    static LARGE_INTEGER s_freq = {};
+    if (!s_freq.QuadPart)
+        QueryPerformanceFrequency(&s_freq);
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return double(now.QuadPart) / double(s_freq.QuadPart);
+}
@@ -0,0 +1,9 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+// High resolution timing for instrumentation.
+
+double GetPerfSeconds();
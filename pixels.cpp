@@ -0,0 +1,53 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <string.h>
+
+#include "pixels.h"
+
+// The alpha byte of captured pixels is undefined, so it's ignored.
+constexpr uint32_t c_rgb_mask = 0x00ffffff;
+constexpr uint64_t c_rgb_mask2 = 0x00ffffff00ffffffull;
+
+//------------------------------------------------------------------------------
+// HashPixels.
+//
+// This only needs to detect whether the pixels changed between frames, not
+// resist collisions, so it uses four independent multiply lanes to keep the
+// multiplier busy instead of a byte-at-a-time hash.
+
+uint64_t HashPixels(const PixelSource& src)
+{
+    constexpr uint64_t c_prime = 0x9e3779b97f4a7c15ull;
+    uint64_t h0 = 0x243f6a8885a308d3ull;
+    uint64_t h1 = 0x13198a2e03707344ull;
+    uint64_t h2 = 0xa4093822299f31d0ull;
+    uint64_t h3 = 0x082efa98ec4e6c89ull;
+
+    for (int32_t yy = 0; yy < src.cy; ++yy)
+    {
+        const uint32_t* const row = src.bits + yy * src.stride;
+
+        int32_t xx = 0;
+        for (; xx + 8 <= src.cx; xx += 8)
+        {
+            uint64_t w[4];
+            memcpy(w, row + xx, sizeof(w));
+            h0 = (h0 ^ (w[0] & c_rgb_mask2)) * c_prime;
+            h1 = (h1 ^ (w[1] & c_rgb_mask2)) * c_prime;
+            h2 = (h2 ^ (w[2] & c_rgb_mask2)) * c_prime;
+            h3 = (h3 ^ (w[3] & c_rgb_mask2)) * c_prime;
+        }
+        for (; xx < src.cx; ++xx)
+            h0 = (h0 ^ (row[xx] & c_rgb_mask)) * c_prime;
+
+        // Mix in the row boundary, so a shifted image hashes differently.
+        h1 = (h1 ^ uint64_t(yy)) * c_prime;
+    }
+
+    uint64_t h = h0 ^ (h1 >> 17) ^ (h2 << 23) ^ (h3 >> 41);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
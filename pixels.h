@@ -0,0 +1,29 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// Pixel buffers and operations over them.
+//
+// Pixels are 32bpp 0x00RRGGBB, as in a 32bpp DIB section.
+
+struct PixelSource
+{
+    const uint32_t* bits = nullptr;     // Top-left pixel of the zoom area.
+    int32_t         stride = 0;         // In pixels.
+    int32_t         cx = 0;
+    int32_t         cy = 0;
+};
+
+struct PixelTarget
+{
+    uint32_t*       bits = nullptr;
+    int32_t         stride = 0;         // In pixels.
+    int32_t         cx = 0;
+    int32_t         cy = 0;
+};
+
+uint64_t HashPixels(const PixelSource& src);
@@ -70,6 +70,9 @@ define_exe("zoomin", "windowedapp")
     links("comctl32")
     links("d2d1")
     links("dwrite")
+    links("dwmapi")
+    links("windowscodecs")
+    links("wtsapi32")
 
     includedirs(".build/vs2022/bin") -- for the generated manifest.xml
     files("*.cpp")
@@ -79,6 +82,42 @@ define_exe("zoomin", "windowedapp")
         defines("_CRT_SECURE_NO_WARNINGS")
         defines("_CRT_NONSTDC_NO_WARNINGS")
 
+--------------------------------------------------------------------------------
+-- Tests for the modules that have no dependencies on Windows; these build and
+-- run on any platform, e.g. `premake5 gmake && make -C .build/gmake tests config=release_x64`.
+-- tests_nosse2 builds the same tests without the SSE2 code paths.
+local function define_tests(name, nosse2)
+    define_exe(name)
+        targetname(name)
+        files("tests/*.cpp")
+        files("diff.cpp")
+        files("edges.cpp")
+        files("elements.cpp")
+        files("filters.cpp")
+        files("labels.cpp")
+        files("monitors.cpp")
+        files("scaler.cpp")
+        files("search.cpp")
+        files("settings.cpp")
+        files("threadpool.cpp")
+
+        if nosse2 then
+            defines("NO_SSE2")
+        end
+
+        filter "action:vs*"
+            defines("_CRT_SECURE_NO_WARNINGS")
+            defines("_CRT_NONSTDC_NO_WARNINGS")
+
+        filter "system:not windows"
+            links("pthread")
+
+        filter {}
+end
+
+define_tests("tests")
+define_tests("tests_nosse2", true)
+
 
 
 --------------------------------------------------------------------------------
@@ -0,0 +1,287 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "regionstats.h"
+
+constexpr size_t c_min_color_slots = 64;
+
+#ifdef USE_SSE2
+// Each 32-bit lane accumulates at most 255 * 255 per vector, so spill the
+// lanes into 64-bit totals before they can overflow.
+constexpr uint32_t c_spill_vectors = 4096;
+#endif
+
+//------------------------------------------------------------------------------
+// ColorSet.
+
+void ColorSet::Reset(size_t count)
+{
+    // At most half full, so probe sequences stay short.
+    size_t capacity = c_min_color_slots;
+    while (capacity < count * 2)
+        capacity *= 2;
+
+    if (capacity > m_slots.size())
+    {
+        m_slots.assign(capacity, 0);
+        m_generation = 0;
+        m_shift = 32;
+        for (size_t ii = capacity; ii > 1; ii >>= 1)
+            --m_shift;
+    }
+
+    // Slots from older generations read as empty.  Zero is never a current
+    // generation, so freshly zeroed slots are empty too.
+    if (!++m_generation)
+    {
+        std::fill(m_slots.begin(), m_slots.end(), 0);
+        m_generation = 1;
+    }
+}
+
+bool ColorSet::Insert(uint32_t color)
+{
+    const uint64_t tag = (uint64_t(m_generation) << 32) | color;
+    const size_t mask = m_slots.size() - 1;
+    size_t ii = uint32_t(color * 0x9e3779b1u) >> m_shift;
+    while (true)
+    {
+        uint64_t& slot = m_slots[ii];
+        if (uint32_t(slot >> 32) != m_generation)
+        {
+            slot = tag;
+            return true;
+        }
+        if (slot == tag)
+            return false;
+        ii = (ii + 1) & mask;
+    }
+}
+
+//------------------------------------------------------------------------------
+// ComputeRegionStats.
+
+void ComputeRegionStats(const PixelSource& src, ColorSet& colors, RegionStats& stats)
+{
+    stats = RegionStats();
+    for (auto& channel : stats.channels)
+        memset(channel.histogram, 0, sizeof(channel.histogram));
+    if (src.cx <= 0 || src.cy <= 0)
+        return;
+
+    stats.pixels = uint32_t(src.cx) * uint32_t(src.cy);
+    colors.Reset(stats.pixels);
+
+    uint64_t sum[SC_COUNT] = {};
+    uint64_t squares[SC_COUNT] = {};
+    uint8_t min[SC_COUNT] = { 0xff, 0xff, 0xff };
+    uint8_t max[SC_COUNT] = {};
+
+#ifdef USE_SSE2
+    const __m128i mask = _mm_set1_epi32(0xff);
+    __m128i vmin = _mm_set1_epi8(char(0xff));
+    __m128i vmax = _mm_setzero_si128();
+    __m128i vsum[SC_COUNT];
+    __m128i vsquares[SC_COUNT];
+    uint32_t vectors = 0;
+    auto spill = [&]()
+    {
+        alignas(16) uint32_t lanes[4];
+        for (int32_t ch = 0; ch < SC_COUNT; ++ch)
+        {
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), vsum[ch]);
+            sum[ch] += uint64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+            _mm_store_si128(reinterpret_cast<__m128i*>(lanes), vsquares[ch]);
+            squares[ch] += uint64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+            vsum[ch] = _mm_setzero_si128();
+            vsquares[ch] = _mm_setzero_si128();
+        }
+        vectors = 0;
+    };
+    for (int32_t ch = 0; ch < SC_COUNT; ++ch)
+    {
+        vsum[ch] = _mm_setzero_si128();
+        vsquares[ch] = _mm_setzero_si128();
+    }
+#endif
+
+    uint32_t previous = 0xffffffff;
+    for (int32_t yy = 0; yy < src.cy; ++yy)
+    {
+        const uint32_t* const row = src.bits + yy * src.stride;
+
+        int32_t xx = 0;
+#ifdef USE_SSE2
+        // Byte-wise min and max cover all channels at once.  Each channel
+        // sits in the low 16 bits of its 32-bit lane, so madd squares it.
+        for (; xx + 4 <= src.cx; xx += 4)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + xx));
+            vmin = _mm_min_epu8(vmin, v);
+            vmax = _mm_max_epu8(vmax, v);
+
+            const __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), mask);
+            const __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8), mask);
+            const __m128i b = _mm_and_si128(v, mask);
+            vsum[SC_RED] = _mm_add_epi32(vsum[SC_RED], r);
+            vsum[SC_GREEN] = _mm_add_epi32(vsum[SC_GREEN], g);
+            vsum[SC_BLUE] = _mm_add_epi32(vsum[SC_BLUE], b);
+            vsquares[SC_RED] = _mm_add_epi32(vsquares[SC_RED], _mm_madd_epi16(r, r));
+            vsquares[SC_GREEN] = _mm_add_epi32(vsquares[SC_GREEN], _mm_madd_epi16(g, g));
+            vsquares[SC_BLUE] = _mm_add_epi32(vsquares[SC_BLUE], _mm_madd_epi16(b, b));
+
+            if (++vectors == c_spill_vectors)
+                spill();
+        }
+#endif
+        for (; xx < src.cx; ++xx)
+        {
+            const uint32_t p = row[xx];
+            for (int32_t ch = 0; ch < SC_COUNT; ++ch)
+            {
+                const uint8_t value = uint8_t(p >> (16 - ch * 8));
+                min[ch] = std::min<uint8_t>(min[ch], value);
+                max[ch] = std::max<uint8_t>(max[ch], value);
+                sum[ch] += value;
+                squares[ch] += uint32_t(value) * value;
+            }
+        }
+
+        // Scatter increments don't vectorize; runs of the same color are
+        // common in UI, so skip the hash set for repeats.
+        uint32_t* const hr = stats.channels[SC_RED].histogram;
+        uint32_t* const hg = stats.channels[SC_GREEN].histogram;
+        uint32_t* const hb = stats.channels[SC_BLUE].histogram;
+        for (xx = 0; xx < src.cx; ++xx)
+        {
+            const uint32_t p = row[xx] & 0x00ffffff;
+            ++hr[p >> 16];
+            ++hg[(p >> 8) & 0xff];
+            ++hb[p & 0xff];
+            if (p != previous)
+            {
+                previous = p;
+                stats.unique_colors += colors.Insert(p);
+            }
+        }
+    }
+
+#ifdef USE_SSE2
+    spill();
+
+    alignas(16) uint8_t bytes_min[16];
+    alignas(16) uint8_t bytes_max[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(bytes_min), vmin);
+    _mm_store_si128(reinterpret_cast<__m128i*>(bytes_max), vmax);
+    for (int32_t ii = 0; ii < 16; ii += 4)
+    {
+        for (int32_t ch = 0; ch < SC_COUNT; ++ch)
+        {
+            // Bytes are B, G, R, X in memory.
+            min[ch] = std::min<uint8_t>(min[ch], bytes_min[ii + 2 - ch]);
+            max[ch] = std::max<uint8_t>(max[ch], bytes_max[ii + 2 - ch]);
+        }
+    }
+#endif
+
+    const double count = stats.pixels;
+    for (int32_t ch = 0; ch < SC_COUNT; ++ch)
+    {
+        ChannelStats& channel = stats.channels[ch];
+        channel.min = min[ch];
+        channel.max = max[ch];
+        channel.mean = sum[ch] / count;
+        channel.stddev = sqrt(std::max<double>(0, squares[ch] / count - channel.mean * channel.mean));
+    }
+}
+
+//------------------------------------------------------------------------------
+// RegionStatsWorker.
+
+RegionStatsWorker::RegionStatsWorker(std::function<void()>&& ready)
+: m_ready(std::move(ready))
+{
+    m_thread = std::thread(&RegionStatsWorker::WorkerProc, this);
+}
+
+RegionStatsWorker::~RegionStatsWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void RegionStatsWorker::Submit(const PixelSource& src)
+{
+    if (src.cx <= 0 || src.cy <= 0)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.resize(size_t(src.cx) * src.cy);
+        for (int32_t yy = 0; yy < src.cy; ++yy)
+            memcpy(&m_pending[size_t(yy) * src.cx], src.bits + yy * src.stride, src.cx * sizeof(*src.bits));
+        m_pending_cx = src.cx;
+        m_pending_cy = src.cy;
+        m_has_pending = true;
+    }
+    m_wake.notify_one();
+}
+
+bool RegionStatsWorker::GetResults(RegionStats& stats) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_has_results)
+        return false;
+    stats = m_results;
+    return true;
+}
+
+void RegionStatsWorker::WorkerProc()
+{
+    std::vector<uint32_t> pixels;
+    ColorSet colors;
+    RegionStats stats;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wake.wait(lock, [this]() { return m_exit || m_has_pending; });
+        if (m_exit)
+            break;
+
+        // Swapping keeps both buffers allocated, so steady state submissions
+        // don't allocate.
+        pixels.swap(m_pending);
+        PixelSource src;
+        src.bits = pixels.data();
+        src.stride = m_pending_cx;
+        src.cx = m_pending_cx;
+        src.cy = m_pending_cy;
+        m_has_pending = false;
+
+        lock.unlock();
+        ComputeRegionStats(src, colors, stats);
+        lock.lock();
+
+        m_results = stats;
+        m_has_results = true;
+
+        lock.unlock();
+        if (m_ready)
+            m_ready();
+        lock.lock();
+    }
+}
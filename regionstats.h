@@ -0,0 +1,95 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pixels.h"
+
+//------------------------------------------------------------------------------
+// Region statistics.
+//
+// Per channel min, max, mean, standard deviation, and 256 bin histogram, plus
+// the number of unique colors, over the zoom area.  The reductions are SIMD,
+// and unique colors are counted with an open addressing hash set that's reused
+// between frames, so it's cleared by bumping a generation instead of zeroing.
+
+enum StatsChannel
+{
+    SC_RED,
+    SC_GREEN,
+    SC_BLUE,
+    SC_COUNT
+};
+
+struct ChannelStats
+{
+    uint8_t         min = 0;
+    uint8_t         max = 0;
+    double          mean = 0;
+    double          stddev = 0;
+    uint32_t        histogram[256];
+};
+
+struct RegionStats
+{
+    uint32_t        pixels = 0;
+    uint32_t        unique_colors = 0;
+    ChannelStats    channels[SC_COUNT];
+};
+
+class ColorSet
+{
+public:
+    // Empties the set, and makes room for up to count colors.
+    void            Reset(size_t count);
+    // Returns true if the color wasn't already in the set.
+    bool            Insert(uint32_t color);
+
+private:
+    std::vector<uint64_t> m_slots;      // Generation in the high half.
+    uint32_t        m_generation = 0;
+    uint32_t        m_shift = 32;
+};
+
+void ComputeRegionStats(const PixelSource& src, ColorSet& colors, RegionStats& stats);
+
+//------------------------------------------------------------------------------
+// RegionStatsWorker computes statistics on its own thread.  Submit copies the
+// pixels, so the caller's buffer can change immediately; if a newer frame is
+// submitted before an older one is started, the older one is skipped.  The
+// ready callback runs on the worker thread.
+
+class RegionStatsWorker
+{
+public:
+    explicit        RegionStatsWorker(std::function<void()>&& ready);
+                    ~RegionStatsWorker();
+
+    void            Submit(const PixelSource& src);
+    // Returns false if no results are available yet.
+    bool            GetResults(RegionStats& stats) const;
+
+private:
+    void            WorkerProc();
+
+    const std::function<void()> m_ready;
+    std::thread     m_thread;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool            m_exit = false;
+
+    // Guarded by m_mutex.
+    std::vector<uint32_t> m_pending;
+    int32_t         m_pending_cx = 0;
+    int32_t         m_pending_cy = 0;
+    bool            m_has_pending = false;
+    RegionStats     m_results;
+    bool            m_has_results = false;
+};
@@ -0,0 +1,59 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "regsettings.h"
+
+bool RegistrySettingsBackend::Load(std::vector<SettingsEntry>& entries)
+{
+    HKEY hkey;
+    if (ERROR_SUCCESS != RegOpenKeyEx(m_root, m_subkey.c_str(), 0, KEY_QUERY_VALUE, &hkey))
+        return false;
+
+    // Zoomin's value names are short; values with longer names (or that aren't
+    // DWORDs) fail with ERROR_MORE_DATA and are skipped.
+    WCHAR name[256];
+    for (DWORD index = 0;; ++index)
+    {
+        DWORD cchName = _countof(name);
+        DWORD type;
+        LONG value;
+        DWORD cb = sizeof(value);
+        const LONG err = RegEnumValue(hkey, index, name, &cchName, nullptr, &type, reinterpret_cast<BYTE*>(&value), &cb);
+        if (err == ERROR_NO_MORE_ITEMS)
+            break;
+        if (err != ERROR_SUCCESS || type != REG_DWORD || cb != sizeof(value))
+            continue;
+
+        SettingsEntry entry;
+        entry.name.assign(name, cchName);
+        entry.value = value;
+        entries.push_back(std::move(entry));
+    }
+
+    RegCloseKey(hkey);
+    return true;
+}
+
+bool RegistrySettingsBackend::Save(const std::vector<SettingsEntry>& entries)
+{
+    HKEY hkey;
+    if (ERROR_SUCCESS != RegCreateKeyEx(m_root, m_subkey.c_str(), 0, nullptr, 0, KEY_SET_VALUE, nullptr, &hkey, nullptr))
+        return false;
+
+    bool ok = true;
+    for (const auto& entry : entries)
+    {
+        if (!entry.dirty)
+            continue;
+
+        const LONG value = entry.value;
+        if (ERROR_SUCCESS != RegSetValueEx(hkey, entry.name.c_str(), 0, REG_DWORD, reinterpret_cast<const BYTE*>(&value), sizeof(value)))
+            ok = false;
+    }
+
+    RegCloseKey(hkey);
+    return ok;
+}
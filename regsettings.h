@@ -0,0 +1,24 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "settings.h"
+
+//------------------------------------------------------------------------------
+// RegistrySettingsBackend keeps settings as REG_DWORD values under a registry
+// key.  Load enumerates the key once, and Save opens it once and writes only
+// the dirty values.
+
+class RegistrySettingsBackend : public SettingsBackend
+{
+public:
+                    RegistrySettingsBackend(HKEY root, const WCHAR* subkey) : m_root(root), m_subkey(subkey) {}
+
+    bool            Load(std::vector<SettingsEntry>& entries) override;
+    bool            Save(const std::vector<SettingsEntry>& entries) override;
+
+private:
+    HKEY            m_root;
+    std::wstring    m_subkey;
+};
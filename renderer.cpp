@@ -0,0 +1,447 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <d2d1.h>
+#include <wrl/client.h>
+#include <algorithm>
+#include <vector>
+
+#include "renderer.h"
+#include "dib.h"
+#include "labels.h"
+#include "threadpool.h"
+
+using Microsoft::WRL::ComPtr;
+
+const WCHAR* GetRendererName(RendererKind kind)
+{
+    switch (kind)
+    {
+    case RK_GDI:        return L"GDI";
+    case RK_DIRECT2D:   return L"Direct2D";
+    case RK_SOFTWARE:   return L"Software Reference";
+    default:            return L"";
+    }
+}
+
+//------------------------------------------------------------------------------
+// DibRenderer:  GDI and software reference.
+
+class DibRenderer : public Renderer
+{
+public:
+    explicit DibRenderer(bool reference) : m_reference(reference) {}
+
+    RendererKind GetKind() const override { return m_reference ? RK_SOFTWARE : RK_GDI; }
+    const WCHAR* GetName() const override { return GetRendererName(GetKind()); }
+    bool Prepare(const RenderTarget& target) override;
+    bool Render(const RenderTarget& target, const PixelSource& src, const ScaleParams& params, PixelLabels* labels) override;
+
+private:
+    const bool      m_reference;
+    DibSection      m_backbuffer;
+    std::vector<uint32_t> m_diff;       // Unscaled difference image, for labels.
+};
+
+bool DibRenderer::Prepare(const RenderTarget& target)
+{
+    return m_backbuffer.EnsureSize(target.cx, target.cy);
+}
+
+bool DibRenderer::Render(const RenderTarget& target, const PixelSource& src, const ScaleParams& params, PixelLabels* labels)
+{
+    if (!m_backbuffer.EnsureSize(target.cx, target.cy))
+        return false;
+
+    PixelTarget dst;
+    dst.bits = reinterpret_cast<uint32_t*>(m_backbuffer.GetBits());
+    dst.stride = m_backbuffer.GetStride();
+    dst.cx = target.cx;
+    dst.cy = target.cy;
+
+    // Labels in diff mode contrast with the difference image, which the scaler
+    // keeps as it computes each row.
+    ScaleParams scale = params;
+    DiffParams diff;
+    if (params.diff && labels)
+    {
+        m_diff.resize(size_t(src.cx) * src.cy);
+        diff = *params.diff;
+        diff.image.bits = m_diff.data();
+        diff.image.stride = src.cx;
+        diff.image.cx = src.cx;
+        diff.image.cy = src.cy;
+        scale.diff = &diff;
+    }
+
+    GdiFlush();
+    if (m_reference)
+        ScaleReference(src, dst, scale);
+    else
+        ScaleTiled(ThreadPool::GetShared(), src, dst, scale);
+    if (labels)
+    {
+        if (scale.diff)
+        {
+            PixelSource image;
+            image.bits = m_diff.data();
+            image.stride = src.cx;
+            image.cx = src.cx;
+            image.cy = src.cy;
+            labels->UpdateContrast(image);
+        }
+        labels->Draw(dst);
+    }
+
+    const HDC hdcTo = target.hdc ? target.hdc : GetDC(target.hwnd);
+
+    HPALETTE hpal;
+    if (target.hpal)
+    {
+        hpal = SelectPalette(hdcTo, target.hpal, false);
+        RealizePalette(hdcTo);
+    }
+
+    BitBlt(hdcTo, 0, 0, target.cx, target.cy, m_backbuffer.GetDC(), 0, 0, SRCCOPY);
+
+    if (target.hpal)
+    {
+        SelectPalette(hdcTo, hpal, false);
+    }
+
+    if (!target.hdc)
+        ReleaseDC(target.hwnd, hdcTo);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// D2DRenderer.
+
+class D2DRenderer : public Renderer
+{
+public:
+    D2DRenderer() = default;
+
+    RendererKind GetKind() const override { return RK_DIRECT2D; }
+    const WCHAR* GetName() const override { return m_software ? L"Direct2D (software)" : L"Direct2D"; }
+    bool Prepare(const RenderTarget& target) override;
+    bool Render(const RenderTarget& target, const PixelSource& src, const ScaleParams& params, PixelLabels* labels) override;
+
+private:
+    bool            EnsureTarget(const RenderTarget& target);
+    bool            EnsureBitmap(const PixelSource& src);
+    bool            EnsureGridlines(const RenderTarget& target, const PixelSource& src, const ScaleParams& params);
+    bool            DrawLabels(const PixelLabels& labels);
+    void            DiscardDeviceResources();
+
+private:
+    ComPtr<ID2D1Factory> m_factory;
+    ComPtr<ID2D1HwndRenderTarget> m_target;
+    ComPtr<ID2D1Bitmap> m_bitmap;
+    ComPtr<ID2D1SolidColorBrush> m_brush;
+    ComPtr<ID2D1PathGeometry> m_gridlines;
+    ComPtr<ID2D1Bitmap> m_atlas;        // A8 copy of the label glyph atlas.
+    ComPtr<ID2D1SolidColorBrush> m_labelBrush;
+    uint32_t        m_atlasGeneration = 0;
+    HWND            m_hwnd = NULL;
+    D2D1_SIZE_U     m_bitmapSize = {};
+    bool            m_software = false;
+    std::vector<uint32_t> m_diff;       // Unscaled difference image.
+    std::vector<uint32_t> m_stripes;    // Unscaled subpixel stripes.
+
+    // What m_gridlines was built for.
+    struct
+    {
+        LONG            cx = -1;
+        LONG            cy = -1;
+        LONG            cy_columns = -1;
+        GridlineSpec    gridlines[2];
+    } m_gridKey;
+};
+
+bool D2DRenderer::Prepare(const RenderTarget& target)
+{
+    return EnsureTarget(target);
+}
+
+bool D2DRenderer::EnsureTarget(const RenderTarget& target)
+{
+    if (!m_factory && FAILED(D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, m_factory.GetAddressOf())))
+        return false;
+
+    // The render target covers the whole client area, even if only part of it
+    // shows the zoom area, so it's presented without stretching.
+    RECT rcClient;
+    GetClientRect(target.hwnd, &rcClient);
+    const D2D1_SIZE_U size = D2D1::SizeU(UINT32(rcClient.right - rcClient.left), UINT32(rcClient.bottom - rcClient.top));
+    if (m_target && m_hwnd == target.hwnd)
+    {
+        const D2D1_SIZE_U current = m_target->GetPixelSize();
+        if (current.width == size.width && current.height == size.height)
+            return true;
+        if (SUCCEEDED(m_target->Resize(size)))
+            return true;
+    }
+
+    DiscardDeviceResources();
+
+    // Use 96 DPI so that DIPs are pixels, and present without waiting for
+    // vsync so frame times are comparable with GDI.  The default target type
+    // falls back to the software rasterizer when there's no usable GPU; if even
+    // that fails, ask for software explicitly.
+    const D2D1_PIXEL_FORMAT format = D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE);
+    const D2D1_HWND_RENDER_TARGET_PROPERTIES hwndProps = D2D1::HwndRenderTargetProperties(target.hwnd, size, D2D1_PRESENT_OPTIONS_IMMEDIATELY);
+    static const D2D1_RENDER_TARGET_TYPE c_types[] = { D2D1_RENDER_TARGET_TYPE_DEFAULT, D2D1_RENDER_TARGET_TYPE_SOFTWARE };
+    for (const auto type : c_types)
+    {
+        const D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties(type, format, 96.0f, 96.0f);
+        if (SUCCEEDED(m_factory->CreateHwndRenderTarget(props, hwndProps, m_target.GetAddressOf())))
+        {
+            const D2D1_RENDER_TARGET_PROPERTIES hardware = D2D1::RenderTargetProperties(D2D1_RENDER_TARGET_TYPE_HARDWARE, format, 96.0f, 96.0f);
+            m_software = !m_target->IsSupported(hardware);
+            break;
+        }
+    }
+
+    if (!m_target)
+        return false;
+
+    m_hwnd = target.hwnd;
+    m_target->SetAntialiasMode(D2D1_ANTIALIAS_MODE_ALIASED);
+    return true;
+}
+
+bool D2DRenderer::EnsureBitmap(const PixelSource& src)
+{
+    // Only grow the bitmap, like DibSection.
+    if (!m_bitmap || UINT32(src.cx) > m_bitmapSize.width || UINT32(src.cy) > m_bitmapSize.height)
+    {
+        m_bitmap.Reset();
+        const D2D1_SIZE_U size = D2D1::SizeU(std::max<UINT32>(src.cx, m_bitmapSize.width), std::max<UINT32>(src.cy, m_bitmapSize.height));
+        const D2D1_BITMAP_PROPERTIES props = D2D1::BitmapProperties(D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_IGNORE), 96.0f, 96.0f);
+        if (FAILED(m_target->CreateBitmap(size, props, m_bitmap.GetAddressOf())))
+            return false;
+        m_bitmapSize = size;
+    }
+
+    const D2D1_RECT_U rc = D2D1::RectU(0, 0, src.cx, src.cy);
+    return SUCCEEDED(m_bitmap->CopyFromMemory(&rc, src.bits, src.stride * sizeof(*src.bits)));
+}
+
+static void AddRectangle(ID2D1GeometrySink* sink, LONG left, LONG top, LONG right, LONG bottom)
+{
+    sink->BeginFigure(D2D1::Point2F(FLOAT(left), FLOAT(top)), D2D1_FIGURE_BEGIN_FILLED);
+    const D2D1_POINT_2F points[] =
+    {
+        D2D1::Point2F(FLOAT(right), FLOAT(top)),
+        D2D1::Point2F(FLOAT(right), FLOAT(bottom)),
+        D2D1::Point2F(FLOAT(left), FLOAT(bottom)),
+    };
+    sink->AddLines(points, _countof(points));
+    sink->EndFigure(D2D1_FIGURE_END_CLOSED);
+}
+
+bool D2DRenderer::EnsureGridlines(const RenderTarget& target, const PixelSource& src, const ScaleParams& params)
+{
+    // Gridline rows span the whole target, but columns stop below the last
+    // source row, the same as ScaleRows.
+    const LONG cy_columns = std::min<LONG>(target.cy, src.cy * params.factor);
+
+    bool same = (m_gridlines && m_gridKey.cx == target.cx && m_gridKey.cy == target.cy && m_gridKey.cy_columns == cy_columns);
+    for (size_t ii = 0; same && ii < _countof(params.gridlines); ++ii)
+    {
+        same = (m_gridKey.gridlines[ii].interval == params.gridlines[ii].interval &&
+                m_gridKey.gridlines[ii].thick == params.gridlines[ii].thick);
+    }
+    if (same)
+        return true;
+
+    m_gridlines.Reset();
+
+    ComPtr<ID2D1GeometrySink> sink;
+    if (FAILED(m_factory->CreatePathGeometry(m_gridlines.GetAddressOf())) ||
+        FAILED(m_gridlines->Open(sink.GetAddressOf())))
+    {
+        m_gridlines.Reset();
+        return false;
+    }
+
+    // Overlapping lines must stay filled, so use winding fill.
+    sink->SetFillMode(D2D1_FILL_MODE_WINDING);
+    for (const auto& grid : params.gridlines)
+    {
+        if (grid.interval <= 0)
+            continue;
+
+        // Lines are centered on multiples of the interval, like a GDI pen.
+        for (LONG xx = 0; xx - grid.thick / 2 < target.cx; xx += grid.interval)
+        {
+            const LONG left = std::max<LONG>(0, xx - grid.thick / 2);
+            const LONG right = std::min<LONG>(target.cx, xx - grid.thick / 2 + grid.thick);
+            AddRectangle(sink.Get(), left, 0, right, cy_columns);
+        }
+        for (LONG yy = 0; yy - grid.thick / 2 < target.cy; yy += grid.interval)
+        {
+            const LONG top = std::max<LONG>(0, yy - grid.thick / 2);
+            const LONG bottom = std::min<LONG>(target.cy, yy - grid.thick / 2 + grid.thick);
+            AddRectangle(sink.Get(), 0, top, target.cx, bottom);
+        }
+    }
+
+    if (FAILED(sink->Close()))
+    {
+        m_gridlines.Reset();
+        return false;
+    }
+
+    m_gridKey.cx = target.cx;
+    m_gridKey.cy = target.cy;
+    m_gridKey.cy_columns = cy_columns;
+    for (size_t ii = 0; ii < _countof(params.gridlines); ++ii)
+        m_gridKey.gridlines[ii] = params.gridlines[ii];
+    return true;
+}
+
+bool D2DRenderer::DrawLabels(const PixelLabels& labels)
+{
+    const GlyphAtlas* const atlas = labels.GetAtlas();
+    if (!m_atlas || m_atlasGeneration != atlas->generation)
+    {
+        m_atlas.Reset();
+        const D2D1_SIZE_U size = D2D1::SizeU(atlas->GetStride(), atlas->slot_cy);
+        const D2D1_BITMAP_PROPERTIES props = D2D1::BitmapProperties(D2D1::PixelFormat(DXGI_FORMAT_A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED), 96.0f, 96.0f);
+        if (FAILED(m_target->CreateBitmap(size, atlas->coverage.data(), atlas->GetStride(), props, m_atlas.GetAddressOf())))
+            return false;
+        m_atlasGeneration = atlas->generation;
+    }
+
+    if (!m_labelBrush && FAILED(m_target->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), m_labelBrush.GetAddressOf())))
+        return false;
+
+    // FillOpacityMask requires aliased mode, which is already set.
+    labels.ForEachGlyph([&](int32_t x, int32_t y, uint8_t slot, uint32_t color)
+    {
+        m_labelBrush->SetColor(D2D1::ColorF(color));
+        const FLOAT left = FLOAT(slot * atlas->slot_cx);
+        m_target->FillOpacityMask(m_atlas.Get(), m_labelBrush.Get(), D2D1_OPACITY_MASK_CONTENT_TEXT_GRAYSCALE,
+                                  D2D1::RectF(FLOAT(x), FLOAT(y), FLOAT(x + atlas->slot_cx), FLOAT(y + atlas->slot_cy)),
+                                  D2D1::RectF(left, 0, left + atlas->slot_cx, FLOAT(atlas->slot_cy)));
+    });
+    return true;
+}
+
+void D2DRenderer::DiscardDeviceResources()
+{
+    m_atlas.Reset();
+    m_labelBrush.Reset();
+    m_brush.Reset();
+    m_bitmap.Reset();
+    m_target.Reset();
+    m_bitmapSize = {};
+}
+
+bool D2DRenderer::Render(const RenderTarget& target, const PixelSource& source, const ScaleParams& params, PixelLabels* labels)
+{
+    // Direct2D does the scaling, so in diff mode upload the unscaled
+    // difference image instead of the source.
+    PixelSource src = source;
+    if (params.diff)
+    {
+        m_diff.resize(size_t(source.cx) * source.cy);
+        PixelTarget diff;
+        diff.bits = m_diff.data();
+        diff.stride = source.cx;
+        diff.cx = source.cx;
+        diff.cy = source.cy;
+
+        DiffResult result;
+        DiffImage(source, *params.diff, diff, result);
+        if (params.diff->result)
+            *params.diff->result = result;
+
+        src.bits = m_diff.data();
+        src.stride = source.cx;
+        if (labels)
+            labels->UpdateContrast(src);
+    }
+
+    // Likewise, in subpixel mode upload the stripes at three times the width;
+    // nearest neighbor scaling then makes each stripe a third of a pixel.
+    PixelSource image = src;
+    if (UsesSubpixels(params))
+    {
+        m_stripes.resize(size_t(src.cx) * 3 * src.cy);
+        for (int32_t yy = 0; yy < src.cy; ++yy)
+            SplitSubpixelRow(src.bits + yy * src.stride, src.cx, params.subpixels, &m_stripes[size_t(yy) * 3 * src.cx]);
+
+        image.bits = m_stripes.data();
+        image.stride = 3 * src.cx;
+        image.cx = 3 * src.cx;
+    }
+
+    if (!EnsureTarget(target) || !EnsureBitmap(image))
+        return false;
+
+    bool gridlines = false;
+    for (const auto& grid : params.gridlines)
+        gridlines |= (grid.interval > 0);
+
+    if (gridlines)
+    {
+        // DIB pixels are 0x00RRGGBB, the same as ColorF expects.
+        if (!m_brush && FAILED(m_target->CreateSolidColorBrush(D2D1::ColorF(params.gridline_color), m_brush.GetAddressOf())))
+            return false;
+        m_brush->SetColor(D2D1::ColorF(params.gridline_color));
+        if (!EnsureGridlines(target, src, params))
+            return false;
+    }
+
+    const FLOAT cx = FLOAT(src.cx * params.factor);
+    const FLOAT cy = FLOAT(src.cy * params.factor);
+
+    m_target->BeginDraw();
+    m_target->SetTransform(D2D1::Matrix3x2F::Identity());
+    m_target->PushAxisAlignedClip(D2D1::RectF(0, 0, FLOAT(target.cx), FLOAT(target.cy)), D2D1_ANTIALIAS_MODE_ALIASED);
+    m_target->Clear(D2D1::ColorF(D2D1::ColorF::Black));
+    m_target->DrawBitmap(m_bitmap.Get(), D2D1::RectF(0, 0, cx, cy), 1.0f, D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR,
+                         D2D1::RectF(0, 0, FLOAT(image.cx), FLOAT(image.cy)));
+    if (gridlines)
+        m_target->FillGeometry(m_gridlines.Get(), m_brush.Get());
+    const bool ok = (!labels || !labels->IsVisible() || DrawLabels(*labels));
+    m_target->PopAxisAlignedClip();
+    if (!ok)
+    {
+        m_target->EndDraw();
+        return false;
+    }
+
+    const HRESULT hr = m_target->EndDraw();
+    if (hr == D2DERR_RECREATE_TARGET)
+    {
+        // The device was lost; recreate everything on the next paint.
+        DiscardDeviceResources();
+        InvalidateRect(target.hwnd, nullptr, false);
+        return true;
+    }
+
+    return SUCCEEDED(hr);
+}
+
+//------------------------------------------------------------------------------
+// CreateRenderer.
+
+std::unique_ptr<Renderer> CreateRenderer(RendererKind kind)
+{
+    switch (kind)
+    {
+    case RK_DIRECT2D:
+        return std::make_unique<D2DRenderer>();
+    case RK_SOFTWARE:
+        return std::make_unique<DibRenderer>(true);
+    default:
+        return std::make_unique<DibRenderer>(false);
+    }
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <memory>
+
+#include "scaler.h"
+
+class PixelLabels;
+
+//------------------------------------------------------------------------------
+// Renderers draw the magnified zoom area into the main window.
+//
+//  - GDI scales into a DIB section with the tiled SIMD scaler and BitBlts it.
+//  - Direct2D draws the captured pixels as a bitmap with nearest neighbor
+//    interpolation, and fills the gridlines from a cached geometry.  It uses
+//    the software rasterizer when there's no usable GPU.
+//  - Software reference scales with ScaleReference and BitBlts the result; it
+//    matches what --capture writes with --reference, for comparing output.
+//
+// In diff mode (params.diff), each shows the difference image instead of the
+// source, and fills in the diff result.  In subpixel mode (params.subpixels),
+// each shows the red, green, and blue stripes of each pixel.
+
+enum RendererKind
+{
+    RK_GDI,
+    RK_DIRECT2D,
+    RK_SOFTWARE,
+    RK_COUNT
+};
+
+struct RenderTarget
+{
+    HWND            hwnd = NULL;
+    HDC             hdc = NULL;         // May be NULL outside of WM_PAINT.
+    HPALETTE        hpal = NULL;
+    LONG            cx = 0;             // The zoom area, at the top left of
+    LONG            cy = 0;             // the client area.
+};
+
+class Renderer
+{
+public:
+    Renderer() = default;
+    virtual ~Renderer() = default;
+    virtual RendererKind GetKind() const = 0;
+    virtual const WCHAR* GetName() const = 0;
+    // Allocates size dependent resources ahead of the first Render.
+    virtual bool Prepare(const RenderTarget& target) = 0;
+    // Draws labels (if not null) over the magnified pixels; in diff mode their
+    // contrast is re-picked from the difference image.  Returns false if the
+    // renderer is unusable, e.g. its device can't be created; the caller
+    // should fall back to another renderer.
+    virtual bool Render(const RenderTarget& target, const PixelSource& src, const ScaleParams& params, PixelLabels* labels) = 0;
+};
+
+std::unique_ptr<Renderer> CreateRenderer(RendererKind kind);
+const WCHAR* GetRendererName(RendererKind kind);
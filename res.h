@@ -8,6 +8,7 @@
 
 // Menus.
 #define IDR_MENU                1000
+#define IDR_TRAYMENU            1001
 
 // Accelerators.
 #define IDR_ACCEL               1100
@@ -26,6 +27,41 @@
 #define IDM_ZOOM_OUT            2006
 #define IDM_ZOOM_IN             2007
 #define IDM_FLASH_BORDER        2008
+#define IDM_HELP_STATISTICS     2009
+#define IDM_TRAY_SHOW           2010
+#define IDM_TRAY_EXIT           2011
+#define IDM_RENDERER_GDI        2012    // Must be in RendererKind order.
+#define IDM_RENDERER_DIRECT2D   2013
+#define IDM_RENDERER_SOFTWARE   2014
+#define IDM_OPTIONS_LABELS      2015
+#define IDM_OPTIONS_LABELS_HEX  2016
+#define IDM_OPTIONS_INSPECTOR   2017
+#define IDM_OPTIONS_REGIONSTATS 2018
+#define IDM_EDIT_BASELINE       2019
+#define IDM_OPTIONS_DIFF        2020
+#define IDM_OPTIONS_DIFF_HEATMAP 2021
+#define IDM_OPTIONS_FLICKER     2022
+#define IDM_EDIT_ADDPROBE       2023
+#define IDM_EDIT_CLEARPROBES    2024
+#define IDM_OPTIONS_TIMELINE    2025
+#define IDM_EDIT_CADENCE        2026
+#define IDM_SEARCH_ZOOMAREA     2027
+#define IDM_SEARCH_CLIPBOARD    2028
+#define IDM_SEARCH_FILE         2029
+#define IDM_SEARCH_NEXT         2030
+#define IDM_SEARCH_PREVIOUS     2031
+#define IDM_SEARCH_TOLERANT     2032
+#define IDM_OPTIONS_RULER       2033
+#define IDM_OPTIONS_ELEMENTS    2034
+#define IDM_OVERLAY_LOAD        2035
+#define IDM_OVERLAY_SHOW        2036
+#define IDM_OVERLAY_MORE_OPAQUE 2037
+#define IDM_OVERLAY_LESS_OPAQUE 2038
+#define IDM_OVERLAY_RESET       2039
+#define IDM_OPTIONS_FILTERS     2040
+#define IDM_SUBPIXELS_OFF       2041    // Must be in SubpixelOrder order.
+#define IDM_SUBPIXELS_RGB       2042
+#define IDM_SUBPIXELS_BGR       2043
 
 // Controls.
 #define IDC_ENABLE_REFRESH      3000
@@ -44,4 +80,19 @@
 #define IDC_RETICLE_SAMPLE      3013
 #define IDC_OUTLINE_SAMPLE      3014
 #define IDC_RETICLE_OPACITY     3015
+#define IDC_ENABLE_ADAPTIVE     3016
+#define IDC_ADAPTIVE_MIN_RATE   3017
+#define IDC_ADAPTIVE_MAX_RATE   3018
+#define IDC_RESIDENT            3019
+#define IDC_HOTKEY              3020
+#define IDC_FILTER_KIND1        3021
+#define IDC_FILTER_KIND2        3022
+#define IDC_FILTER_KIND3        3023
+#define IDC_FILTER_KIND4        3024
+#define IDC_FILTER_KIND5        3025
+#define IDC_FILTER_PARAM1       3026
+#define IDC_FILTER_PARAM2       3027
+#define IDC_FILTER_PARAM3       3028
+#define IDC_FILTER_PARAM4       3029
+#define IDC_FILTER_PARAM5       3030
 
@@ -19,6 +19,8 @@
 
 #include "reticle.h"
 #include "dpi.h"
+#include "delayload.h"
+#include "moncache.h"
 #include "assert.h"
 #include "res.h"
 
@@ -115,14 +117,8 @@ static constexpr WCHAR c_windowTitle[] = L"Zoomin Reticle";
 ZoomReticleImpl* ZoomReticleImpl::s_instance = nullptr;
 
 #ifdef COMPOSITION
-union CM_CDQC
-{
-    FARPROC proc;
-    HRESULT (WINAPI* CreateDispatcherQueueController)(DispatcherQueueOptions options, PDISPATCHERQUEUECONTROLLER* dispatcherQueueController);
-};
-
-static const HMODULE s_hlib = LoadLibrary(L"CoreMessaging.dll");
-static const CM_CDQC s_proc = { s_hlib ? GetProcAddress(s_hlib, "CreateDispatcherQueueController") : nullptr };
+typedef HRESULT (WINAPI* CreateDispatcherQueueController_t)(DispatcherQueueOptions options, PDISPATCHERQUEUECONTROLLER* dispatcherQueueController);
+static DelayProc<CreateDispatcherQueueController_t> s_CreateDispatcherQueueController { L"CoreMessaging.dll", "CreateDispatcherQueueController" };
 #endif
 
 static bool EnsureWindowClass(HINSTANCE hinst, const WCHAR* name, WNDPROC wndproc)
@@ -159,7 +155,7 @@ ZoomReticleImpl::ZoomReticleImpl(HINSTANCE hinst, LONG cx, LONG cy, const ZoomRe
 
 #ifdef COMPOSITION
     // Next check if composition can be used.
-    if (s_proc.proc)
+    if (s_CreateDispatcherQueueController.Get())
     {
 // TODO:  PROBLEMS...
 //  1.  OnMouseMove cannot wait for render to finish before PaintZoomRect.
@@ -285,8 +281,9 @@ bool ZoomReticleImpl::InitReticle()
                     DQTAT_COM_ASTA,
                 };
                 ABI::IDispatcherQueueController* controller;
-                assert(s_proc.CreateDispatcherQueueController);
-                winrt::check_hresult(s_proc.CreateDispatcherQueueController(options, &controller));
+                const auto CreateDispatcherQueueController = s_CreateDispatcherQueueController.Get();
+                assert(CreateDispatcherQueueController);
+                winrt::check_hresult(CreateDispatcherQueueController(options, &controller));
                 *winrt::put_abi(m_dispatcherQueueController) = controller;
 
                 // Create the compositor for our window.
@@ -398,10 +395,10 @@ void ZoomReticleImpl::UpdateReticlePosition(const POINT& ptScreen)
 
             m_pt = ptScreen;
 
-            const HMONITOR cursorMonitor = MonitorFromPoint(m_pt, MONITOR_DEFAULTTONEAREST);
-            if (cursorMonitor)
+            CachedMonitorInfo info;
+            if (GetCachedMonitorInfo(m_pt, info))
             {
-                const DpiScaler dpi(__GetDpiForMonitor(cursorMonitor));
+                const DpiScaler dpi(info.dpi);
                 m_thick = dpi.Scale(1);
             }
 
@@ -414,9 +411,9 @@ void ZoomReticleImpl::UpdateReticlePosition(const POINT& ptScreen)
             m_pt = ptScreen;
 
             m_monitorDpi = 96;
-            const HMONITOR cursorMonitor = MonitorFromPoint(m_pt, MONITOR_DEFAULTTONEAREST);
-            if (cursorMonitor)
-                m_monitorDpi = __GetDpiForMonitor(cursorMonitor);
+            CachedMonitorInfo info;
+            if (GetCachedMonitorInfo(m_pt, info))
+                m_monitorDpi = info.dpi;
 
             DpiScaler dpi(m_monitorDpi);
             const LONG border_thickness = dpi.Scale(m_settings.m_borderThickness);
@@ -456,16 +453,11 @@ void ZoomReticleImpl::UpdateReticlePosition(const POINT& ptScreen)
             // HACK: Draw with 1 pixel off. Otherwise Windows glitches the task bar transparency when a transparent window fill the whole screen.
             SetWindowPos(m_hwnd, HWND_TOPMOST, GetSystemMetrics(SM_XVIRTUALSCREEN) + 1, GetSystemMetrics(SM_YVIRTUALSCREEN) + 1, GetSystemMetrics(SM_CXVIRTUALSCREEN) - 2, GetSystemMetrics(SM_CYVIRTUALSCREEN) - 2, 0);
 
-            const HMONITOR cursorMonitor = MonitorFromPoint(m_pt, MONITOR_DEFAULTTONEAREST);
-            if (cursorMonitor == NULL)
-                return;
-
-            MONITORINFO monitorInfo;
-            monitorInfo.cbSize = sizeof(monitorInfo);
-            if (!GetMonitorInfo(cursorMonitor, &monitorInfo))
+            CachedMonitorInfo monitorInfo;
+            if (!GetCachedMonitorInfo(m_pt, monitorInfo))
                 return;
 
-            const DpiScaler dpi(__GetDpiForMonitor(cursorMonitor));
+            const DpiScaler dpi(monitorInfo.dpi);
 
             POINT ptMonitorUpperLeft;
             ptMonitorUpperLeft.x = monitorInfo.rcMonitor.left;
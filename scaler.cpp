@@ -0,0 +1,364 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <string.h>
+#include <assert.h>
+#include <algorithm>
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "scaler.h"
+#include "threadpool.h"
+
+// Targets smaller than this are scaled on the calling thread; waking the
+// workers would cost more than it saves.
+constexpr int32_t c_min_tiled_pixels = 640 * 480;
+constexpr int32_t c_band_height = 64;
+
+static void FillRow(uint32_t* out, int32_t cx, uint32_t color)
+{
+    int32_t xx = 0;
+#ifdef USE_SSE2
+    const __m128i v = _mm_set1_epi32(int(color));
+    for (; xx + 4 <= cx; xx += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + xx), v);
+#endif
+    for (; xx < cx; ++xx)
+        out[xx] = color;
+}
+
+static void ReplicateRow(const uint32_t* src, int32_t cx_src, int32_t factor, uint32_t* out, int32_t cx_dst)
+{
+    const int32_t whole = std::min<int32_t>(cx_src, cx_dst / factor);
+    uint32_t* const end = out + cx_dst;
+
+    if (factor == 1)
+    {
+        memcpy(out, src, whole * sizeof(*out));
+        out += whole;
+    }
+#ifdef USE_SSE2
+    else if (factor == 2)
+    {
+        int32_t xx = 0;
+        for (; xx + 4 <= whole; xx += 4)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + xx));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi32(v, v));
+            out += 8;
+        }
+        for (; xx < whole; ++xx)
+        {
+            out[0] = out[1] = src[xx];
+            out += 2;
+        }
+    }
+    else if (factor >= 4)
+    {
+        for (int32_t xx = 0; xx < whole; ++xx)
+        {
+            const __m128i v = _mm_set1_epi32(int(src[xx]));
+            for (int32_t jj = 0; jj + 4 <= factor; jj += 4)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + jj), v);
+            // Finish with an overlapping store instead of a scalar tail.
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + factor - 4), v);
+            out += factor;
+        }
+    }
+#endif
+    else
+    {
+        for (int32_t xx = 0; xx < whole; ++xx)
+        {
+            const uint32_t pixel = src[xx];
+            for (int32_t jj = 0; jj < factor; ++jj)
+                out[jj] = pixel;
+            out += factor;
+        }
+    }
+
+    // A partially visible last pixel, and anything beyond the source.
+    if (out < end && whole < cx_src)
+    {
+        const uint32_t pixel = src[whole];
+        while (out < end && factor--)
+            *(out++) = pixel;
+    }
+    if (out < end)
+        FillRow(out, int32_t(end - out), 0);
+}
+
+// The channel shown by each of a pixel's three stripes.
+static const uint32_t c_stripe_masks[SO_COUNT][3] =
+{
+    { 0xffffffff, 0xffffffff, 0xffffffff },
+    { 0x00ff0000, 0x0000ff00, 0x000000ff },
+    { 0x000000ff, 0x0000ff00, 0x00ff0000 },
+};
+
+bool UsesSubpixels(const ScaleParams& params)
+{
+    return params.subpixels > SO_NONE && params.subpixels < SO_COUNT && params.factor % 3 == 0;
+}
+
+void SplitSubpixelRow(const uint32_t* src, int32_t count, SubpixelOrder order, uint32_t* out)
+{
+    const uint32_t* const masks = c_stripe_masks[order];
+
+    int32_t xx = 0;
+#ifdef USE_SSE2
+    // Four pixels make three registers of stripes:  0 0 0 1, 1 1 2 2, 2 3 3 3.
+    const __m128i mask0 = _mm_setr_epi32(int(masks[0]), int(masks[1]), int(masks[2]), int(masks[0]));
+    const __m128i mask1 = _mm_setr_epi32(int(masks[1]), int(masks[2]), int(masks[0]), int(masks[1]));
+    const __m128i mask2 = _mm_setr_epi32(int(masks[2]), int(masks[0]), int(masks[1]), int(masks[2]));
+    for (; xx + 4 <= count; xx += 4)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + xx));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_and_si128(_mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 0, 0)), mask0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_and_si128(_mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 1, 1)), mask1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_and_si128(_mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 2)), mask2));
+        out += 12;
+    }
+#endif
+    for (; xx < count; ++xx)
+    {
+        const uint32_t pixel = src[xx];
+        out[0] = pixel & masks[0];
+        out[1] = pixel & masks[1];
+        out[2] = pixel & masks[2];
+        out += 3;
+    }
+}
+
+static bool IsGridlineRow(const ScaleParams& params, int32_t yy)
+{
+    for (const auto& grid : params.gridlines)
+    {
+        if (grid.interval > 0 && (yy + grid.thick / 2) % grid.interval < grid.thick)
+            return true;
+    }
+    return false;
+}
+
+static bool IsGridlineColumn(const ScaleParams& params, int32_t xx)
+{
+    // Same as rows:  lines are centered on multiples of the interval.
+    return IsGridlineRow(params, xx);
+}
+
+static void DrawGridlineColumns(const ScaleParams& params, uint32_t* out, int32_t cx)
+{
+    for (const auto& grid : params.gridlines)
+    {
+        if (grid.interval <= 0)
+            continue;
+
+        // Lines are centered on multiples of the interval, like a GDI pen.
+        for (int32_t xx = 0; xx - grid.thick / 2 < cx; xx += grid.interval)
+        {
+            const int32_t left = std::max<int32_t>(0, xx - grid.thick / 2);
+            const int32_t right = std::min<int32_t>(cx, xx - grid.thick / 2 + grid.thick);
+            for (int32_t ii = left; ii < right; ++ii)
+                out[ii] = params.gridline_color;
+        }
+    }
+}
+
+void SetGridlines(ScaleParams& params, int32_t minor_spacing, int32_t major_spacing)
+{
+    const int32_t spacing[] = { minor_spacing, major_spacing };
+    static_assert(sizeof(spacing) / sizeof(spacing[0]) == sizeof(params.gridlines) / sizeof(params.gridlines[0]), "array size mismatch");
+
+    for (size_t ii = 0; ii < sizeof(spacing) / sizeof(spacing[0]); ++ii)
+    {
+        const int32_t thick = !ii ? 0 : (minor_spacing > 0 ? 2 : 0);
+        params.gridlines[ii] = GridlineSpec();
+        if (spacing[ii] > 0 && params.factor > (thick ? 2 : 1))
+        {
+            params.gridlines[ii].interval = params.factor * spacing[ii];
+            params.gridlines[ii].thick = std::max<int32_t>(thick, 1);
+        }
+    }
+}
+
+static void ScaleBand(const PixelSource& src, const PixelTarget& dst, const ScaleParams& params, int32_t y_begin, int32_t y_end, DiffResult& result)
+{
+    assert(params.factor >= 1);
+
+    const int32_t factor = params.factor;
+    const uint32_t* prev = nullptr;
+    int32_t prev_sy = -1;
+
+    // Diff mode compares each source row once, even if all of its target rows
+    // are gridlines, so the count covers every visible source pixel.
+    // Bands are aligned to the factor, so each row of the (optional) unscaled
+    // difference image is written by only one band.
+    std::vector<uint32_t> diff_row;
+    const uint32_t* diff_line = nullptr;
+    int32_t diff_sy = -1;
+    if (params.diff && !params.diff->image.bits)
+        diff_row.resize(std::max<int32_t>(src.cx, 0));
+
+    // Subpixel mode splits each row into stripes, then replicates the stripes.
+    const bool subpixels = UsesSubpixels(params);
+    std::vector<uint32_t> stripes;
+    if (subpixels)
+        stripes.resize(3 * std::max<int32_t>(src.cx, 0));
+
+    y_end = std::min<int32_t>(y_end, dst.cy);
+    for (int32_t yy = y_begin; yy < y_end; ++yy)
+    {
+        uint32_t* const out = dst.bits + yy * dst.stride;
+
+        if (params.diff && yy / factor != diff_sy && yy / factor < src.cy)
+        {
+            diff_sy = yy / factor;
+            int32_t first = 0;
+            int32_t last = 0;
+            const PixelSource& baseline = params.diff->baseline;
+            const PixelTarget& image = params.diff->image;
+            uint32_t* const diff_out = image.bits ? image.bits + diff_sy * image.stride : diff_row.data();
+            const uint32_t count = DiffRow(src.bits + diff_sy * src.stride, baseline.bits + diff_sy * baseline.stride, src.cx,
+                                           *params.diff, diff_out, first, last);
+            result.AddRow(diff_sy, count, first, last);
+            diff_line = diff_out;
+        }
+
+        if (IsGridlineRow(params, yy))
+        {
+            FillRow(out, dst.cx, params.gridline_color);
+            continue;
+        }
+
+        // Rows scaled from the same source row are identical (gridline rows
+        // are handled above), so copy the previous row when possible.
+        const int32_t sy = yy / factor;
+        if (sy == prev_sy)
+        {
+            memcpy(out, prev, dst.cx * sizeof(*out));
+            continue;
+        }
+
+        if (sy >= src.cy)
+        {
+            FillRow(out, dst.cx, 0);
+            prev = nullptr;
+            prev_sy = -1;
+            continue;
+        }
+
+        const uint32_t* const row = params.diff ? diff_line : src.bits + sy * src.stride;
+        if (subpixels)
+        {
+            SplitSubpixelRow(row, src.cx, params.subpixels, stripes.data());
+            ReplicateRow(stripes.data(), 3 * src.cx, factor / 3, out, dst.cx);
+        }
+        else
+        {
+            ReplicateRow(row, src.cx, factor, out, dst.cx);
+        }
+        DrawGridlineColumns(params, out, dst.cx);
+        prev = out;
+        prev_sy = sy;
+    }
+}
+
+void ScaleRows(const PixelSource& src, const PixelTarget& dst, const ScaleParams& params, int32_t y_begin, int32_t y_end)
+{
+    DiffResult result;
+    ScaleBand(src, dst, params, y_begin, y_end, result);
+    if (params.diff && params.diff->result)
+        *params.diff->result = result;
+}
+
+void ScaleTiled(ThreadPool* pool, const PixelSource& src, const PixelTarget& dst, const ScaleParams& params, unsigned max_threads)
+{
+    if (!pool || max_threads == 1 || pool->GetThreadCount() <= 1 || dst.cx * dst.cy < c_min_tiled_pixels)
+    {
+        ScaleRows(src, dst, params, 0, dst.cy);
+        return;
+    }
+
+    // Align bands to the zoom factor so each band can copy replicated rows
+    // instead of rescaling them.
+    const int32_t band = std::max<int32_t>(params.factor, c_band_height / params.factor * params.factor);
+    const unsigned count = unsigned((dst.cy + band - 1) / band);
+
+    std::vector<DiffResult> results(params.diff ? count : 0);
+    pool->Run(count, [&](unsigned index)
+    {
+        const int32_t top = int32_t(index) * band;
+        DiffResult unused;
+        ScaleBand(src, dst, params, top, top + band, params.diff ? results[index] : unused);
+    }, max_threads);
+
+    if (params.diff && params.diff->result)
+    {
+        DiffResult result;
+        for (const auto& band_result : results)
+            result.Merge(band_result);
+        *params.diff->result = result;
+    }
+}
+
+void ScaleReference(const PixelSource& src, const PixelTarget& dst, const ScaleParams& params)
+{
+    assert(params.factor >= 1);
+
+    const DiffParams* const diff = params.diff;
+    if (diff && diff->result)
+    {
+        // Every source row with a visible target row.
+        DiffResult result;
+        for (int32_t sy = 0; sy < src.cy && sy * params.factor < dst.cy; ++sy)
+        {
+            for (int32_t sx = 0; sx < src.cx; ++sx)
+            {
+                if ((src.bits[sy * src.stride + sx] ^ diff->baseline.bits[sy * diff->baseline.stride + sx]) & 0x00ffffff)
+                    result.AddRow(sy, 1, sx, sx);
+            }
+        }
+        *diff->result = result;
+    }
+    if (diff && diff->image.bits)
+    {
+        for (int32_t sy = 0; sy < src.cy && sy * params.factor < dst.cy; ++sy)
+        {
+            for (int32_t sx = 0; sx < src.cx; ++sx)
+                diff->image.bits[sy * diff->image.stride + sx] = DiffPixel(src.bits[sy * src.stride + sx], diff->baseline.bits[sy * diff->baseline.stride + sx], *diff);
+        }
+    }
+
+    const bool subpixels = UsesSubpixels(params);
+    const uint32_t* const masks = c_stripe_masks[subpixels ? params.subpixels : SO_NONE];
+    const int32_t stripe = subpixels ? params.factor / 3 : params.factor;
+
+    for (int32_t yy = 0; yy < dst.cy; ++yy)
+    {
+        uint32_t* const out = dst.bits + yy * dst.stride;
+        const bool grid_row = IsGridlineRow(params, yy);
+        const int32_t sy = yy / params.factor;
+
+        for (int32_t xx = 0; xx < dst.cx; ++xx)
+        {
+            const int32_t sx = xx / params.factor;
+            if (grid_row)
+                out[xx] = params.gridline_color;
+            else if (sy >= src.cy)
+                out[xx] = 0;
+            else if (IsGridlineColumn(params, xx))
+                out[xx] = params.gridline_color;
+            else if (sx >= src.cx)
+                out[xx] = 0;
+            else if (diff)
+                out[xx] = DiffPixel(src.bits[sy * src.stride + sx], diff->baseline.bits[sy * diff->baseline.stride + sx], *diff) & masks[xx % params.factor / stripe];
+            else
+                out[xx] = src.bits[sy * src.stride + sx] & masks[xx % params.factor / stripe];
+        }
+    }
+}
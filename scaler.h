@@ -0,0 +1,71 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include "diff.h"
+#include "pixels.h"
+
+class ThreadPool;
+
+//------------------------------------------------------------------------------
+// Pixel scaler.
+//
+// Scales 32bpp source pixels by an integer factor (nearest neighbor) into a
+// 32bpp target, and draws gridlines, in a single pass per row.  The target can
+// be split into horizontal bands which are processed in parallel.  In diff
+// mode each source row is replaced by its difference from the baseline on the
+// way through.
+//
+// In subpixel mode each source pixel becomes three vertical stripes holding
+// only its red, green, or blue channel, like the subpixels of an LCD, for
+// inspecting ClearType.  That needs a factor that's a multiple of 3; the
+// stripes are replicated by the same code as whole pixels, and gridlines stay
+// on whole pixel boundaries.
+//
+// tests/scaler_test.cpp checks ScaleTiled against ScaleReference.
+
+struct GridlineSpec
+{
+    int32_t         interval = 0;       // In target pixels; 0 means no gridlines.
+    int32_t         thick = 1;          // In target pixels.
+};
+
+enum SubpixelOrder
+{
+    SO_NONE,
+    SO_RGB,
+    SO_BGR,
+    SO_COUNT
+};
+
+struct ScaleParams
+{
+    int32_t         factor = 1;
+    uint32_t        gridline_color = 0;
+    GridlineSpec    gridlines[2];
+    const DiffParams* diff = nullptr;   // Scales the difference image instead, if not null.
+    SubpixelOrder   subpixels = SO_NONE; // Ignored unless the factor is a multiple of 3.
+};
+
+bool UsesSubpixels(const ScaleParams& params);
+
+// Splits each of count pixels into three, holding only its red, green, and
+// blue channels in the given order.  Writes 3 * count pixels to out.
+void SplitSubpixelRow(const uint32_t* src, int32_t count, SubpixelOrder order, uint32_t* out);
+
+// Sets up minor and major gridlines every so many source pixels (0 for none),
+// for params.factor.  Major gridlines are thicker when minor gridlines are
+// shown too, and gridlines are omitted when the factor is too small for them
+// to leave any pixels visible.
+void SetGridlines(ScaleParams& params, int32_t minor_spacing, int32_t major_spacing);
+
+// In diff mode, y_begin should be a multiple of the factor, so that each source
+// row is compared once.
+void ScaleRows(const PixelSource& src, const PixelTarget& dst, const ScaleParams& params, int32_t y_begin, int32_t y_end);
+void ScaleTiled(ThreadPool* pool, const PixelSource& src, const PixelTarget& dst, const ScaleParams& params, unsigned max_threads=0);
+
+// Computes each target pixel independently, with no SIMD, row copying, or
+// threads.  This is the reference the optimized scaler and the other renderers
+// are checked against; it produces identical output, only slower.
+void ScaleReference(const PixelSource& src, const PixelTarget& dst, const ScaleParams& params);
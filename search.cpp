@@ -0,0 +1,255 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <algorithm>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+#include "search.h"
+#include "threadpool.h"
+
+constexpr uint32_t c_rgb_mask = 0x00ffffff;
+constexpr uint64_t c_hash_base = 0x100000001b3ull;
+constexpr int32_t c_band_height = 32;
+
+static bool MatchPixel(uint32_t a, uint32_t b, uint8_t tolerance)
+{
+    for (uint32_t shift = 0; shift < 24; shift += 8)
+    {
+        const int32_t d = int32_t((a >> shift) & 0xff) - int32_t((b >> shift) & 0xff);
+        if (d > tolerance || -d > tolerance)
+            return false;
+    }
+    return true;
+}
+
+static bool MatchRow(const uint32_t* a, const uint32_t* b, int32_t cx, uint8_t tolerance)
+{
+    int32_t xx = 0;
+#ifdef USE_SSE2
+    const __m128i rgb = _mm_set1_epi32(int(c_rgb_mask));
+    const __m128i tol = _mm_set1_epi8(char(tolerance));
+    const __m128i zero = _mm_setzero_si128();
+    for (; xx + 4 <= cx; xx += 4)
+    {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + xx));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + xx));
+        const __m128i d = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)), rgb);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(d, tol), zero)) != 0xffff)
+            return false;
+    }
+#endif
+    for (; xx < cx; ++xx)
+    {
+        if (!MatchPixel(a[xx], b[xx], tolerance))
+            return false;
+    }
+    return true;
+}
+
+// The anchor row is checked first; it's the row most likely to differ.
+static bool MatchAt(const PixelSource& haystack, const PixelSource& needle, int32_t x, int32_t y, uint8_t tolerance, int32_t anchor_row)
+{
+    const uint32_t* const origin = haystack.bits + y * haystack.stride + x;
+    if (!MatchRow(origin + anchor_row * haystack.stride, needle.bits + anchor_row * needle.stride, needle.cx, tolerance))
+        return false;
+
+    for (int32_t yy = 0; yy < needle.cy; ++yy)
+    {
+        if (yy != anchor_row && !MatchRow(origin + yy * haystack.stride, needle.bits + yy * needle.stride, needle.cx, tolerance))
+            return false;
+    }
+    return true;
+}
+
+// The row with the most color changes, and the first pixel after a change.
+static int32_t PickAnchor(const PixelSource& needle, int32_t& anchor_x)
+{
+    int32_t best_row = 0;
+    int32_t best_changes = -1;
+    anchor_x = 0;
+    for (int32_t yy = 0; yy < needle.cy; ++yy)
+    {
+        const uint32_t* const row = needle.bits + yy * needle.stride;
+        int32_t changes = 0;
+        int32_t first = 0;
+        for (int32_t xx = 1; xx < needle.cx; ++xx)
+        {
+            if ((row[xx] ^ row[xx - 1]) & c_rgb_mask)
+            {
+                if (!changes)
+                    first = xx;
+                ++changes;
+            }
+        }
+        if (changes > best_changes)
+        {
+            best_row = yy;
+            best_changes = changes;
+            anchor_x = first;
+        }
+    }
+    return best_row;
+}
+
+static uint64_t HashRow(const uint32_t* row, int32_t cx)
+{
+    uint64_t hash = 0;
+    for (int32_t xx = 0; xx < cx; ++xx)
+        hash = hash * c_hash_base + (row[xx] & c_rgb_mask);
+    return hash;
+}
+
+static void SearchExact(const PixelSource& haystack, const PixelSource& needle, int32_t anchor_row,
+                        int32_t y_begin, int32_t y_end, size_t max_matches, std::vector<SearchMatch>& matches)
+{
+    const int32_t cx = needle.cx;
+    const int32_t last_x = haystack.cx - cx;
+    const uint64_t target = HashRow(needle.bits + anchor_row * needle.stride, cx);
+
+    // c_hash_base ^ (cx - 1), to remove the outgoing pixel.
+    uint64_t outgoing = 1;
+    for (int32_t ii = 1; ii < cx; ++ii)
+        outgoing *= c_hash_base;
+
+    for (int32_t yy = y_begin; yy < y_end; ++yy)
+    {
+        const uint32_t* const row = haystack.bits + (yy + anchor_row) * haystack.stride;
+        uint64_t hash = HashRow(row, cx);
+        for (int32_t xx = 0;; ++xx)
+        {
+            if (hash == target && MatchAt(haystack, needle, xx, yy, 0, anchor_row))
+            {
+                matches.push_back({ xx, yy });
+                if (matches.size() >= max_matches)
+                    return;
+            }
+            if (xx >= last_x)
+                break;
+            hash = (hash - (row[xx] & c_rgb_mask) * outgoing) * c_hash_base + (row[xx + cx] & c_rgb_mask);
+        }
+    }
+}
+
+static void SearchApproximate(const PixelSource& haystack, const PixelSource& needle, int32_t anchor_row, int32_t anchor_x,
+                              uint8_t tolerance, int32_t y_begin, int32_t y_end, size_t max_matches, std::vector<SearchMatch>& matches)
+{
+    const int32_t candidates = haystack.cx - needle.cx + 1;
+    const uint32_t anchor = needle.bits[anchor_row * needle.stride + anchor_x];
+
+    auto check = [&](int32_t xx, int32_t yy)
+    {
+        if (!MatchAt(haystack, needle, xx, yy, tolerance, anchor_row))
+            return false;
+        matches.push_back({ xx, yy });
+        return matches.size() >= max_matches;
+    };
+
+#ifdef USE_SSE2
+    const __m128i rgb = _mm_set1_epi32(int(c_rgb_mask));
+    const __m128i tol = _mm_set1_epi8(char(tolerance));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_set1_epi32(int(anchor));
+#endif
+
+    for (int32_t yy = y_begin; yy < y_end; ++yy)
+    {
+        // Candidate x has its anchor pixel at row[x].
+        const uint32_t* const row = haystack.bits + (yy + anchor_row) * haystack.stride + anchor_x;
+        int32_t xx = 0;
+#ifdef USE_SSE2
+        for (; xx + 4 <= candidates; xx += 4)
+        {
+            const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + xx));
+            const __m128i d = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)), rgb);
+            const __m128i ok = _mm_cmpeq_epi32(_mm_subs_epu8(d, tol), zero);
+            const int mask = _mm_movemask_ps(_mm_castsi128_ps(ok));
+            if (!mask)
+                continue;
+            for (int32_t jj = 0; jj < 4; ++jj)
+            {
+                if ((mask & (1 << jj)) && check(xx + jj, yy))
+                    return;
+            }
+        }
+#endif
+        for (; xx < candidates; ++xx)
+        {
+            if (MatchPixel(row[xx], anchor, tolerance) && check(xx, yy))
+                return;
+        }
+    }
+}
+
+void FindTemplate(ThreadPool* pool, const PixelSource& haystack, const PixelSource& needle, uint8_t tolerance,
+                  size_t max_matches, std::vector<SearchMatch>& matches)
+{
+    matches.clear();
+    if (needle.cx <= 0 || needle.cy <= 0 || needle.cx > haystack.cx || needle.cy > haystack.cy || !max_matches)
+        return;
+
+    int32_t anchor_x;
+    const int32_t anchor_row = PickAnchor(needle, anchor_x);
+
+    const int32_t rows = haystack.cy - needle.cy + 1;
+    const unsigned count = unsigned((rows + c_band_height - 1) / c_band_height);
+    std::vector<std::vector<SearchMatch>> results(count);
+    auto search = [&](unsigned index)
+    {
+        const int32_t top = int32_t(index) * c_band_height;
+        const int32_t bottom = std::min<int32_t>(rows, top + c_band_height);
+        if (tolerance)
+            SearchApproximate(haystack, needle, anchor_row, anchor_x, tolerance, top, bottom, max_matches, results[index]);
+        else
+            SearchExact(haystack, needle, anchor_row, top, bottom, max_matches, results[index]);
+    };
+
+    if (pool && pool->GetThreadCount() > 1 && count > 1)
+    {
+        pool->Run(count, search);
+    }
+    else
+    {
+        for (unsigned index = 0; index < count; ++index)
+            search(index);
+    }
+
+    // Bands are in order, and so are the matches within each band.
+    for (const auto& band : results)
+    {
+        const size_t take = std::min<size_t>(band.size(), max_matches - matches.size());
+        matches.insert(matches.end(), band.begin(), band.begin() + take);
+        if (matches.size() >= max_matches)
+            break;
+    }
+}
+
+void FindTemplateReference(const PixelSource& haystack, const PixelSource& needle, uint8_t tolerance,
+                           size_t max_matches, std::vector<SearchMatch>& matches)
+{
+    matches.clear();
+    if (needle.cx <= 0 || needle.cy <= 0)
+        return;
+
+    for (int32_t yy = 0; yy + needle.cy <= haystack.cy; ++yy)
+    {
+        for (int32_t xx = 0; xx + needle.cx <= haystack.cx; ++xx)
+        {
+            bool match = true;
+            for (int32_t ny = 0; match && ny < needle.cy; ++ny)
+            {
+                for (int32_t nx = 0; match && nx < needle.cx; ++nx)
+                    match = MatchPixel(haystack.bits[(yy + ny) * haystack.stride + xx + nx], needle.bits[ny * needle.stride + nx], tolerance);
+            }
+            if (match)
+            {
+                matches.push_back({ xx, yy });
+                if (matches.size() >= max_matches)
+                    return;
+            }
+        }
+    }
+}
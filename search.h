@@ -0,0 +1,45 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+#include "pixels.h"
+
+class ThreadPool;
+
+//------------------------------------------------------------------------------
+// Template search.
+//
+// Finds where a small template image appears in a large image (e.g. a whole
+// monitor).  Candidates are pre-filtered on one anchor row of the template,
+// the row with the most color changes, since that's least likely to match by
+// accident:
+//
+//  - Exact matches use a rolling hash of the anchor row, so each image pixel
+//    costs one multiply-add regardless of the template's size.
+//  - Approximate matches compare one anchor pixel at four candidates at a
+//    time with SIMD.
+//
+// Candidates that pass are verified row by row, stopping at the first row
+// that differs.  Bands of rows are searched in parallel.
+//
+// tests/search_test.cpp checks FindTemplate against FindTemplateReference.
+
+struct SearchMatch
+{
+    int32_t         x;                  // Top left of the match.
+    int32_t         y;
+};
+
+// Finds up to max_matches positions where needle matches haystack, in row
+// major order.  A pixel matches when no channel differs by more than
+// tolerance.  The top byte of each pixel is ignored.
+void FindTemplate(ThreadPool* pool, const PixelSource& haystack, const PixelSource& needle, uint8_t tolerance,
+                  size_t max_matches, std::vector<SearchMatch>& matches);
+
+// Brute force, for checking FindTemplate.
+void FindTemplateReference(const PixelSource& haystack, const PixelSource& needle, uint8_t tolerance,
+                           size_t max_matches, std::vector<SearchMatch>& matches);
@@ -0,0 +1,177 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <algorithm>
+
+#include "settings.h"
+
+//------------------------------------------------------------------------------
+// Settings.
+
+static bool LessByName(const SettingsEntry& entry, const wchar_t* name)
+{
+    return wcscmp(entry.name.c_str(), name) < 0;
+}
+
+Settings::Settings(std::unique_ptr<SettingsBackend>&& backend)
+: m_backend(std::move(backend))
+{
+}
+
+bool Settings::Load()
+{
+    m_entries.clear();
+    if (!m_backend)
+        return false;
+
+    const bool ok = m_backend->Load(m_entries);
+
+    // Keep the last of any duplicate names.
+    std::stable_sort(m_entries.begin(), m_entries.end(), [](const SettingsEntry& a, const SettingsEntry& b)
+    {
+        return a.name < b.name;
+    });
+    for (size_t ii = 1; ii < m_entries.size(); ++ii)
+    {
+        if (m_entries[ii].name == m_entries[ii - 1].name)
+            m_entries[ii - 1].name.clear();
+    }
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [](const SettingsEntry& entry)
+    {
+        return entry.name.empty();
+    }), m_entries.end());
+
+    for (auto& entry : m_entries)
+        entry.dirty = false;
+
+    return ok;
+}
+
+bool Settings::Save()
+{
+    if (!IsDirty())
+        return true;
+    if (!m_backend || !m_backend->Save(m_entries))
+        return false;
+
+    for (auto& entry : m_entries)
+        entry.dirty = false;
+    return true;
+}
+
+bool Settings::IsDirty() const
+{
+    for (const auto& entry : m_entries)
+    {
+        if (entry.dirty)
+            return true;
+    }
+    return false;
+}
+
+int32_t Settings::GetLong(const wchar_t* name, int32_t default_value) const
+{
+    const auto it = Find(name);
+    return (it != m_entries.end()) ? it->value : default_value;
+}
+
+void Settings::SetLong(const wchar_t* name, int32_t value)
+{
+    auto it = Find(name);
+    if (it == m_entries.end())
+    {
+        SettingsEntry entry;
+        entry.name = name;
+        entry.value = value;
+        entry.dirty = true;
+        m_entries.insert(std::lower_bound(m_entries.begin(), m_entries.end(), name, LessByName), std::move(entry));
+    }
+    else if (it->value != value)
+    {
+        it->value = value;
+        it->dirty = true;
+    }
+}
+
+std::vector<SettingsEntry>::iterator Settings::Find(const wchar_t* name)
+{
+    const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), name, LessByName);
+    return (it != m_entries.end() && it->name == name) ? it : m_entries.end();
+}
+
+std::vector<SettingsEntry>::const_iterator Settings::Find(const wchar_t* name) const
+{
+    const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), name, LessByName);
+    return (it != m_entries.end() && it->name == name) ? it : m_entries.end();
+}
+
+//------------------------------------------------------------------------------
+// FileSettingsBackend.
+
+static FILE* OpenSettingsFile(const std::wstring& path, bool write)
+{
+#ifdef _WIN32
+    return _wfopen(path.c_str(), write ? L"wb" : L"rb");
+#else
+    std::string narrow(path.size() * MB_CUR_MAX + 1, '\0');
+    const size_t len = wcstombs(&narrow[0], path.c_str(), narrow.size());
+    if (len == size_t(-1))
+        return nullptr;
+    narrow.resize(len);
+    return fopen(narrow.c_str(), write ? "wb" : "rb");
+#endif
+}
+
+bool FileSettingsBackend::Load(std::vector<SettingsEntry>& entries)
+{
+    FILE* const file = OpenSettingsFile(m_path, false);
+    if (!file)
+        return false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), file))
+    {
+        char* const equals = strchr(line, '=');
+        if (!equals || equals == line)
+            continue;
+
+        char* end;
+        const long value = strtol(equals + 1, &end, 10);
+        if (end == equals + 1 || (*end && *end != '\r' && *end != '\n'))
+            continue;
+
+        SettingsEntry entry;
+        entry.name.assign(line, equals);
+        entry.value = int32_t(value);
+        entries.push_back(std::move(entry));
+    }
+
+    fclose(file);
+    return true;
+}
+
+bool FileSettingsBackend::Save(const std::vector<SettingsEntry>& entries)
+{
+    FILE* const file = OpenSettingsFile(m_path, true);
+    if (!file)
+        return false;
+
+    bool ok = true;
+    std::string name;
+    for (const auto& entry : entries)
+    {
+        name.clear();
+        for (const wchar_t ch : entry.name)
+            name.push_back(char(ch));
+        if (fprintf(file, "%s=%ld\n", name.c_str(), long(entry.value)) < 0)
+            ok = false;
+    }
+
+    if (fclose(file))
+        ok = false;
+    return ok;
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Settings store.
+//
+// Settings are named 32-bit integers.  Load reads every stored value from the
+// backend in one pass, Get returns a loaded value or the caller's default, Set
+// marks a value dirty only when it changes, and Save hands the values to the
+// backend in one batch so it can write just the dirty ones.
+//
+// This has no dependencies on Windows, so the persistence and defaulting logic
+// can be built and tested on any platform.  See regsettings.h for the registry
+// backend.
+
+struct SettingsEntry
+{
+    std::wstring    name;
+    int32_t         value = 0;
+    bool            dirty = false;
+};
+
+class SettingsBackend
+{
+public:
+    virtual         ~SettingsBackend() {}
+
+    // Appends every stored value to entries.
+    virtual bool    Load(std::vector<SettingsEntry>& entries) = 0;
+    // Persists the dirty entries; the others are passed too, for backends
+    // that rewrite everything.
+    virtual bool    Save(const std::vector<SettingsEntry>& entries) = 0;
+};
+
+class Settings
+{
+public:
+    explicit        Settings(std::unique_ptr<SettingsBackend>&& backend);
+
+    bool            Load();
+    bool            Save();
+    bool            IsDirty() const;
+
+    int32_t         GetLong(const wchar_t* name, int32_t default_value) const;
+    void            SetLong(const wchar_t* name, int32_t value);
+
+private:
+    std::vector<SettingsEntry>::iterator Find(const wchar_t* name);
+    std::vector<SettingsEntry>::const_iterator Find(const wchar_t* name) const;
+
+    std::unique_ptr<SettingsBackend> m_backend;
+    std::vector<SettingsEntry> m_entries;   // Sorted by name.
+};
+
+//------------------------------------------------------------------------------
+// FileSettingsBackend keeps settings in a text file with one "Name=Value" line
+// per setting.  Names must be ASCII.
+
+class FileSettingsBackend : public SettingsBackend
+{
+public:
+    explicit        FileSettingsBackend(const wchar_t* path) : m_path(path) {}
+
+    bool            Load(std::vector<SettingsEntry>& entries) override;
+    bool            Save(const std::vector<SettingsEntry>& entries) override;
+
+private:
+    std::wstring    m_path;
+};
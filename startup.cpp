@@ -0,0 +1,263 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "startup.h"
+#include "console.h"
+#include "perf.h"
+
+// A traced instance that hasn't exited by then is killed, and the run fails.
+constexpr DWORD c_run_timeout_ms = 30000;
+
+struct StartupPhase
+{
+    const WCHAR*    name;
+    double          seconds;
+};
+
+static StartupPhase s_phases[24];
+static unsigned s_count = 0;
+static bool s_complete = false;
+static bool s_trace = false;
+
+void StartupMark(const WCHAR* phase)
+{
+    if (s_complete || s_count >= _countof(s_phases))
+        return;
+
+    s_phases[s_count].name = phase;
+    s_phases[s_count].seconds = GetPerfSeconds();
+    ++s_count;
+}
+
+// Returns the process creation time on the GetPerfSeconds clock, by measuring
+// how long ago the process was created on the system clock.
+static double GetProcessCreatedSeconds()
+{
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+        return s_count ? s_phases[0].seconds : GetPerfSeconds();
+
+    FILETIME now;
+    GetSystemTimePreciseAsFileTime(&now);
+    const double perfNow = GetPerfSeconds();
+
+    ULARGE_INTEGER ullCreated, ullNow;
+    ullCreated.LowPart = created.dwLowDateTime;
+    ullCreated.HighPart = created.dwHighDateTime;
+    ullNow.LowPart = now.dwLowDateTime;
+    ullNow.HighPart = now.dwHighDateTime;
+    return perfNow - double(ullNow.QuadPart - ullCreated.QuadPart) / 1e7;
+}
+
+static void PrintTimeline()
+{
+    if (!AttachConsoleOutput())
+        return;
+
+    double prev = GetProcessCreatedSeconds();
+    const double base = prev;
+
+    ConsolePrintf(L"Startup timeline (milliseconds since process creation):\n\n");
+    ConsolePrintf(L"   elapsed       delta  phase\n");
+    for (unsigned ii = 0; ii < s_count; ++ii)
+    {
+        const StartupPhase& phase = s_phases[ii];
+        ConsolePrintf(L"%10.3f  %10.3f  %s\n", (phase.seconds - base) * 1000, (phase.seconds - prev) * 1000, phase.name);
+        prev = phase.seconds;
+    }
+}
+
+void StartupComplete(const WCHAR* phase)
+{
+    if (s_complete)
+        return;
+
+    StartupMark(phase);
+    s_complete = true;
+
+    if (s_trace)
+    {
+        PrintTimeline();
+        PostQuitMessage(0);
+    }
+}
+
+void EnableStartupTrace()
+{
+    s_trace = true;
+}
+
+//------------------------------------------------------------------------------
+// Startup benchmark.
+
+struct PhaseSamples
+{
+    std::wstring        name;
+    std::vector<double> ms;
+};
+
+// Launches a traced instance and collects the elapsed time of each phase from
+// its output.
+static bool RunTracedInstance(const WCHAR* exe, std::vector<PhaseSamples>& samples, unsigned run)
+{
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), nullptr, true };
+    HANDLE hRead;
+    HANDLE hWrite;
+    if (!CreatePipe(&hRead, &hWrite, &sa, 0))
+        return false;
+    SetHandleInformation(hRead, HANDLE_FLAG_INHERIT, 0);
+
+    WCHAR cmdline[MAX_PATH + 32];
+    _snwprintf(cmdline, _countof(cmdline), L"\"%s\" --startup-trace", exe);
+    cmdline[_countof(cmdline) - 1] = '\0';
+
+    STARTUPINFOW si = { sizeof(si) };
+    si.dwFlags = STARTF_USESTDHANDLES|STARTF_USESHOWWINDOW;
+    si.wShowWindow = SW_SHOWNOACTIVATE;
+    si.hStdOutput = hWrite;
+    si.hStdError = hWrite;
+
+    PROCESS_INFORMATION pi;
+    const bool launched = !!CreateProcessW(exe, cmdline, nullptr, nullptr, true, 0, nullptr, nullptr, &si, &pi);
+    CloseHandle(hWrite);
+    if (!launched)
+    {
+        CloseHandle(hRead);
+        return false;
+    }
+
+    // Read the output as it arrives, while waiting (with a timeout) for the
+    // instance to exit.
+    std::string output;
+    char buffer[4096];
+    const ULONGLONG deadline = GetTickCount64() + c_run_timeout_ms;
+    bool exited = false;
+    bool timedOut = false;
+    while (true)
+    {
+        DWORD avail;
+        DWORD cb;
+        while (PeekNamedPipe(hRead, nullptr, 0, nullptr, &avail, nullptr) && avail &&
+               ReadFile(hRead, buffer, std::min<DWORD>(avail, sizeof(buffer)), &cb, nullptr) && cb)
+            output.append(buffer, cb);
+        if (exited)
+            break;
+
+        exited = (WaitForSingleObject(pi.hProcess, 20) == WAIT_OBJECT_0);
+        if (!exited && GetTickCount64() >= deadline)
+        {
+            TerminateProcess(pi.hProcess, 1);
+            WaitForSingleObject(pi.hProcess, INFINITE);
+            timedOut = true;
+            break;
+        }
+    }
+    CloseHandle(hRead);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+
+    if (timedOut)
+    {
+        ConsolePrintf(L"Run %u didn't finish starting within %u seconds.\n", run + 1, unsigned(c_run_timeout_ms / 1000));
+        return false;
+    }
+
+    std::wstring text(output.size(), '\0');
+    text.resize(MultiByteToWideChar(CP_UTF8, 0, output.data(), int(output.size()), &text[0], int(text.size())));
+
+    bool any = false;
+    size_t begin = 0;
+    while (begin < text.size())
+    {
+        size_t end = text.find('\n', begin);
+        if (end == std::wstring::npos)
+            end = text.size();
+        std::wstring line = text.substr(begin, end - begin);
+        begin = end + 1;
+
+        double elapsed;
+        double delta;
+        int consumed = 0;
+        if (swscanf(line.c_str(), L"%lf %lf %n", &elapsed, &delta, &consumed) != 2 || !consumed)
+            continue;
+
+        std::wstring name = line.substr(consumed);
+        while (!name.empty() && (name.back() == '\r' || name.back() == ' '))
+            name.pop_back();
+
+        auto it = std::find_if(samples.begin(), samples.end(), [&](const PhaseSamples& s) { return s.name == name; });
+        if (it == samples.end())
+        {
+            samples.push_back(PhaseSamples());
+            it = samples.end() - 1;
+            it->name = name;
+        }
+
+        // Keep samples indexed by run, so the first one is always the cold run.
+        it->ms.resize(run, NAN);
+        it->ms.push_back(elapsed);
+        any = true;
+    }
+
+    return any;
+}
+
+// Nearest-rank percentile of the sorted, non-empty values.
+static double Percentile(const std::vector<double>& sorted, unsigned pct)
+{
+    const size_t rank = std::max<size_t>(1, (sorted.size() * pct + 99) / 100);
+    return sorted[rank - 1];
+}
+
+int RunStartupBenchmark(unsigned runs)
+{
+    if (!AttachConsoleOutput())
+        return 1;
+
+    WCHAR exe[MAX_PATH];
+    const DWORD len = GetModuleFileNameW(nullptr, exe, _countof(exe));
+    if (!len || len >= _countof(exe))
+        return 1;
+
+    runs = std::max<unsigned>(runs, 1);
+    ConsolePrintf(L"Startup:  %u runs; the first is reported as cold, the rest as warm.\n\n", runs);
+
+    std::vector<PhaseSamples> samples;
+    for (unsigned run = 0; run < runs; ++run)
+    {
+        if (!RunTracedInstance(exe, samples, run))
+        {
+            ConsolePrintf(L"Run %u failed.\n", run + 1);
+            return 1;
+        }
+    }
+
+    ConsolePrintf(L"Milliseconds since process creation:\n\n");
+    ConsolePrintf(L"     cold    warm p50    warm p90    warm p99  phase\n");
+    for (const auto& phase : samples)
+    {
+        std::vector<double> warm;
+        for (size_t ii = 1; ii < phase.ms.size(); ++ii)
+        {
+            if (!isnan(phase.ms[ii]))
+                warm.push_back(phase.ms[ii]);
+        }
+        std::sort(warm.begin(), warm.end());
+
+        const double cold = phase.ms.empty() ? NAN : phase.ms[0];
+        if (warm.empty())
+            ConsolePrintf(L"%9.3f  %10s  %10s  %10s  %s\n", cold, L"-", L"-", L"-", phase.name.c_str());
+        else
+            ConsolePrintf(L"%9.3f  %10.3f  %10.3f  %10.3f  %s\n", cold, Percentile(warm, 50), Percentile(warm, 90), Percentile(warm, 99), phase.name.c_str());
+    }
+
+    return 0;
+}
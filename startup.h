@@ -0,0 +1,21 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+//------------------------------------------------------------------------------
+// Startup tracing.
+//
+// StartupMark records the end of a startup phase, relative to when the process
+// was created.  StartupComplete records the last phase and stops recording.
+//
+// `zoomin --startup-trace` prints the timeline after the first paint and
+// exits.  `zoomin --startup-bench <runs>` launches that many traced processes
+// one after another and reports the first (cold) run and percentiles of the
+// remaining (warm) runs for each phase; an instance that doesn't exit within
+// 30 seconds is killed and fails the benchmark.
+
+void StartupMark(const WCHAR* phase);
+void StartupComplete(const WCHAR* phase);
+void EnableStartupTrace();
+int RunStartupBenchmark(unsigned runs);
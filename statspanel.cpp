@@ -0,0 +1,365 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <windowsx.h>
+#include <dwmapi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+#include "statspanel.h"
+#include "res.h"
+
+#define WMU_STATSREADY          (WM_APP + 1)
+
+static const WCHAR c_wndclass_name[] = TEXT("ZoominStatsPanel");
+static const WCHAR c_font[] = L"Consolas";
+constexpr LONG c_panel_width = 220;     // 96 DPI.
+constexpr LONG c_panel_height = 320;    // 96 DPI.
+constexpr LONG c_padding = 6;           // 96 DPI.
+constexpr LONG c_snap_distance = 16;    // 96 DPI.
+constexpr LONG c_font_height = 12;      // 96 DPI.
+
+static const COLORREF c_channel_colors[SC_COUNT] =
+{
+    RGB(220, 0, 0),
+    RGB(0, 160, 0),
+    RGB(0, 0, 220),
+};
+
+static const WCHAR c_channel_names[SC_COUNT] = { 'R', 'G', 'B' };
+
+// The visible frame, without the invisible resize borders.
+static void GetFrameBounds(HWND hwnd, RECT& rc)
+{
+    if (FAILED(DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &rc, sizeof(rc))))
+        GetWindowRect(hwnd, &rc);
+}
+
+StatsPanel::~StatsPanel()
+{
+    Destroy();
+}
+
+bool StatsPanel::Create(HINSTANCE hinst, HWND hwndOwner)
+{
+    if (m_hwnd)
+        return true;
+
+    WNDCLASS wc = {};
+    if (!GetClassInfo(hinst, c_wndclass_name, &wc))
+    {
+        wc.lpfnWndProc = WndProc;
+        wc.hInstance = hinst;
+        wc.hIcon = LoadIcon(hinst, MAKEINTRESOURCE(IDI_MAIN));
+        wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+        wc.hbrBackground = HBRUSH(GetStockObject(NULL_BRUSH));
+        wc.lpszClassName = c_wndclass_name;
+        if (!RegisterClass(&wc))
+            return false;
+    }
+
+    m_hwndOwner = hwndOwner;
+    m_dpi = __GetDpiForWindow(hwndOwner);
+
+    constexpr DWORD c_style = WS_POPUP|WS_CAPTION|WS_SYSMENU|WS_THICKFRAME;
+    constexpr DWORD c_exstyle = WS_EX_TOOLWINDOW;
+    m_hwnd = CreateWindowEx(c_exstyle, c_wndclass_name, TEXT("Region Statistics"), c_style,
+                            0, 0, m_dpi.Scale(c_panel_width), m_dpi.Scale(c_panel_height),
+                            hwndOwner, NULL, hinst, this);
+    if (!m_hwnd)
+        return false;
+
+    UpdateFont();
+    return true;
+}
+
+void StatsPanel::Destroy()
+{
+    // Stop the worker first, so it can't post to a destroyed window.
+    m_worker.reset();
+
+    if (m_hwnd)
+    {
+        DestroyWindow(m_hwnd);
+        m_hwnd = NULL;
+    }
+    if (m_hfont)
+    {
+        DeleteObject(m_hfont);
+        m_hfont = NULL;
+    }
+}
+
+void StatsPanel::Show(bool show)
+{
+    m_shown = show;
+
+    // The worker thread only exists while the panel has been used.
+    if (show && !m_worker)
+    {
+        m_worker.reset(new RegionStatsWorker([this]()
+        {
+            // One pending notification is enough; the UI thread reads the
+            // latest results when it gets to it.
+            if (!m_posted.exchange(true))
+                PostMessage(m_hwnd, WMU_STATSREADY, 0, 0);
+        }));
+    }
+
+    OnOwnerChanged();
+}
+
+void StatsPanel::Submit(const PixelSource& src)
+{
+    if (m_worker && m_hwnd && IsWindowVisible(m_hwnd))
+        m_worker->Submit(src);
+}
+
+void StatsPanel::OnOwnerChanged()
+{
+    if (!m_hwnd)
+        return;
+
+    // Follow the owner:  e.g. hiding to the tray doesn't hide owned windows.
+    const bool visible = (m_shown && IsWindowVisible(m_hwndOwner) && !IsIconic(m_hwndOwner));
+    if (visible != !!IsWindowVisible(m_hwnd))
+        ShowWindow(m_hwnd, visible ? SW_SHOWNA : SW_HIDE);
+
+    if (visible && m_docked)
+        Dock();
+}
+
+LRESULT CALLBACK StatsPanel::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    StatsPanel* const panel = reinterpret_cast<StatsPanel*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+
+    switch (msg)
+    {
+    case WM_NCCREATE:
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, LONG_PTR(LPCREATESTRUCT(lParam)->lpCreateParams));
+        goto LDefault;
+
+    case WM_ERASEBKGND:
+        return true;
+    case WM_PAINT:
+        panel->OnPaint();
+        break;
+    case WM_SIZE:
+        InvalidateRect(hwnd, nullptr, false);
+        break;
+
+    case WMU_STATSREADY:
+        panel->OnResults();
+        break;
+
+    case WM_MOVING:
+        panel->OnMoving(*LPRECT(lParam));
+        return true;
+    case WM_EXITSIZEMOVE:
+        // Docking also restores the height to match the owner.
+        if (panel->m_docked)
+            panel->Dock();
+        break;
+
+    case WM_DPICHANGED:
+        panel->OnDpiChanged(DpiScaler(wParam), *LPCRECT(lParam));
+        break;
+
+    case WM_CLOSE:
+        // Closing only hides the panel; the owner's menu shows it again.
+        panel->Show(false);
+        break;
+
+    default:
+LDefault:
+        return DefWindowProc(hwnd, msg, wParam, lParam);
+    }
+
+    return 0;
+}
+
+void StatsPanel::OnPaint()
+{
+    PAINTSTRUCT ps;
+    BeginPaint(m_hwnd, &ps);
+
+    RECT rc;
+    GetClientRect(m_hwnd, &rc);
+
+    // Draw offscreen so the histogram doesn't flicker at the refresh rate.
+    HDC hdc = CreateCompatibleDC(ps.hdc);
+    HBITMAP hbmp = hdc ? CreateCompatibleBitmap(ps.hdc, rc.right, rc.bottom) : NULL;
+    if (hdc && hbmp)
+    {
+        HBITMAP hbmpOld = SelectBitmap(hdc, hbmp);
+        Draw(hdc, rc);
+        BitBlt(ps.hdc, 0, 0, rc.right, rc.bottom, hdc, 0, 0, SRCCOPY);
+        SelectBitmap(hdc, hbmpOld);
+    }
+    else
+    {
+        Draw(ps.hdc, rc);
+    }
+
+    if (hbmp)
+        DeleteObject(hbmp);
+    if (hdc)
+        DeleteDC(hdc);
+
+    EndPaint(m_hwnd, &ps);
+}
+
+void StatsPanel::OnResults()
+{
+    m_posted = false;
+    if (m_worker && m_worker->GetResults(m_stats))
+    {
+        m_has_stats = true;
+        InvalidateRect(m_hwnd, nullptr, false);
+    }
+}
+
+void StatsPanel::OnMoving(RECT& rc)
+{
+    RECT rcOwner;
+    RECT rcFrame;
+    RECT rcWindow;
+    GetFrameBounds(m_hwndOwner, rcOwner);
+    GetFrameBounds(m_hwnd, rcFrame);
+    GetWindowRect(m_hwnd, &rcWindow);
+
+    // Snap the visible frame to the owner's top right corner.
+    const LONG left = rc.left + (rcFrame.left - rcWindow.left);
+    const LONG top = rc.top + (rcFrame.top - rcWindow.top);
+    const LONG snap = m_dpi.Scale(c_snap_distance);
+    m_docked = (abs(left - rcOwner.right) <= snap && abs(top - rcOwner.top) <= snap);
+    if (m_docked)
+        OffsetRect(&rc, rcOwner.right - left, rcOwner.top - top);
+}
+
+void StatsPanel::OnDpiChanged(const DpiScaler& dpi, const RECT& rc)
+{
+    m_dpi.OnDpiChanged(dpi);
+    UpdateFont();
+
+    constexpr DWORD c_flags = SWP_NOACTIVATE|SWP_NOZORDER|SWP_NOOWNERZORDER;
+    SetWindowPos(m_hwnd, NULL, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, c_flags);
+    if (m_docked)
+        Dock();
+    InvalidateRect(m_hwnd, nullptr, false);
+}
+
+void StatsPanel::Dock()
+{
+    RECT rcOwner;
+    RECT rcFrame;
+    RECT rcWindow;
+    GetFrameBounds(m_hwndOwner, rcOwner);
+    GetFrameBounds(m_hwnd, rcFrame);
+    GetWindowRect(m_hwnd, &rcWindow);
+
+    // Line up the visible frames; the window rects include invisible borders.
+    const LONG left = rcOwner.right - (rcFrame.left - rcWindow.left);
+    const LONG top = rcOwner.top - (rcFrame.top - rcWindow.top);
+    const LONG cx = rcWindow.right - rcWindow.left;
+    const LONG cy = (rcOwner.bottom - rcOwner.top) + (rcFrame.top - rcWindow.top) + (rcWindow.bottom - rcFrame.bottom);
+    if (left == rcWindow.left && top == rcWindow.top && cy == rcWindow.bottom - rcWindow.top)
+        return;
+
+    constexpr DWORD c_flags = SWP_NOACTIVATE|SWP_NOZORDER|SWP_NOOWNERZORDER;
+    SetWindowPos(m_hwnd, NULL, left, top, cx, cy, c_flags);
+}
+
+void StatsPanel::Draw(HDC hdc, const RECT& rc)
+{
+    FillRect(hdc, &rc, GetSysColorBrush(COLOR_WINDOW));
+    SetBkMode(hdc, TRANSPARENT);
+    SetTextColor(hdc, GetSysColor(COLOR_WINDOWTEXT));
+    HFONT hfontOld = m_hfont ? SelectFont(hdc, m_hfont) : NULL;
+
+    TEXTMETRIC tm;
+    GetTextMetrics(hdc, &tm);
+    const LONG pad = m_dpi.Scale(c_padding);
+    const LONG line = tm.tmHeight;
+    LONG y = pad;
+
+    auto print = [&](const WCHAR* text)
+    {
+        TextOut(hdc, pad, y, text, int(wcslen(text)));
+        y += line;
+    };
+
+    if (!m_has_stats)
+    {
+        print(L"Waiting for the zoom area...");
+    }
+    else
+    {
+        WCHAR text[80];
+        swprintf(text, _countof(text), L"Pixels  %u", m_stats.pixels);
+        print(text);
+        swprintf(text, _countof(text), L"Colors  %u", m_stats.unique_colors);
+        print(text);
+        y += line / 2;
+
+        print(L"   Min  Max   Mean  StdDev");
+        for (int32_t ch = 0; ch < SC_COUNT; ++ch)
+        {
+            const ChannelStats& channel = m_stats.channels[ch];
+            swprintf(text, _countof(text), L"%c  %3u  %3u  %5.1f  %6.2f", c_channel_names[ch],
+                     channel.min, channel.max, channel.mean, channel.stddev);
+            SetTextColor(hdc, c_channel_colors[ch]);
+            print(text);
+        }
+        y += line / 2;
+
+        // Histogram curves, on a square root scale so small bins are still
+        // visible next to a dominant background color.
+        RECT rcGraph = { pad, y, rc.right - pad, rc.bottom - pad };
+        if (rcGraph.right - rcGraph.left > 1 && rcGraph.bottom - rcGraph.top > 1)
+        {
+            FrameRect(hdc, &rcGraph, GetSysColorBrush(COLOR_GRAYTEXT));
+            InflateRect(&rcGraph, -1, -1);
+
+            uint32_t peak = 1;
+            for (const auto& channel : m_stats.channels)
+                peak = std::max<uint32_t>(peak, *std::max_element(channel.histogram, channel.histogram + 256));
+            const double scale = (rcGraph.bottom - rcGraph.top - 1) / sqrt(double(peak));
+            const LONG cx = rcGraph.right - rcGraph.left - 1;
+
+            POINT points[256];
+            for (int32_t ch = 0; ch < SC_COUNT; ++ch)
+            {
+                for (int32_t bin = 0; bin < 256; ++bin)
+                {
+                    points[bin].x = rcGraph.left + bin * cx / 255;
+                    points[bin].y = rcGraph.bottom - 1 - LONG(sqrt(double(m_stats.channels[ch].histogram[bin])) * scale);
+                }
+
+                HPEN hpen = CreatePen(PS_SOLID, 1, c_channel_colors[ch]);
+                HPEN hpenOld = hpen ? SelectPen(hdc, hpen) : NULL;
+                Polyline(hdc, points, _countof(points));
+                if (hpen)
+                {
+                    SelectPen(hdc, hpenOld);
+                    DeleteObject(hpen);
+                }
+            }
+        }
+    }
+
+    if (hfontOld)
+        SelectFont(hdc, hfontOld);
+}
+
+void StatsPanel::UpdateFont()
+{
+    if (m_hfont)
+        DeleteObject(m_hfont);
+    m_hfont = CreateFont(-m_dpi.Scale(c_font_height), 0, 0, 0, FW_NORMAL, false, false, false, DEFAULT_CHARSET,
+                         OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, FIXED_PITCH|FF_MODERN, c_font);
+}
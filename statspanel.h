@@ -0,0 +1,55 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "dpi.h"
+#include "regionstats.h"
+
+//------------------------------------------------------------------------------
+// StatsPanel is a tool window that shows statistics for the zoom area.
+//
+// It docks flush against the right edge of its owner and follows it as the
+// owner moves or resizes.  Dragging it away undocks it, and dropping it back
+// within snapping distance docks it again.  The statistics are computed by a
+// RegionStatsWorker, so the UI thread only copies the pixels and paints.
+
+class StatsPanel
+{
+public:
+                    StatsPanel() = default;
+                    ~StatsPanel();
+
+    bool            Create(HINSTANCE hinst, HWND hwndOwner);
+    void            Destroy();
+
+    bool            IsShown() const { return m_shown; }
+    void            Show(bool show);
+    void            Submit(const PixelSource& src);
+    // Call when the owner moves, resizes, or is shown or hidden.
+    void            OnOwnerChanged();
+
+private:
+    static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+    void            OnPaint();
+    void            OnResults();
+    void            OnMoving(RECT& rc);
+    void            OnDpiChanged(const DpiScaler& dpi, const RECT& rc);
+    void            Dock();
+    void            Draw(HDC hdc, const RECT& rc);
+    void            UpdateFont();
+
+    HWND            m_hwnd = NULL;
+    HWND            m_hwndOwner = NULL;
+    HFONT           m_hfont = NULL;
+    DpiScaler       m_dpi;
+    bool            m_shown = false;
+    bool            m_docked = true;
+    std::unique_ptr<RegionStatsWorker> m_worker;
+    std::atomic<bool> m_posted{ false };
+    RegionStats     m_stats;
+    bool            m_has_stats = false;
+};
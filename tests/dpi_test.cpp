@@ -0,0 +1,93 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <limits.h>
+#include <stdio.h>
+
+#include "../dpidivisor.h"
+#include "test.h"
+
+//------------------------------------------------------------------------------
+// DpiDivisor must match HIDPIMulDiv exactly wherever HIDPIMulDiv doesn't
+// overflow, i.e. wherever |x| * y + (z >> 3) <= INT_MAX.
+
+// The same formula as HIDPIMulDiv in dpi.cpp, which needs Windows.
+static int HIDPIMulDivFormula(int x, int y, int z)
+{
+    return ((((x < 0) ? -x : x) * y + (z >> 3)) / z) * ((x < 0) ? -1 : 1);
+}
+
+// Every scaling step Windows offers (100% to 500%), plus custom scaling and
+// odd monitor DPIs that aren't multiples of 24.
+static const uint32_t c_dpis[] =
+{
+    96, 120, 144, 168, 192, 216, 240, 264, 288, 312, 336, 360, 384, 408, 432, 456, 480,
+    72, 97, 100, 108, 110, 125, 130, 150, 175, 200, 250, 300, 350, 400, 450, 479,
+};
+
+TEST(DpiDivisorEveryNumerator)
+{
+    // MulDiv(x, y) is floor(n / z) of the numerator n = |x| * y + (z >> 3), so
+    // it matches for every x and y exactly when the reciprocal divides every
+    // numerator up to INT_MAX correctly.  The reciprocal never rounds down
+    // (mul >= 2^shift / z) and is monotonic, so it can only be wrong at the
+    // last numerator of each quotient, q * z - 1:  checking those, and
+    // INT_MAX, checks every numerator.
+    unsigned mismatches = 0;
+    for (const uint32_t z : c_dpis)
+    {
+        const DpiDivisor divisor(z);
+        const int64_t bias = z >> 3;
+        auto check = [&](int64_t n)
+        {
+            if (n >= bias && divisor.MulDiv(int(n - bias), 1) != int(n / z))
+                ++mismatches;
+        };
+        for (int64_t n = int64_t(z) - 1; n <= INT_MAX; n += z)
+            check(n);
+        check(INT_MAX);
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(DpiDivisorEveryPair)
+{
+    // Every pair of DPIs directly against the formula, near zero and up to
+    // the limit where HIDPIMulDiv would overflow, in both signs.
+    const int c_window = 4096;
+    unsigned mismatches = 0;
+    for (const uint32_t z : c_dpis)
+    {
+        const DpiDivisor divisor(z);
+        for (const uint32_t y : c_dpis)
+        {
+            const int max_x = int((INT_MAX - (z >> 3)) / y);
+            auto check = [&](int x)
+            {
+                if (divisor.MulDiv(x, y) != HIDPIMulDivFormula(x, int(y), int(z)) ||
+                    divisor.MulDiv(-x, y) != HIDPIMulDivFormula(-x, int(y), int(z)))
+                    ++mismatches;
+            };
+            for (int x = 0; x <= c_window; ++x)
+                check(x);
+            for (int x = max_x - c_window; x <= max_x; ++x)
+                check(x);
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(DpiDivisorCommon)
+{
+    static const uint32_t c_common[] = { 96, 120, 144, 168, 192, 288 };
+    for (const uint32_t dpi : c_common)
+        CHECK(GetCommonDpiDivisor(dpi) != nullptr);
+    CHECK(GetCommonDpiDivisor(100) == nullptr);
+
+    // The computed and constexpr divisors agree.
+    for (int x = -100000; x <= 100000; x += 7)
+    {
+        CHECK(GetDpiDivisor(144).MulDiv(x, 96) == DpiDivisor(144).MulDiv(x, 96));
+        CHECK(GetDpiDivisor(100).MulDiv(x, 96) == HIDPIMulDivFormula(x, 96, 100));
+    }
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <vector>
+
+#include "../edges.h"
+#include "test.h"
+
+//------------------------------------------------------------------------------
+// A ruler whose ends are dropped near a box's corners snaps to the box's
+// edges, so it measures exactly the box's size.
+
+TEST(EdgesMeasureBoxes)
+{
+    TestRandom random(1);
+    unsigned mismatches = 0;
+    for (unsigned trial = 0; trial < 300; ++trial)
+    {
+        // A box on a background, both with a little noise.
+        const int32_t cx = random.Range(40, 239);
+        const int32_t cy = random.Range(40, 139);
+        const int32_t left = random.Range(2, cx / 2 + 1);
+        const int32_t top = random.Range(2, cy / 2 + 1);
+        const int32_t right = left + random.Range(5, cx - left - 2);
+        const int32_t bottom = top + random.Range(5, cy - top - 2);
+        std::vector<uint32_t> pixels(cx * cy);
+        for (int32_t yy = 0; yy < cy; ++yy)
+        {
+            for (int32_t xx = 0; xx < cx; ++xx)
+            {
+                const bool inside = (xx >= left && xx < right && yy >= top && yy < bottom);
+                pixels[yy * cx + xx] = (inside ? 0x2060a0 : 0xf0f0f0) + (random.Next() & 3) * 0x010101;
+            }
+        }
+
+        PixelSource src;
+        src.bits = pixels.data();
+        src.stride = src.cx = cx;
+        src.cy = cy;
+        EdgeMap edges;
+        edges.Build(src, 0, 0);
+
+        // Drop each end within 2 pixels of the box's corners.
+        const int32_t row = (top + bottom) / 2;
+        const int32_t column = (left + right) / 2;
+        int32_t x1 = left + random.Range(-2, 2);
+        int32_t y1 = top + random.Range(-2, 2);
+        int32_t x2 = right + random.Range(-2, 2);
+        int32_t y2 = bottom + random.Range(-2, 2);
+        edges.Snap(x1, y1, row, column, 2);
+        edges.Snap(x2, y2, row, column, 2);
+        if (x1 != left || y1 != top || x2 != right || y2 != bottom)
+            ++mismatches;
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(EdgesOutOfRange)
+{
+    // Corners with no edge within the radius don't move.
+    std::vector<uint32_t> pixels(30 * 20, 0x808080);
+    for (int32_t yy = 0; yy < 20; ++yy)
+        pixels[yy * 30 + 10] = 0x000000;
+
+    PixelSource src;
+    src.bits = pixels.data();
+    src.stride = src.cx = 30;
+    src.cy = 20;
+    EdgeMap edges;
+    edges.Build(src, 100, 200);
+    CHECK(edges.IsFor(100, 200, 30, 20));
+    CHECK(!edges.IsFor(101, 200, 30, 20));
+    CHECK(edges.IsVerticalEdge(10, 5));
+    CHECK(edges.IsVerticalEdge(11, 5));
+    CHECK(!edges.IsVerticalEdge(20, 5));
+
+    int32_t x = 20;
+    int32_t y = 10;
+    edges.Snap(x, y, 10, 20, 2);
+    CHECK(x == 20 && y == 10);
+
+    x = 13;
+    edges.Snap(x, y, 10, 20, 2);
+    CHECK(x == 11 && y == 10);
+}
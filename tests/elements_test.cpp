@@ -0,0 +1,99 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "../elements.h"
+#include "test.h"
+
+//------------------------------------------------------------------------------
+// Random filled and outlined boxes are found exactly (an outlined box's inside
+// is an element too), and text on a filled box doesn't matter.
+
+static bool LessElement(const ElementRect& a, const ElementRect& b)
+{
+    return (a.top != b.top) ? a.top < b.top : a.left < b.left;
+}
+
+TEST(ElementsFindBoxes)
+{
+    const int32_t c_cell = 40;
+
+    TestRandom random(1);
+    unsigned mismatches = 0;
+    for (unsigned trial = 0; trial < 300; ++trial)
+    {
+        // At most one box per cell, so boxes never touch.
+        const int32_t cx = random.Range(60, 259);
+        const int32_t cy = random.Range(60, 179);
+        std::vector<uint32_t> pixels(cx * cy, 0xf0f0f0);
+        std::vector<ElementRect> expected;
+        for (int32_t cell_y = 0; cell_y + c_cell <= cy; cell_y += c_cell)
+        {
+            for (int32_t cell_x = 0; cell_x + c_cell <= cx; cell_x += c_cell)
+            {
+                if (random.Next() % 3 == 0)
+                    continue;
+                const int32_t left = cell_x + random.Range(2, 7);
+                const int32_t top = cell_y + random.Range(2, 7);
+                const int32_t right = left + c_min_element_size + random.Range(0, cell_x + c_cell - left - 7);
+                const int32_t bottom = top + c_min_element_size + random.Range(0, cell_y + c_cell - top - 7);
+                const bool outline = (random.Next() & 1);
+                const uint32_t color = 0x203040 + random.Next() % 50;
+                for (int32_t yy = top; yy < bottom; ++yy)
+                {
+                    for (int32_t xx = left; xx < right; ++xx)
+                    {
+                        if (!outline || yy == top || yy == bottom - 1 || xx == left || xx == right - 1)
+                            pixels[yy * cx + xx] = color;
+                    }
+                }
+                // A few dots of "text" don't matter.
+                if (!outline && right - left > 6 && bottom - top > 6)
+                {
+                    for (int32_t dots = 0; dots < 5; ++dots)
+                        pixels[random.Range(top + 2, bottom - 3) * cx + random.Range(left + 2, right - 3)] = 0;
+                }
+                expected.push_back({ left, top, right, bottom });
+                if (outline && right - left - 2 >= c_min_element_size && bottom - top - 2 >= c_min_element_size)
+                    expected.push_back({ left + 1, top + 1, right - 1, bottom - 1 });
+            }
+        }
+
+        PixelSource src;
+        src.bits = pixels.data();
+        src.stride = src.cx = cx;
+        src.cy = cy;
+        ElementFinder finder;
+        finder.Find(src, 0, 0);
+
+        std::vector<ElementRect> found = finder.GetElements();
+        std::sort(found.begin(), found.end(), LessElement);
+        std::sort(expected.begin(), expected.end(), LessElement);
+        if (found.size() != expected.size() ||
+            (!found.empty() && memcmp(found.data(), expected.data(), found.size() * sizeof(found[0]))))
+            ++mismatches;
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(ElementsIgnoreNoise)
+{
+    // Every pixel a different color:  no spans join, so nothing is found.
+    const int32_t cx = 200;
+    const int32_t cy = 100;
+    std::vector<uint32_t> pixels(cx * cy);
+    for (size_t ii = 0; ii < pixels.size(); ++ii)
+        pixels[ii] = uint32_t(ii * 2654435761u) >> 8;
+
+    PixelSource src;
+    src.bits = pixels.data();
+    src.stride = src.cx = cx;
+    src.cy = cy;
+    ElementFinder finder;
+    finder.Find(src, 10, 20);
+    CHECK(finder.IsFor(10, 20, cx, cy));
+    CHECK(finder.GetElements().empty());
+}
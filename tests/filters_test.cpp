@@ -0,0 +1,229 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "../filters.h"
+#include "test.h"
+
+//------------------------------------------------------------------------------
+// FilterPipeline is checked against ApplyFilterReference applied one filter at
+// a time.  The tests project uses SSE2 where the compiler targets it, and the
+// tests_nosse2 project defines NO_SSE2 to check the scalar code.
+
+static void FilterReference(const FilterStep* steps, size_t count, const uint32_t* in, int32_t cx, uint32_t* out)
+{
+    std::vector<uint32_t> expected(in, in + cx);
+    std::vector<uint32_t> temp(cx);
+    for (size_t ii = 0; ii < count; ++ii)
+    {
+        ApplyFilterReference(steps[ii], expected.data(), cx, temp.data());
+        expected.swap(temp);
+    }
+    std::copy(expected.begin(), expected.end(), out);
+}
+
+static void RandomPixels(TestRandom& random, std::vector<uint32_t>& pixels)
+{
+    for (uint32_t& p : pixels)
+        p = (random.Next() << 8) ^ random.Next();
+}
+
+TEST(FilterEachKind)
+{
+    // Every kind alone, with a few params, over every channel value.
+    TestRandom random(1);
+    std::vector<uint32_t> pixels(256 * 3 + 37);
+    RandomPixels(random, pixels);
+    for (uint32_t ii = 0; ii < 256; ++ii)
+    {
+        pixels[ii] = (ii << 24) | (ii << 16) | (ii << 8) | ii;
+        pixels[256 + ii] = (ii << 16) | ((255 - ii) << 8) | (ii ^ 0x5a);
+    }
+    const int32_t cx = int32_t(pixels.size());
+
+    unsigned mismatches = 0;
+    for (int32_t kind = FK_NONE; kind < FK_COUNT; ++kind)
+    {
+        for (const int32_t param : { 0, 1, 50, 128, 255, 1000, GetDefaultFilterParam(FilterKind(kind)) })
+        {
+            FilterStep step;
+            step.kind = FilterKind(kind);
+            step.param = ClampFilterParam(step.kind, param);
+
+            FilterPipeline pipeline;
+            pipeline.Compile(&step, 1);
+            std::vector<uint32_t> fused(cx);
+            pipeline.ApplyRow(pixels.data(), cx, fused.data());
+
+            std::vector<uint32_t> expected(cx);
+            FilterReference(&step, 1, pixels.data(), cx, expected.data());
+            if (fused != expected)
+                ++mismatches;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(FilterRandomChains)
+{
+    TestRandom random(2);
+    unsigned mismatches = 0;
+    for (unsigned trial = 0; trial < 1000; ++trial)
+    {
+        const size_t count = 1 + random.Next() % c_max_filters;
+        FilterStep steps[c_max_filters];
+        for (size_t ii = 0; ii < count; ++ii)
+        {
+            steps[ii].kind = FilterKind(random.Next() % FK_COUNT);
+            steps[ii].param = ClampFilterParam(steps[ii].kind, random.Range(0, 1000));
+        }
+
+        // Odd lengths exercise the tails, and long ones span several chunks.
+        const int32_t cx = random.Range(1, 1000);
+        std::vector<uint32_t> pixels(cx);
+        RandomPixels(random, pixels);
+
+        FilterPipeline pipeline;
+        pipeline.Compile(steps, count);
+        std::vector<uint32_t> fused(cx);
+        pipeline.ApplyRow(pixels.data(), cx, fused.data());
+
+        std::vector<uint32_t> expected(cx);
+        FilterReference(steps, count, pixels.data(), cx, expected.data());
+        if (fused != expected)
+            ++mismatches;
+
+        // Filtering in place gives the same result.
+        pipeline.ApplyRow(pixels.data(), cx, pixels.data());
+        if (pixels != expected)
+            ++mismatches;
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(FilterApplyStride)
+{
+    // Apply reads rows at the source stride and writes them packed.
+    TestRandom random(3);
+    const int32_t cx = 300;
+    const int32_t cy = 7;
+    const int32_t stride = 333;
+    std::vector<uint32_t> pixels(stride * cy);
+    RandomPixels(random, pixels);
+
+    FilterStep steps[2];
+    steps[0].kind = FK_DEUTERANOPIA;
+    steps[1].kind = FK_GAMMA;
+    steps[1].param = ClampFilterParam(FK_GAMMA, GetDefaultFilterParam(FK_GAMMA) * 2);
+
+    FilterPipeline pipeline;
+    pipeline.Compile(steps, 2);
+    CHECK(!pipeline.IsEmpty());
+
+    PixelSource src;
+    src.bits = pixels.data();
+    src.stride = stride;
+    src.cx = cx;
+    src.cy = cy;
+    std::vector<uint32_t> filtered;
+    PixelSource out;
+    pipeline.Apply(src, filtered, out);
+    CHECK(out.cx == cx && out.cy == cy && out.stride == cx);
+
+    unsigned mismatches = 0;
+    std::vector<uint32_t> expected(cx);
+    for (int32_t yy = 0; yy < cy; ++yy)
+    {
+        FilterReference(steps, 2, pixels.data() + yy * stride, cx, expected.data());
+        if (!std::equal(expected.begin(), expected.end(), out.bits + yy * out.stride))
+            ++mismatches;
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(FilterFolding)
+{
+    // Chains that fold to fewer stages; FilterRandomChains checks the results.
+    struct Case { FilterKind kinds[3]; size_t stages; };
+    static const Case c_cases[] =
+    {
+        { { FK_INVERT, FK_INVERT, FK_NONE }, 0 },
+        { { FK_RED, FK_GRAYSCALE, FK_NONE }, 1 },
+        { { FK_PROTANOPIA, FK_GREEN, FK_NONE }, 1 },
+        { { FK_GRAYSCALE, FK_GRAYSCALE, FK_NONE }, 1 },
+        { { FK_GRAYSCALE, FK_THRESHOLD, FK_NONE }, 2 },
+        { { FK_GRAYSCALE, FK_GAMMA, FK_TRITANOPIA }, 2 },
+        { { FK_PROTANOPIA, FK_GAMMA, FK_DEUTERANOPIA }, 3 },
+    };
+
+    for (const Case& c : c_cases)
+    {
+        FilterStep steps[3];
+        for (size_t ii = 0; ii < 3; ++ii)
+        {
+            steps[ii].kind = c.kinds[ii];
+            steps[ii].param = GetDefaultFilterParam(c.kinds[ii]);
+        }
+
+        FilterPipeline pipeline;
+        pipeline.Compile(steps, 3);
+        CHECK(pipeline.GetStageCount() == c.stages);
+    }
+}
+
+TEST(FilterEmpty)
+{
+    FilterStep steps[c_max_filters];
+    FilterPipeline pipeline;
+    pipeline.Compile(steps, c_max_filters);
+    CHECK(pipeline.IsEmpty());
+
+    const uint32_t pixels[] = { 0x12345678, 0xff000000, 0x00ffffff };
+    uint32_t out[3] = {};
+    pipeline.ApplyRow(pixels, 3, out);
+    CHECK(out[0] == pixels[0] && out[1] == pixels[1] && out[2] == pixels[2]);
+}
+
+//------------------------------------------------------------------------------
+// Benchmarks.
+
+BENCH(FilterChains)
+{
+    const int32_t cx = 1920;
+    const int32_t cy = 1080;
+    const unsigned c_iterations = 10;
+
+    TestRandom random(4);
+    std::vector<uint32_t> pixels(size_t(cx) * cy);
+    RandomPixels(random, pixels);
+
+    PixelSource src;
+    src.bits = pixels.data();
+    src.stride = src.cx = cx;
+    src.cy = cy;
+
+    FilterStep steps[c_max_filters];
+    steps[0].kind = FK_PROTANOPIA;
+    steps[1].kind = FK_GAMMA;
+    steps[1].param = GetDefaultFilterParam(FK_GAMMA);
+    steps[2].kind = FK_INVERT;
+    steps[3].kind = FK_GRAYSCALE;
+    steps[4].kind = FK_THRESHOLD;
+    steps[4].param = GetDefaultFilterParam(FK_THRESHOLD);
+
+    for (const size_t count : { size_t(1), c_max_filters })
+    {
+        FilterPipeline pipeline;
+        pipeline.Compile(steps, count);
+        std::vector<uint32_t> filtered;
+        PixelSource out;
+        const double start = GetTestSeconds();
+        for (unsigned ii = 0; ii < c_iterations; ++ii)
+            pipeline.Apply(src, filtered, out);
+        printf("  %ux%u, %u filters:  %.3f ms/frame.\n", unsigned(cx), unsigned(cy), unsigned(count),
+               (GetTestSeconds() - start) * 1000 / c_iterations);
+    }
+}
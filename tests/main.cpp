@@ -0,0 +1,85 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "test.h"
+
+struct TestEntry
+{
+    const char*     name;
+    TestFunc        func;
+    bool            bench;
+};
+
+static std::vector<TestEntry>& GetTests()
+{
+    static std::vector<TestEntry> s_tests;
+    return s_tests;
+}
+
+static unsigned s_failures = 0;
+
+TestRegistration::TestRegistration(const char* name, TestFunc func, bool bench)
+{
+    GetTests().push_back({ name, func, bench });
+}
+
+void ReportFailure(const char* file, int line, const char* expr)
+{
+    ++s_failures;
+    printf("%s(%d): CHECK(%s) failed.\n", file, line, expr);
+}
+
+double GetTestSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Usage:  tests [--bench] [name ...]
+//
+// Runs the tests (or the benchmarks) whose names are given, or all of them.
+int main(int argc, char** argv)
+{
+    bool bench = false;
+    std::vector<const char*> names;
+    for (int ii = 1; ii < argc; ++ii)
+    {
+        if (!strcmp(argv[ii], "--bench"))
+            bench = true;
+        else
+            names.push_back(argv[ii]);
+    }
+
+    unsigned run = 0;
+    unsigned failed = 0;
+    for (const TestEntry& test : GetTests())
+    {
+        if (test.bench != bench)
+            continue;
+        if (!names.empty())
+        {
+            bool match = false;
+            for (const char* name : names)
+                match |= !strcmp(name, test.name);
+            if (!match)
+                continue;
+        }
+
+        const unsigned before = s_failures;
+        printf("%s\n", test.name);
+        test.func();
+        ++run;
+        if (s_failures != before)
+        {
+            ++failed;
+            printf("%s FAILED\n", test.name);
+        }
+    }
+
+    printf("\n%u of %u %s passed.\n", run - failed, run, bench ? "benchmarks" : "tests");
+    return failed ? 1 : 0;
+}
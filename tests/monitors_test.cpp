@@ -0,0 +1,208 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <algorithm>
+#include <vector>
+
+#include "../monitors.h"
+#include "test.h"
+
+//------------------------------------------------------------------------------
+// MonitorTable::FromPoint is checked against a brute force search:  the first
+// monitor that contains the point, else the first nearest one.
+
+static const MonitorEntry* FromPointReference(const std::vector<MonitorEntry>& entries, int32_t x, int32_t y, bool nearest)
+{
+    for (const auto& entry : entries)
+    {
+        if (entry.monitor.Contains(x, y))
+            return &entry;
+    }
+    if (!nearest)
+        return nullptr;
+
+    const MonitorEntry* best = nullptr;
+    int64_t best_distance = 0;
+    for (const auto& entry : entries)
+    {
+        const MonitorRect& rc = entry.monitor;
+        const int64_t dx = std::max<int64_t>({ int64_t(rc.left) - x, int64_t(x) - (rc.right - 1), 0 });
+        const int64_t dy = std::max<int64_t>({ int64_t(rc.top) - y, int64_t(y) - (rc.bottom - 1), 0 });
+        if (!best || dx * dx + dy * dy < best_distance)
+        {
+            best = &entry;
+            best_distance = dx * dx + dy * dy;
+        }
+    }
+    return best;
+}
+
+static bool Overlaps(const MonitorRect& a, const MonitorRect& b)
+{
+    return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+}
+
+// Attaches each monitor to a side of an earlier one, flush or with a gap, so
+// layouts have shared edges, gaps, and negative coordinates.
+static void MakeLayout(TestRandom& random, size_t count, std::vector<MonitorEntry>& entries)
+{
+    static const int32_t c_sizes[][2] = { { 1920, 1080 }, { 2560, 1440 }, { 1280, 1024 }, { 3840, 2160 }, { 1080, 1920 } };
+
+    entries.clear();
+    for (int32_t tries = 0; entries.size() < count && tries < 1000; ++tries)
+    {
+        const auto& size = c_sizes[random.Next() % 5];
+        MonitorEntry entry;
+        entry.dpi = 96 + 24 * (random.Next() % 5);
+        entry.handle = reinterpret_cast<void*>(uintptr_t(entries.size() + 1));
+
+        MonitorRect& rc = entry.monitor;
+        if (entries.empty())
+        {
+            rc.right = size[0];
+            rc.bottom = size[1];
+        }
+        else
+        {
+            const MonitorRect& next_to = entries[random.Next() % entries.size()].monitor;
+            const int32_t gap = (random.Next() % 3) ? 0 : random.Range(1, 300);
+            // Often line up the other edges too, like a typical row of monitors.
+            const bool aligned = (random.Next() & 1);
+            const int32_t top = aligned ? next_to.top : random.Range(next_to.top - size[1] + 1, next_to.bottom - 1);
+            const int32_t left = aligned ? next_to.left : random.Range(next_to.left - size[0] + 1, next_to.right - 1);
+            switch (random.Next() % 4)
+            {
+            case 0: rc.left = next_to.right + gap; rc.top = top; break;
+            case 1: rc.left = next_to.left - gap - size[0]; rc.top = top; break;
+            case 2: rc.top = next_to.bottom + gap; rc.left = left; break;
+            case 3: rc.top = next_to.top - gap - size[1]; rc.left = left; break;
+            }
+            rc.right = rc.left + size[0];
+            rc.bottom = rc.top + size[1];
+        }
+
+        bool overlaps = false;
+        for (const auto& other : entries)
+            overlaps |= Overlaps(rc, other.monitor);
+        if (overlaps)
+            continue;
+
+        entry.work = rc;
+        entry.work.bottom -= 40;
+        entries.push_back(entry);
+    }
+}
+
+static void CheckPoint(const MonitorTable& table, const std::vector<MonitorEntry>& entries, int32_t x, int32_t y, unsigned& mismatches)
+{
+    for (const bool nearest : { false, true })
+    {
+        const MonitorEntry* const found = table.FromPoint(x, y, nearest);
+        const MonitorEntry* const expected = FromPointReference(entries, x, y, nearest);
+        if (!found != !expected || (found && found->handle != expected->handle))
+            ++mismatches;
+    }
+}
+
+TEST(MonitorTableFromPoint)
+{
+    TestRandom random(1);
+    unsigned layouts = 0;
+    unsigned mismatches = 0;
+    for (size_t count = 1; count <= 6; ++count)
+    {
+        for (int32_t trial = 0; trial < 50; ++trial)
+        {
+            std::vector<MonitorEntry> entries;
+            MakeLayout(random, count, entries);
+            ++layouts;
+
+            MonitorTable table;
+            for (const auto& entry : entries)
+                table.Add(entry);
+            table.Build();
+            CHECK(table.GetCount() == entries.size());
+
+            MonitorRect bounds = entries[0].monitor;
+            for (const auto& entry : entries)
+            {
+                bounds.left = std::min(bounds.left, entry.monitor.left);
+                bounds.top = std::min(bounds.top, entry.monitor.top);
+                bounds.right = std::max(bounds.right, entry.monitor.right);
+                bounds.bottom = std::max(bounds.bottom, entry.monitor.bottom);
+            }
+
+            // Every corner and edge, on and just off each side:  these include
+            // the shared edges between adjacent monitors.
+            for (const auto& entry : entries)
+            {
+                const MonitorRect& rc = entry.monitor;
+                const int32_t xs[] = { rc.left - 1, rc.left, rc.left + 1, (rc.left + rc.right) / 2, rc.right - 1, rc.right, rc.right + 1 };
+                const int32_t ys[] = { rc.top - 1, rc.top, rc.top + 1, (rc.top + rc.bottom) / 2, rc.bottom - 1, rc.bottom, rc.bottom + 1 };
+                for (const int32_t x : xs)
+                {
+                    for (const int32_t y : ys)
+                        CheckPoint(table, entries, x, y, mismatches);
+                }
+            }
+
+            // Random points in and around the layout, sometimes in runs of
+            // nearby points, as when following the mouse.
+            for (int32_t ii = 0; ii < 2000; ++ii)
+            {
+                int32_t x = random.Range(bounds.left - 2000, bounds.right + 2000);
+                int32_t y = random.Range(bounds.top - 2000, bounds.bottom + 2000);
+                const int32_t run = (random.Next() % 4) ? 1 : 20;
+                for (int32_t jj = 0; jj < run; ++jj)
+                {
+                    CheckPoint(table, entries, x, y, mismatches);
+                    x += random.Range(-40, 40);
+                    y += random.Range(-40, 40);
+                }
+            }
+        }
+    }
+    CHECK(layouts == 300);
+    CHECK(mismatches == 0);
+}
+
+TEST(MonitorTableEmptyAndExtremes)
+{
+    MonitorTable table;
+    table.Build();
+    CHECK(table.IsEmpty());
+    CHECK(!table.FromPoint(0, 0, true));
+
+    // Far away points still find the nearest monitor without overflowing.
+    MonitorEntry entry;
+    entry.monitor = { -1920, -1080, 0, 0 };
+    entry.work = entry.monitor;
+    table.Add(entry);
+    table.Build();
+    CHECK(table.FromPoint(-1, -1, false) == &table.GetEntry(0));
+    CHECK(!table.FromPoint(0, 0, false));
+    CHECK(table.FromPoint(1000000000, 1000000000, true) == &table.GetEntry(0));
+    CHECK(table.FromPoint(-1000000000, -1000000000, true) == &table.GetEntry(0));
+}
+
+TEST(MonitorTableMirrored)
+{
+    // Overlapping monitors (e.g. mirrored):  any containing monitor is right,
+    // and the last hit cache mustn't return one that doesn't contain the point.
+    MonitorTable table;
+    MonitorEntry entry;
+    entry.monitor = { 0, 0, 1920, 1080 };
+    table.Add(entry);
+    entry.monitor = { 0, 0, 1280, 1024 };
+    table.Add(entry);
+    entry.monitor = { 1920, 0, 3840, 1080 };
+    table.Add(entry);
+    table.Build();
+
+    const int32_t points[][2] = { { 10, 10 }, { 1500, 1050 }, { 2000, 10 }, { 100, 1000 }, { 1919, 1079 }, { 1920, 1079 } };
+    for (const auto& pt : points)
+    {
+        const MonitorEntry* const found = table.FromPoint(pt[0], pt[1], false);
+        CHECK(found && found->monitor.Contains(pt[0], pt[1]));
+    }
+}
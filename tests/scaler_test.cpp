@@ -0,0 +1,159 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <string.h>
+#include <vector>
+
+#include "../scaler.h"
+#include "../threadpool.h"
+#include "test.h"
+
+//------------------------------------------------------------------------------
+// ScaleTiled is checked against ScaleReference for a range of factors,
+// gridline settings, diff styles, and subpixel orders.  The pool has a fixed
+// number of threads, so bands are split across threads even on a machine with
+// a single core.
+
+static void RandomPixels(TestRandom& random, std::vector<uint32_t>& pixels)
+{
+    for (uint32_t& p : pixels)
+        p = (random.Next() << 8) ^ random.Next();
+}
+
+TEST(ScalerMatchesReference)
+{
+    const int32_t c_cx = 293;
+    const int32_t c_cy = 331;
+
+    TestRandom random(1);
+    std::vector<uint32_t> source(c_cx * c_cy);
+    RandomPixels(random, source);
+
+    // A baseline with scattered differences, some only in the unused high byte.
+    std::vector<uint32_t> baseline(source);
+    for (size_t ii = 0; ii < baseline.size(); ii += 4099)
+        baseline[ii] ^= 0x010000 << (ii % 3 * 4);
+
+    ThreadPool pool(4);
+    std::vector<uint32_t> tiled(c_cx * c_cy);
+    std::vector<uint32_t> reference(c_cx * c_cy);
+
+    unsigned mismatches = 0;
+    for (int32_t factor = 1; factor <= 16; ++factor)
+    {
+        for (int32_t minor = 0; minor <= 2; ++minor)
+        {
+            for (int32_t major = 0; major <= 8; major += 4)
+            {
+                // Each diff mode (none, heatmap, highlight) with each subpixel order.
+                for (int32_t mode = 0; mode < 3 * SO_COUNT; ++mode)
+                {
+                    // Leave part of the target uncovered by the source.
+                    PixelSource src;
+                    src.bits = source.data();
+                    src.stride = c_cx;
+                    src.cx = c_cx / factor - 1;
+                    src.cy = c_cy / factor - 1;
+
+                    PixelTarget dst;
+                    dst.stride = c_cx;
+                    dst.cx = c_cx;
+                    dst.cy = c_cy;
+
+                    ScaleParams params;
+                    params.factor = factor;
+                    params.gridline_color = 0x123456;
+                    params.subpixels = SubpixelOrder(mode / 3);
+                    SetGridlines(params, minor, major);
+
+                    DiffResult tiled_diff;
+                    DiffResult reference_diff;
+                    DiffParams diff;
+                    diff.baseline = src;
+                    diff.baseline.bits = baseline.data();
+                    diff.style = (mode % 3 == 1) ? DS_HEATMAP : DS_HIGHLIGHT;
+                    if (mode % 3)
+                        params.diff = &diff;
+
+                    dst.bits = tiled.data();
+                    diff.result = &tiled_diff;
+                    ScaleTiled(&pool, src, dst, params);
+                    dst.bits = reference.data();
+                    diff.result = &reference_diff;
+                    ScaleReference(src, dst, params);
+
+                    if (tiled != reference || memcmp(&tiled_diff, &reference_diff, sizeof(tiled_diff)))
+                        ++mismatches;
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(ScalerDiffImage)
+{
+    // The difference image the scaler fills in for labels matches DiffImage.
+    const int32_t cx = 211;
+    const int32_t cy = 97;
+
+    TestRandom random(2);
+    std::vector<uint32_t> source(cx * cy);
+    RandomPixels(random, source);
+    std::vector<uint32_t> baseline(source);
+    for (size_t ii = 0; ii < baseline.size(); ii += 37)
+        baseline[ii] ^= 0x000100 << (ii % 3 * 8);
+
+    PixelSource src;
+    src.bits = source.data();
+    src.stride = src.cx = cx;
+    src.cy = cy;
+
+    ThreadPool pool(4);
+    unsigned mismatches = 0;
+    for (const DiffStyle style : { DS_HEATMAP, DS_HIGHLIGHT })
+    {
+        for (const int32_t factor : { 1, 3, 16 })
+        {
+            DiffParams diff;
+            diff.baseline = src;
+            diff.baseline.bits = baseline.data();
+            diff.style = style;
+
+            DiffResult expected_result;
+            std::vector<uint32_t> expected(cx * cy);
+            PixelTarget image;
+            image.bits = expected.data();
+            image.stride = image.cx = cx;
+            image.cy = cy;
+            DiffImage(src, diff, image, expected_result);
+
+            std::vector<uint32_t> scaled(size_t(cx) * factor * cy * factor);
+            PixelTarget dst;
+            dst.bits = scaled.data();
+            dst.stride = dst.cx = cx * factor;
+            dst.cy = cy * factor;
+
+            ScaleParams params;
+            params.factor = factor;
+            params.diff = &diff;
+
+            std::vector<uint32_t> tiled(cx * cy);
+            std::vector<uint32_t> reference(cx * cy);
+            DiffResult result;
+            diff.result = &result;
+            diff.image = image;
+
+            diff.image.bits = tiled.data();
+            ScaleTiled(&pool, src, dst, params);
+            if (tiled != expected || memcmp(&result, &expected_result, sizeof(result)))
+                ++mismatches;
+
+            diff.image.bits = reference.data();
+            ScaleReference(src, dst, params);
+            if (reference != expected || memcmp(&result, &expected_result, sizeof(result)))
+                ++mismatches;
+        }
+    }
+    CHECK(mismatches == 0);
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <string.h>
+#include <vector>
+
+#include "../search.h"
+#include "../threadpool.h"
+#include "test.h"
+
+//------------------------------------------------------------------------------
+// FindTemplate is checked against FindTemplateReference, with and without a
+// pool, on small images with few colors so there are many partial matches.
+
+TEST(SearchMatchesReference)
+{
+    TestRandom random(1);
+    ThreadPool pool(4);
+    unsigned mismatches = 0;
+    for (unsigned trial = 0; trial < 300; ++trial)
+    {
+        const int32_t cx = random.Range(50, 349);
+        const int32_t cy = random.Range(30, 229);
+        const uint32_t colors = random.Range(1, 4);
+        std::vector<uint32_t> haystack(cx * cy);
+        for (auto& pixel : haystack)
+            pixel = (random.Next() % colors) * 0x01030507u;
+
+        // Cut the template out of the haystack, and perturb it slightly when
+        // testing approximate matches.
+        const uint8_t tolerance = (trial % 3 == 0) ? 0 : (trial % 3 == 1) ? 3 : 20;
+        const int32_t ncx = random.Range(1, 8);
+        const int32_t ncy = random.Range(1, 8);
+        const int32_t nx = random.Range(0, cx - ncx);
+        const int32_t ny = random.Range(0, cy - ncy);
+        std::vector<uint32_t> needle(ncx * ncy);
+        for (int32_t yy = 0; yy < ncy; ++yy)
+        {
+            for (int32_t xx = 0; xx < ncx; ++xx)
+                needle[yy * ncx + xx] = haystack[(ny + yy) * cx + nx + xx] + (tolerance ? (random.Next() & 1) * 0x010101 : 0);
+        }
+
+        PixelSource src;
+        src.bits = haystack.data();
+        src.stride = src.cx = cx;
+        src.cy = cy;
+        PixelSource tmpl;
+        tmpl.bits = needle.data();
+        tmpl.stride = tmpl.cx = ncx;
+        tmpl.cy = ncy;
+
+        std::vector<SearchMatch> fast;
+        std::vector<SearchMatch> reference;
+        const size_t max_matches = random.Range(1, 500);
+        FindTemplate((trial & 1) ? &pool : nullptr, src, tmpl, tolerance, max_matches, fast);
+        FindTemplateReference(src, tmpl, tolerance, max_matches, reference);
+        if (fast.size() != reference.size() ||
+            (!fast.empty() && memcmp(fast.data(), reference.data(), fast.size() * sizeof(fast[0]))))
+            ++mismatches;
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST(SearchFindsTemplate)
+{
+    // A unique template is found exactly once, where it was cut from.
+    const int32_t cx = 640;
+    const int32_t cy = 360;
+    std::vector<uint32_t> haystack(cx * cy);
+    for (size_t ii = 0; ii < haystack.size(); ++ii)
+        haystack[ii] = uint32_t(ii * 2654435761u) >> 8;
+    std::vector<uint32_t> needle(16 * 16);
+    for (int32_t yy = 0; yy < 16; ++yy)
+        memcpy(&needle[yy * 16], &haystack[(200 + yy) * cx + 500], 16 * sizeof(uint32_t));
+
+    PixelSource src;
+    src.bits = haystack.data();
+    src.stride = src.cx = cx;
+    src.cy = cy;
+    PixelSource tmpl;
+    tmpl.bits = needle.data();
+    tmpl.stride = tmpl.cx = 16;
+    tmpl.cy = 16;
+
+    ThreadPool pool(4);
+    std::vector<SearchMatch> matches;
+    FindTemplate(&pool, src, tmpl, 0, 1000, matches);
+    CHECK(matches.size() == 1);
+    CHECK(!matches.empty() && matches[0].x == 500 && matches[0].y == 200);
+}
@@ -0,0 +1,261 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <stdio.h>
+#include <stdint.h>
+#include <wchar.h>
+#include <string>
+#include <vector>
+
+#include "../settings.h"
+#include "test.h"
+
+//------------------------------------------------------------------------------
+// MemorySettingsBackend keeps the stored values in memory, and records what
+// each Save is given.
+
+struct MemoryStore
+{
+    std::vector<SettingsEntry> stored;
+    std::vector<std::wstring> saved_dirty;  // Dirty names in the last Save.
+    unsigned        saves = 0;
+};
+
+class MemorySettingsBackend : public SettingsBackend
+{
+public:
+    explicit        MemorySettingsBackend(MemoryStore& store) : m_store(store) {}
+
+    bool Load(std::vector<SettingsEntry>& entries) override
+    {
+        entries.insert(entries.end(), m_store.stored.begin(), m_store.stored.end());
+        return true;
+    }
+
+    bool Save(const std::vector<SettingsEntry>& entries) override
+    {
+        ++m_store.saves;
+        m_store.saved_dirty.clear();
+        for (const auto& entry : entries)
+        {
+            if (entry.dirty)
+            {
+                m_store.saved_dirty.push_back(entry.name);
+                bool found = false;
+                for (auto& stored : m_store.stored)
+                {
+                    if (stored.name == entry.name)
+                    {
+                        stored.value = entry.value;
+                        found = true;
+                    }
+                }
+                if (!found)
+                    m_store.stored.push_back(entry);
+            }
+        }
+        return true;
+    }
+
+private:
+    MemoryStore&    m_store;
+};
+
+static SettingsEntry MakeEntry(const wchar_t* name, int32_t value)
+{
+    SettingsEntry entry;
+    entry.name = name;
+    entry.value = value;
+    return entry;
+}
+
+static std::unique_ptr<SettingsBackend> MakeMemoryBackend(MemoryStore& store)
+{
+    return std::unique_ptr<SettingsBackend>(new MemorySettingsBackend(store));
+}
+
+// A scratch file in the current directory, removed when done.
+class ScratchFile
+{
+public:
+                    ScratchFile(const wchar_t* wide, const char* narrow) : m_wide(wide), m_narrow(narrow) { remove(m_narrow); }
+                    ~ScratchFile() { remove(m_narrow); }
+    const wchar_t*  Path() const { return m_wide; }
+    const char*     NarrowPath() const { return m_narrow; }
+
+private:
+    const wchar_t*  m_wide;
+    const char*     m_narrow;
+};
+
+//------------------------------------------------------------------------------
+// Tests.
+
+TEST(SettingsDefaults)
+{
+    MemoryStore store;
+    store.stored.push_back(MakeEntry(L"Zoom", 8));
+
+    Settings settings(MakeMemoryBackend(store));
+    CHECK(settings.Load());
+    CHECK(settings.GetLong(L"Zoom", 4) == 8);
+    CHECK(settings.GetLong(L"Missing", 42) == 42);
+    CHECK(settings.GetLong(L"Missing", -1) == -1);
+    CHECK(settings.GetLong(L"zoom", 3) == 3);   // Names are case sensitive.
+    CHECK(!settings.IsDirty());
+
+    // Without a backend, everything is a default.
+    Settings none(nullptr);
+    CHECK(!none.Load());
+    CHECK(none.GetLong(L"Zoom", 4) == 4);
+}
+
+TEST(SettingsDuplicatesLastWins)
+{
+    MemoryStore store;
+    store.stored.push_back(MakeEntry(L"B", 1));
+    store.stored.push_back(MakeEntry(L"A", 1));
+    store.stored.push_back(MakeEntry(L"B", 2));
+    store.stored.push_back(MakeEntry(L"C", 5));
+    store.stored.push_back(MakeEntry(L"B", 3));
+    store.stored.push_back(MakeEntry(L"A", 7));
+
+    Settings settings(MakeMemoryBackend(store));
+    CHECK(settings.Load());
+    CHECK(settings.GetLong(L"A", 0) == 7);
+    CHECK(settings.GetLong(L"B", 0) == 3);
+    CHECK(settings.GetLong(L"C", 0) == 5);
+    CHECK(!settings.IsDirty());
+}
+
+TEST(SettingsSavesOnlyDirty)
+{
+    MemoryStore store;
+    store.stored.push_back(MakeEntry(L"A", 1));
+    store.stored.push_back(MakeEntry(L"B", 2));
+    store.stored.push_back(MakeEntry(L"C", 3));
+
+    Settings settings(MakeMemoryBackend(store));
+    CHECK(settings.Load());
+
+    // Nothing changed, so nothing is saved.
+    CHECK(settings.Save());
+    CHECK(store.saves == 0);
+
+    // Setting an unchanged value doesn't make it dirty.
+    settings.SetLong(L"A", 1);
+    CHECK(!settings.IsDirty());
+    CHECK(settings.Save());
+    CHECK(store.saves == 0);
+
+    // Only the changed and new values are dirty.
+    settings.SetLong(L"B", 20);
+    settings.SetLong(L"D", 4);
+    CHECK(settings.IsDirty());
+    CHECK(settings.GetLong(L"B", 0) == 20);
+    CHECK(settings.GetLong(L"D", 0) == 4);
+    CHECK(settings.Save());
+    CHECK(store.saves == 1);
+    CHECK(store.saved_dirty.size() == 2 && store.saved_dirty[0] == L"B" && store.saved_dirty[1] == L"D");
+    CHECK(!settings.IsDirty());
+
+    // Saving again writes nothing.
+    CHECK(settings.Save());
+    CHECK(store.saves == 1);
+
+    // A fresh load sees the saved values.
+    Settings reloaded(MakeMemoryBackend(store));
+    CHECK(reloaded.Load());
+    CHECK(reloaded.GetLong(L"A", 0) == 1);
+    CHECK(reloaded.GetLong(L"B", 0) == 20);
+    CHECK(reloaded.GetLong(L"C", 0) == 3);
+    CHECK(reloaded.GetLong(L"D", 0) == 4);
+}
+
+TEST(SettingsFileRoundTrip)
+{
+    ScratchFile scratch(L"settings_test.tmp", "settings_test.tmp");
+
+    // Loading a missing file fails, and leaves the defaults.
+    {
+        Settings settings(std::unique_ptr<SettingsBackend>(new FileSettingsBackend(scratch.Path())));
+        CHECK(!settings.Load());
+        CHECK(settings.GetLong(L"Zoom", 4) == 4);
+    }
+
+    const int32_t values[] = { 0, 1, -1, 123456, INT32_MAX, INT32_MIN };
+    const wchar_t* const names[] = { L"Zero", L"One", L"MinusOne", L"Big", L"Max", L"Min" };
+    {
+        Settings settings(std::unique_ptr<SettingsBackend>(new FileSettingsBackend(scratch.Path())));
+        for (size_t ii = 0; ii < sizeof(values) / sizeof(values[0]); ++ii)
+            settings.SetLong(names[ii], values[ii]);
+        CHECK(settings.Save());
+    }
+    {
+        Settings settings(std::unique_ptr<SettingsBackend>(new FileSettingsBackend(scratch.Path())));
+        CHECK(settings.Load());
+        for (size_t ii = 0; ii < sizeof(values) / sizeof(values[0]); ++ii)
+            CHECK(settings.GetLong(names[ii], 42) == values[ii]);
+        CHECK(settings.GetLong(L"Missing", 42) == 42);
+    }
+
+    // Malformed lines are skipped, CRLF line endings are accepted, and the
+    // last of duplicate names wins.
+    {
+        FILE* const file = fopen(scratch.NarrowPath(), "wb");
+        CHECK(file);
+        if (file)
+        {
+            fputs("A=1\r\n=5\nNoEquals\nB=x\nC=3junk\nD=\nA=2\n", file);
+            fclose(file);
+        }
+        Settings settings(std::unique_ptr<SettingsBackend>(new FileSettingsBackend(scratch.Path())));
+        CHECK(settings.Load());
+        CHECK(settings.GetLong(L"A", 0) == 2);
+        CHECK(settings.GetLong(L"B", 42) == 42);
+        CHECK(settings.GetLong(L"C", 42) == 42);
+        CHECK(settings.GetLong(L"D", 42) == 42);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Benchmarks.
+
+BENCH(SettingsLoadSave)
+{
+    const unsigned c_count = 64;
+    const unsigned c_iterations = 1000;
+
+    std::vector<std::wstring> names;
+    for (unsigned ii = 0; ii < c_count; ++ii)
+        names.push_back(L"Setting" + std::to_wstring(ii));
+
+    auto run = [&](std::unique_ptr<SettingsBackend> (*make)(void*), void* context)
+    {
+        const double start = GetTestSeconds();
+        for (unsigned iter = 0; iter < c_iterations; ++iter)
+        {
+            Settings settings(make(context));
+            settings.Load();
+            for (const auto& name : names)
+                settings.SetLong(name.c_str(), settings.GetLong(name.c_str(), 0) + 1);
+            settings.Save();
+        }
+        return (GetTestSeconds() - start) * 1000000 / c_iterations;
+    };
+
+    MemoryStore store;
+    const double memory = run([](void* context)
+    {
+        return MakeMemoryBackend(*static_cast<MemoryStore*>(context));
+    }, &store);
+    CHECK(store.saves == c_iterations);
+
+    ScratchFile scratch(L"settings_bench.tmp", "settings_bench.tmp");
+    const double file = run([](void* context)
+    {
+        return std::unique_ptr<SettingsBackend>(new FileSettingsBackend(static_cast<const wchar_t*>(context)));
+    }, const_cast<wchar_t*>(scratch.Path()));
+
+    printf("  Load and save %u values:  memory %.1f us, file %.1f us.\n", c_count, memory, file);
+}
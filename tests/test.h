@@ -0,0 +1,48 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+// A minimal harness for testing the modules that have no dependencies on
+// Windows, so they can be built and tested on any platform.
+//
+// TEST(name) defines a test, and CHECK(expr) reports a failure and continues.
+// BENCH(name) defines a benchmark, which only runs with --bench.
+
+typedef void (*TestFunc)();
+
+struct TestRegistration
+{
+    TestRegistration(const char* name, TestFunc func, bool bench);
+};
+
+void ReportFailure(const char* file, int line, const char* expr);
+
+// Deterministic pseudo random numbers, so failures are reproducible.
+class TestRandom
+{
+public:
+    explicit        TestRandom(uint32_t seed) : m_seed(seed) {}
+    uint32_t        Next() { m_seed = m_seed * 1664525 + 1013904223; return m_seed >> 8; }
+    int32_t         Range(int32_t lo, int32_t hi) { return lo + int32_t(Next() % uint32_t(hi - lo + 1)); }
+
+private:
+    uint32_t        m_seed;
+};
+
+// Seconds on a monotonic clock, for benchmarks.
+double GetTestSeconds();
+
+#define TEST_FUNC_(name, bench) \
+    static void name(); \
+    static const TestRegistration s_register_##name(#name, name, bench); \
+    static void name()
+
+#define TEST(name)      TEST_FUNC_(name, false)
+#define BENCH(name)     TEST_FUNC_(name, true)
+
+#define CHECK(expr) \
+    do { if (!(expr)) ReportFailure(__FILE__, __LINE__, #expr); } while (false)
@@ -0,0 +1,138 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <assert.h>
+#include <stdint.h>
+#include <algorithm>
+
+#include "threadpool.h"
+
+constexpr unsigned c_max_shared_threads = 16;
+
+ThreadPool::ThreadPool(unsigned threads)
+: m_count(std::max<unsigned>(threads, 1))
+, m_slots(new Slot[std::max<unsigned>(threads, 1)])
+{
+    for (unsigned ii = 0; ii < m_count; ++ii)
+    {
+        m_slots[ii].next = 0;
+        m_slots[ii].end = 0;
+    }
+
+    // Slot 0 belongs to the calling thread.
+    m_threads.reserve(m_count - 1);
+    for (unsigned ii = 1; ii < m_count; ++ii)
+        m_threads.emplace_back(&ThreadPool::WorkerProc, this, ii);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+ThreadPool* ThreadPool::GetShared()
+{
+    // Intentionally leaked:  joining threads from a static destructor during
+    // process exit can deadlock.
+    static ThreadPool* s_pool = nullptr;
+    if (!s_pool)
+    {
+        const unsigned cores = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+        s_pool = new ThreadPool(std::min<unsigned>(cores, c_max_shared_threads));
+    }
+    return s_pool;
+}
+
+void ThreadPool::Run(unsigned count, const std::function<void(unsigned index)>& func, unsigned max_threads)
+{
+    if (!count)
+        return;
+
+    unsigned participants = std::min<unsigned>(m_count, count);
+    if (max_threads)
+        participants = std::min<unsigned>(participants, max_threads);
+
+    if (participants <= 1)
+    {
+        for (unsigned ii = 0; ii < count; ++ii)
+            func(ii);
+        return;
+    }
+
+    for (unsigned ii = 0; ii < m_count; ++ii)
+    {
+        const bool participating = (ii < participants);
+        m_slots[ii].next = participating ? unsigned(uint64_t(count) * ii / participants) : 0;
+        m_slots[ii].end = participating ? unsigned(uint64_t(count) * (ii + 1) / participants) : 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_func = &func;
+        m_participants = participants;
+        m_pending = participants - 1;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    ProcessSlots(0);
+
+    // Wait for the workers to finish; they hold a pointer to func.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this](){ return !m_pending; });
+    m_func = nullptr;
+}
+
+void ThreadPool::WorkerProc(unsigned slot)
+{
+    unsigned generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&](){ return m_exit || m_generation != generation; });
+            if (m_exit)
+                return;
+            generation = m_generation;
+            if (slot >= m_participants)
+                continue;
+        }
+
+        ProcessSlots(slot);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            assert(m_pending);
+            if (!--m_pending)
+                m_done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::ProcessSlots(unsigned slot)
+{
+    const std::function<void(unsigned)>& func = *m_func;
+    const unsigned participants = m_participants;
+
+    // Drain our own range first, then steal from the others, starting with
+    // our neighbor so that thieves spread out across the ranges.
+    for (unsigned jj = 0; jj < participants; ++jj)
+    {
+        Slot& victim = m_slots[(slot + jj) % participants];
+        while (true)
+        {
+            const unsigned index = victim.next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= victim.end)
+                break;
+            func(index);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// ThreadPool is a small persistent pool for splitting a job into a number of
+// independent work items (e.g. horizontal bands of an image).
+//
+// Each participating thread starts with a contiguous range of items, and when
+// its own range is exhausted it steals items from the other ranges.  The
+// calling thread participates too, so a pool with N threads has N-1 workers.
+
+class ThreadPool
+{
+public:
+    explicit        ThreadPool(unsigned threads);
+                    ~ThreadPool();
+
+    unsigned        GetThreadCount() const { return m_count; }
+    void            Run(unsigned count, const std::function<void(unsigned index)>& func, unsigned max_threads=0);
+
+    static ThreadPool* GetShared();
+
+private:
+    struct Slot
+    {
+        std::atomic<unsigned> next;
+        unsigned    end;
+        char        pad[64 - sizeof(std::atomic<unsigned>) - sizeof(unsigned)];
+    };
+
+    void            WorkerProc(unsigned slot);
+    void            ProcessSlots(unsigned slot);
+
+    const unsigned  m_count;
+    std::vector<std::thread> m_threads;
+    std::unique_ptr<Slot[]> m_slots;
+
+    std::mutex      m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    unsigned        m_generation = 0;
+    unsigned        m_participants = 0;
+    unsigned        m_pending = 0;
+    bool            m_exit = false;
+    const std::function<void(unsigned)>* m_func = nullptr;
+};
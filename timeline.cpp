@@ -0,0 +1,149 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#include <assert.h>
+#include <math.h>
+#include <algorithm>
+
+#include "timeline.h"
+#include "labels.h"
+
+//------------------------------------------------------------------------------
+// SampleRing.
+
+SampleRing::SampleRing(uint32_t capacity)
+: m_mask(capacity - 1)
+, m_samples(new TimelineSample[capacity])
+{
+    assert(capacity && !(capacity & (capacity - 1)));
+    m_head.value = 0;
+    m_tail.value = 0;
+    m_dropped = 0;
+}
+
+bool SampleRing::Push(const TimelineSample& sample)
+{
+    const uint32_t head = m_head.value.load(std::memory_order_relaxed);
+    if (head - m_tail.value.load(std::memory_order_acquire) > m_mask)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    m_samples[head & m_mask] = sample;
+    m_head.value.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool SampleRing::Pop(TimelineSample& sample)
+{
+    const uint32_t tail = m_tail.value.load(std::memory_order_relaxed);
+    if (tail == m_head.value.load(std::memory_order_acquire))
+        return false;
+
+    sample = m_samples[tail & m_mask];
+    m_tail.value.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// TimelinePlot.
+
+void TimelinePlot::Reset(int32_t probes, int32_t columns, double window_seconds)
+{
+    m_probes = std::min<int32_t>(std::max<int32_t>(probes, 0), c_max_probes);
+    m_columns.assign(std::max<int32_t>(columns, 1), TimelineColumn());
+    m_column_seconds = window_seconds / m_columns.size();
+    m_newest = -1;
+    m_samples = 0;
+    m_first_seconds = -1;
+    m_newest_seconds = 0;
+    m_now_seconds = 0;
+    for (auto& latest : m_latest)
+        latest = 0;
+}
+
+void TimelinePlot::ScrollTo(int64_t column)
+{
+    if (column <= m_newest)
+        return;
+
+    // Clear the columns that scrolled in; at most all of them.
+    const int64_t count = int64_t(m_columns.size());
+    const int64_t first = std::max<int64_t>(m_newest + 1, column - count + 1);
+    for (int64_t ii = first; ii <= column; ++ii)
+    {
+        TimelineColumn& slot = m_columns[size_t(ii % count)];
+        m_samples -= slot.count;
+        slot = TimelineColumn();
+    }
+    m_newest = column;
+}
+
+void TimelinePlot::Add(const TimelineSample& sample)
+{
+    if (!m_probes || sample.seconds < 0)
+        return;
+
+    const int64_t column = int64_t(floor(sample.seconds / m_column_seconds));
+    const int64_t count = int64_t(m_columns.size());
+    if (m_newest >= 0 && column <= m_newest - count)
+        return;
+    ScrollTo(column);
+
+    uint8_t luminance[c_max_probes];
+    ComputeLuminance(sample.values, m_probes, luminance);
+
+    TimelineColumn& slot = m_columns[size_t(column % count)];
+    for (int32_t probe = 0; probe < m_probes; ++probe)
+    {
+        if (!slot.count)
+        {
+            slot.min[probe] = luminance[probe];
+            slot.max[probe] = luminance[probe];
+        }
+        else
+        {
+            slot.min[probe] = std::min<uint8_t>(slot.min[probe], luminance[probe]);
+            slot.max[probe] = std::max<uint8_t>(slot.max[probe], luminance[probe]);
+        }
+    }
+    ++slot.count;
+    ++m_samples;
+
+    if (sample.seconds >= m_newest_seconds)
+    {
+        m_newest_seconds = sample.seconds;
+        for (int32_t probe = 0; probe < m_probes; ++probe)
+            m_latest[probe] = sample.values[probe];
+    }
+    if (m_first_seconds < 0)
+        m_first_seconds = sample.seconds;
+    m_now_seconds = std::max<double>(m_now_seconds, sample.seconds);
+}
+
+void TimelinePlot::Advance(double now)
+{
+    if (m_newest >= 0 && now >= 0)
+    {
+        ScrollTo(int64_t(floor(now / m_column_seconds)));
+        m_now_seconds = std::max<double>(m_now_seconds, now);
+    }
+}
+
+const TimelineColumn& TimelinePlot::GetColumn(int32_t index) const
+{
+    const int64_t count = int64_t(m_columns.size());
+    const int64_t column = std::max<int64_t>(m_newest, count - 1) - (count - 1) + index;
+    return m_columns[size_t(column % count)];
+}
+
+double TimelinePlot::GetRate() const
+{
+    if (m_first_seconds < 0)
+        return 0;
+
+    const double window = m_column_seconds * m_columns.size();
+    const double span = std::min<double>(window, m_now_seconds - m_first_seconds);
+    return (span > 0) ? m_samples / span : 0;
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Pixel timeline.
+//
+// A sampler thread reads a few probe pixels at a high rate and pushes
+// timestamped samples into a SampleRing, which is lock-free for one producer
+// and one consumer.  The UI drains the ring into a TimelinePlot, which keeps
+// the min and max luminance of each probe per plot column.  Adding a sample
+// only touches one column, and drawing only visits the columns, so the cost
+// of plotting doesn't depend on the sample rate.
+
+constexpr int32_t c_max_probes = 4;
+
+struct TimelineSample
+{
+    double          seconds = 0;
+    uint32_t        values[c_max_probes];   // 0x00RRGGBB.
+};
+
+class SampleRing
+{
+public:
+    // Capacity must be a power of two.
+    explicit        SampleRing(uint32_t capacity);
+
+    // Producer.  Returns false (and counts the sample as dropped) if full.
+    bool            Push(const TimelineSample& sample);
+    // Consumer.
+    bool            Pop(TimelineSample& sample);
+    uint32_t        GetDropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    // The indices are on separate cache lines, so the producer and consumer
+    // don't contend for them.
+    struct Index
+    {
+        std::atomic<uint32_t> value;
+        char        pad[64 - sizeof(std::atomic<uint32_t>)];
+    };
+
+    const uint32_t  m_mask;
+    std::unique_ptr<TimelineSample[]> m_samples;
+    Index           m_head;             // Next to push; written by the producer.
+    Index           m_tail;             // Next to pop; written by the consumer.
+    std::atomic<uint32_t> m_dropped;
+};
+
+struct TimelineColumn
+{
+    uint8_t         min[c_max_probes];
+    uint8_t         max[c_max_probes];
+    uint32_t        count;              // Samples in the column; 0 if none.
+};
+
+class TimelinePlot
+{
+public:
+    // Starts over with columns spanning the window.
+    void            Reset(int32_t probes, int32_t columns, double window_seconds);
+
+    void            Add(const TimelineSample& sample);
+    // Scrolls to now, so the plot moves even when no samples arrive.
+    void            Advance(double now);
+
+    int32_t         GetProbeCount() const { return m_probes; }
+    int32_t         GetColumnCount() const { return int32_t(m_columns.size()); }
+    // Oldest first.
+    const TimelineColumn& GetColumn(int32_t index) const;
+    uint32_t        GetLatest(int32_t probe) const { return m_latest[probe]; }
+    // Samples per second over the window.
+    double          GetRate() const;
+
+private:
+    void            ScrollTo(int64_t column);
+
+    int32_t         m_probes = 0;
+    double          m_column_seconds = 1;
+    int64_t         m_newest = -1;      // Absolute index of the newest column.
+    std::vector<TimelineColumn> m_columns;
+    uint32_t        m_latest[c_max_probes] = {};
+    uint64_t        m_samples = 0;      // In the window.
+    double          m_first_seconds = -1;
+    double          m_newest_seconds = 0;
+    double          m_now_seconds = 0;
+};
@@ -0,0 +1,399 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <windowsx.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "timelinepane.h"
+#include "dib.h"
+#include "perf.h"
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION   0x00000002
+#endif
+
+static const WCHAR c_wndclass_name[] = TEXT("ZoominTimelinePane");
+static const WCHAR c_font[] = L"Consolas";
+constexpr LONG c_pane_height = 120;     // 96 DPI.
+constexpr LONG c_padding = 4;           // 96 DPI.
+constexpr LONG c_font_height = 12;      // 96 DPI.
+constexpr UINT_PTR c_drain_timer_id = 1;
+constexpr UINT c_drain_interval = 33;   // Milliseconds.
+constexpr LONGLONG c_sample_interval = 10000; // 100ns units; 1 ms.
+constexpr uint32_t c_ring_capacity = 8192;
+constexpr double c_window_seconds = 4;
+
+static const COLORREF c_probe_colors[c_max_probes] =
+{
+    RGB(220, 0, 0),
+    RGB(0, 160, 0),
+    RGB(0, 0, 220),
+    RGB(220, 140, 0),
+};
+
+TimelinePane::TimelinePane()
+: m_ring(c_ring_capacity)
+{
+}
+
+TimelinePane::~TimelinePane()
+{
+    Destroy();
+}
+
+bool TimelinePane::Create(HINSTANCE hinst, HWND hwndParent)
+{
+    if (m_hwnd)
+        return true;
+
+    WNDCLASS wc = {};
+    if (!GetClassInfo(hinst, c_wndclass_name, &wc))
+    {
+        wc.lpfnWndProc = WndProc;
+        wc.hInstance = hinst;
+        wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+        wc.hbrBackground = HBRUSH(GetStockObject(NULL_BRUSH));
+        wc.lpszClassName = c_wndclass_name;
+        if (!RegisterClass(&wc))
+            return false;
+    }
+
+    m_exit = CreateEvent(nullptr, true, false, nullptr);
+    if (!m_exit)
+        return false;
+
+    m_dpi = __GetDpiForWindow(hwndParent);
+    m_hwnd = CreateWindow(c_wndclass_name, TEXT(""), WS_CHILD|WS_CLIPSIBLINGS,
+                          0, 0, 0, 0, hwndParent, NULL, hinst, this);
+    if (!m_hwnd)
+        return false;
+
+    UpdateFont();
+    return true;
+}
+
+void TimelinePane::Destroy()
+{
+    StopSampler();
+
+    if (m_hwnd)
+    {
+        DestroyWindow(m_hwnd);
+        m_hwnd = NULL;
+    }
+    if (m_hfont)
+    {
+        DeleteObject(m_hfont);
+        m_hfont = NULL;
+    }
+    if (m_exit)
+    {
+        CloseHandle(m_exit);
+        m_exit = NULL;
+    }
+}
+
+void TimelinePane::Show(bool show)
+{
+    m_shown = show;
+    if (!m_hwnd)
+        return;
+
+    ShowWindow(m_hwnd, show ? SW_SHOWNA : SW_HIDE);
+    if (show)
+    {
+        ResetPlot();
+        StartSampler();
+        SetTimer(m_hwnd, c_drain_timer_id, c_drain_interval, nullptr);
+    }
+    else
+    {
+        KillTimer(m_hwnd, c_drain_timer_id);
+        StopSampler();
+    }
+}
+
+LONG TimelinePane::GetHeight() const
+{
+    return (m_hwnd && m_shown) ? m_dpi.Scale(c_pane_height) : 0;
+}
+
+void TimelinePane::SetRect(const RECT& rc)
+{
+    if (!m_hwnd)
+        return;
+
+    RECT rcOld;
+    GetWindowRect(m_hwnd, &rcOld);
+    constexpr DWORD c_flags = SWP_NOACTIVATE|SWP_NOZORDER|SWP_NOOWNERZORDER;
+    SetWindowPos(m_hwnd, NULL, rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top, c_flags);
+
+    // The columns match the width, so a new width starts the plot over.
+    if (rcOld.right - rcOld.left != rc.right - rc.left)
+        ResetPlot();
+}
+
+void TimelinePane::OnDpiChanged(const DpiScaler& dpi)
+{
+    m_dpi.OnDpiChanged(dpi);
+    UpdateFont();
+    if (m_hwnd)
+        InvalidateRect(m_hwnd, nullptr, false);
+}
+
+bool TimelinePane::AddProbe(POINT pt)
+{
+    if (m_probes.size() >= c_max_probes)
+        return false;
+
+    StopSampler();
+    m_probes.push_back(pt);
+    ResetPlot();
+    if (m_shown)
+        StartSampler();
+    if (m_hwnd)
+        InvalidateRect(m_hwnd, nullptr, false);
+    return true;
+}
+
+void TimelinePane::ClearProbes()
+{
+    StopSampler();
+    m_probes.clear();
+    ResetPlot();
+    if (m_hwnd)
+        InvalidateRect(m_hwnd, nullptr, false);
+}
+
+LRESULT CALLBACK TimelinePane::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+    TimelinePane* const pane = reinterpret_cast<TimelinePane*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+
+    switch (msg)
+    {
+    case WM_NCCREATE:
+        SetWindowLongPtr(hwnd, GWLP_USERDATA, LONG_PTR(LPCREATESTRUCT(lParam)->lpCreateParams));
+        goto LDefault;
+
+    case WM_ERASEBKGND:
+        return true;
+    case WM_PAINT:
+        pane->OnPaint();
+        break;
+    case WM_SIZE:
+        InvalidateRect(hwnd, nullptr, false);
+        break;
+    case WM_TIMER:
+        if (wParam == c_drain_timer_id)
+            pane->OnTimer();
+        break;
+
+    default:
+LDefault:
+        return DefWindowProc(hwnd, msg, wParam, lParam);
+    }
+
+    return 0;
+}
+
+void TimelinePane::OnPaint()
+{
+    PAINTSTRUCT ps;
+    BeginPaint(m_hwnd, &ps);
+
+    RECT rc;
+    GetClientRect(m_hwnd, &rc);
+
+    // Draw offscreen so the plot doesn't flicker as it scrolls.
+    HDC hdc = CreateCompatibleDC(ps.hdc);
+    HBITMAP hbmp = hdc ? CreateCompatibleBitmap(ps.hdc, rc.right, rc.bottom) : NULL;
+    if (hdc && hbmp)
+    {
+        HBITMAP hbmpOld = SelectBitmap(hdc, hbmp);
+        Draw(hdc, rc);
+        BitBlt(ps.hdc, 0, 0, rc.right, rc.bottom, hdc, 0, 0, SRCCOPY);
+        SelectBitmap(hdc, hbmpOld);
+    }
+    else
+    {
+        Draw(ps.hdc, rc);
+    }
+
+    if (hbmp)
+        DeleteObject(hbmp);
+    if (hdc)
+        DeleteDC(hdc);
+
+    EndPaint(m_hwnd, &ps);
+}
+
+void TimelinePane::OnTimer()
+{
+    // Only the ring is shared with the sampler; the plot belongs to the UI.
+    TimelineSample sample;
+    while (m_ring.Pop(sample))
+        m_plot.Add(sample);
+    m_plot.Advance(GetPerfSeconds());
+    InvalidateRect(m_hwnd, nullptr, false);
+}
+
+void TimelinePane::Draw(HDC hdc, const RECT& rc)
+{
+    FillRect(hdc, &rc, GetSysColorBrush(COLOR_WINDOW));
+
+    // Separator along the top edge.
+    RECT rcLine = { rc.left, rc.top, rc.right, rc.top + 1 };
+    FillRect(hdc, &rcLine, GetSysColorBrush(COLOR_GRAYTEXT));
+
+    // One vertical min/max line per column per probe, so the cost depends on
+    // the width of the pane, not on the sample rate.
+    const LONG top = rc.top + 1 + m_dpi.Scale(c_padding);
+    const LONG bottom = rc.bottom - m_dpi.Scale(c_padding);
+    const int32_t columns = std::min<int32_t>(m_plot.GetColumnCount(), rc.right - rc.left);
+    if (bottom > top)
+    {
+        const LONG cy = bottom - top - 1;
+        for (int32_t probe = 0; probe < m_plot.GetProbeCount(); ++probe)
+        {
+            HPEN hpen = CreatePen(PS_SOLID, 1, c_probe_colors[probe]);
+            HPEN hpenOld = hpen ? SelectPen(hdc, hpen) : NULL;
+            for (int32_t index = 0; index < columns; ++index)
+            {
+                const TimelineColumn& column = m_plot.GetColumn(index);
+                if (!column.count)
+                    continue;
+                const LONG x = rc.left + index;
+                MoveToEx(hdc, x, bottom - 1 - column.max[probe] * cy / 255, nullptr);
+                LineTo(hdc, x, bottom - column.min[probe] * cy / 255);
+            }
+            if (hpen)
+            {
+                SelectPen(hdc, hpenOld);
+                DeleteObject(hpen);
+            }
+        }
+    }
+
+    SetBkMode(hdc, TRANSPARENT);
+    HFONT hfontOld = m_hfont ? SelectFont(hdc, m_hfont) : NULL;
+
+    TEXTMETRIC tm;
+    GetTextMetrics(hdc, &tm);
+    const LONG pad = m_dpi.Scale(c_padding);
+    LONG y = top;
+
+    WCHAR text[80];
+    if (m_probes.empty())
+    {
+        SetTextColor(hdc, GetSysColor(COLOR_GRAYTEXT));
+        swprintf(text, _countof(text), L"Press P to add the pixel under the mouse as a probe.");
+        TextOut(hdc, pad, y, text, int(wcslen(text)));
+    }
+    else
+    {
+        for (size_t ii = 0; ii < m_probes.size(); ++ii)
+        {
+            const uint32_t value = m_plot.GetLatest(int32_t(ii));
+            swprintf(text, _countof(text), L"(%d, %d)  #%06X", m_probes[ii].x, m_probes[ii].y, value & 0x00ffffff);
+            SetTextColor(hdc, c_probe_colors[ii]);
+            TextOut(hdc, pad, y, text, int(wcslen(text)));
+            y += tm.tmHeight;
+        }
+
+        swprintf(text, _countof(text), L"%.0f Hz  %u dropped", m_plot.GetRate(), m_ring.GetDropped() - m_dropped);
+        SIZE size;
+        GetTextExtentPoint32(hdc, text, int(wcslen(text)), &size);
+        SetTextColor(hdc, GetSysColor(COLOR_WINDOWTEXT));
+        TextOut(hdc, rc.right - pad - size.cx, top, text, int(wcslen(text)));
+    }
+
+    if (hfontOld)
+        SelectFont(hdc, hfontOld);
+}
+
+void TimelinePane::UpdateFont()
+{
+    if (m_hfont)
+        DeleteObject(m_hfont);
+    m_hfont = CreateFont(-m_dpi.Scale(c_font_height), 0, 0, 0, FW_NORMAL, false, false, false, DEFAULT_CHARSET,
+                         OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, CLEARTYPE_QUALITY, FIXED_PITCH|FF_MODERN, c_font);
+}
+
+void TimelinePane::ResetPlot()
+{
+    RECT rc = {};
+    if (m_hwnd)
+        GetClientRect(m_hwnd, &rc);
+    m_plot.Reset(int32_t(m_probes.size()), std::max<LONG>(rc.right - rc.left, 1), c_window_seconds);
+}
+
+void TimelinePane::StartSampler()
+{
+    if (m_thread.joinable() || m_probes.empty() || !m_exit)
+        return;
+
+    // Discard samples from the previous probes.
+    TimelineSample sample;
+    while (m_ring.Pop(sample))
+    {
+    }
+    m_dropped = m_ring.GetDropped();
+
+    ResetEvent(m_exit);
+    m_thread = std::thread(&TimelinePane::SamplerProc, this, m_probes);
+}
+
+void TimelinePane::StopSampler()
+{
+    if (!m_thread.joinable())
+        return;
+
+    SetEvent(m_exit);
+    m_thread.join();
+}
+
+// Reads only the probe pixels, one 1x1 blit each, so a sample costs about the
+// same as a screen read round trip no matter how large the zoom area is.
+void TimelinePane::SamplerProc(std::vector<POINT> probes)
+{
+    // Without a high resolution timer (before Windows 10 1803) the wait rounds
+    // up to the system timer resolution, which lowers the sample rate.
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer)
+        timer = CreateWaitableTimer(nullptr, false, nullptr);
+
+    const HDC hdcScreen = GetDC(NULL);
+    DibSection dib;
+    if (timer && hdcScreen && dib.EnsureSize(LONG(probes.size()), 1))
+    {
+        const HANDLE handles[] = { m_exit, timer };
+        LARGE_INTEGER due;
+        due.QuadPart = -c_sample_interval;
+
+        do
+        {
+            // Arm first, so the interval includes the time spent sampling.
+            SetWaitableTimer(timer, &due, 0, nullptr, nullptr, false);
+
+            const double start = GetPerfSeconds();
+            for (size_t ii = 0; ii < probes.size(); ++ii)
+                BitBlt(dib.GetDC(), int(ii), 0, 1, 1, hdcScreen, probes[ii].x, probes[ii].y, SRCCOPY);
+            GdiFlush();
+
+            TimelineSample sample;
+            sample.seconds = (start + GetPerfSeconds()) / 2;
+            for (size_t ii = 0; ii < probes.size(); ++ii)
+                sample.values[ii] = dib.GetBits()[ii] & 0x00ffffff;
+            m_ring.Push(sample);
+        }
+        while (WaitForMultipleObjects(_countof(handles), handles, false, INFINITE) == WAIT_OBJECT_0 + 1);
+    }
+
+    if (hdcScreen)
+        ReleaseDC(NULL, hdcScreen);
+    if (timer)
+        CloseHandle(timer);
+}
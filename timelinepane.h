@@ -0,0 +1,64 @@
+// Copyright (c) 2024 Christopher Antos
+// License: http://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <thread>
+#include <vector>
+
+#include "dpi.h"
+#include "timeline.h"
+
+//------------------------------------------------------------------------------
+// TimelinePane is a child window along the bottom of its parent that plots
+// the luminance of a few probe pixels over time.
+//
+// A dedicated thread reads only the probe pixels from the screen, paced by a
+// high resolution waitable timer, and pushes samples into a SampleRing.  The
+// pane drains the ring on a UI timer, so sampling continues at full rate no
+// matter how long painting takes.
+
+class TimelinePane
+{
+public:
+                    TimelinePane();
+                    ~TimelinePane();
+
+    bool            Create(HINSTANCE hinst, HWND hwndParent);
+    void            Destroy();
+
+    bool            IsShown() const { return m_shown; }
+    void            Show(bool show);
+    // Height of the pane when shown, or 0.
+    LONG            GetHeight() const;
+    void            SetRect(const RECT& rc);
+    void            OnDpiChanged(const DpiScaler& dpi);
+
+    // Probes are in screen coordinates.  Returns false if there are already
+    // c_max_probes.
+    bool            AddProbe(POINT pt);
+    void            ClearProbes();
+    size_t          GetProbeCount() const { return m_probes.size(); }
+
+private:
+    static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+    void            OnPaint();
+    void            OnTimer();
+    void            Draw(HDC hdc, const RECT& rc);
+    void            UpdateFont();
+    void            ResetPlot();
+    void            StartSampler();
+    void            StopSampler();
+    void            SamplerProc(std::vector<POINT> probes);
+
+    HWND            m_hwnd = NULL;
+    HFONT           m_hfont = NULL;
+    DpiScaler       m_dpi;
+    bool            m_shown = false;
+    std::vector<POINT> m_probes;
+    std::thread     m_thread;
+    HANDLE          m_exit = NULL;
+    SampleRing      m_ring;
+    TimelinePlot    m_plot;
+    uint32_t        m_dropped = 0;      // Dropped before the current sampler started.
+};